@@ -19,6 +19,9 @@ FINAL_RELEASE {
     }
 }
 
+# Uncomment next line if you want to count the heap allocations of each operation (see utils/allocationcounter.h)
+#CONFIG += COUNT_ALLOCATIONS
+
 # cg3lib works with c++11
 CONFIG += c++11
 
@@ -39,41 +42,20 @@ message($$MODULES)
 DISTFILES += \
     LICENSE
 
+# The core of the trapezoidal map (see trapezoidalmap_core.pri), then the viewer
+include (trapezoidalmap_core.pri)
+
 SOURCES +=  \
-    algorithms/OrientationUtility.cpp \
-    data_structures/dag.cpp \
-    data_structures/dagnode.cpp \
-    data_structures/orderedsegment.cpp \
-    data_structures/segment_intersection_checker.cpp \
-    data_structures/trapezoid.cpp \
-    data_structures/trapezoidalmap.cpp \
-    data_structures/trapezoidalmap_dataset.cpp \
     drawables/drawable_trapezoidalmap_dataset.cpp \
-    drawables/drawabletrapezoid.cpp \
+    drawables/drawabletrapezoid_gl.cpp \
     drawables/drawabletrapezoidalmap.cpp \
     main.cpp \
-    managers/trapezoidalmap_manager.cpp \
-    utils/fileutils.cpp
+    managers/trapezoidalmap_manager.cpp
 
 FORMS += \
     managers/trapezoidalmapmanager.ui
 
 HEADERS += \
-    algorithms/OrientationUtility.h \
-    data_structures/dag.h \
-    data_structures/dagnode.h \
-    data_structures/orderedsegment.h \
-    data_structures/segment_intersection_checker.h \
-    data_structures/trapezoid.h \
-    data_structures/trapezoidalmap.h \
-    data_structures/trapezoidalmap_dataset.h \
     drawables/drawable_trapezoidalmap_dataset.h \
-    drawables/drawabletrapezoid.h \
     drawables/drawabletrapezoidalmap.h \
-    managers/trapezoidalmap_manager.h \
-    utils/fileutils.h
-
-
-
-
-
+    managers/trapezoidalmap_manager.h
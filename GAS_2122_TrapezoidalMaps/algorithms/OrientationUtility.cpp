@@ -1,5 +1,7 @@
 #include "OrientationUtility.h"
 
+#include "cg3/geometry/utils2.h"
+
 namespace OrientationUtility {
     double det3(double m[3][3])
     {
@@ -34,4 +36,28 @@ namespace OrientationUtility {
             return above;
         return middle;
     }
+
+    bool isSegmentBelow(const OrderedSegment& a, const OrderedSegment& b) {
+        if(&a == &b)
+            return false;
+
+        /* The segment starting later (lexicographically, i.e. with the symbolic shear) is compared with the line through the other one
+         * (the x-ranges overlap, so it starts on that segment) */
+        if(a.getLeftmost() < b.getLeftmost()) {
+            if(cg3::isPointAtLeft(a.getLeftmost(), a.getRightmost(), b.getLeftmost()))
+                return true;
+            if(cg3::isPointAtRight(a.getLeftmost(), a.getRightmost(), b.getLeftmost()))
+                return false;
+            // b starts on a: its other endpoint decides
+            return cg3::isPointAtLeft(a.getLeftmost(), a.getRightmost(), b.getRightmost());
+        }
+        else {
+            if(cg3::isPointAtRight(b.getLeftmost(), b.getRightmost(), a.getLeftmost()))
+                return true;
+            if(cg3::isPointAtLeft(b.getLeftmost(), b.getRightmost(), a.getLeftmost()))
+                return false;
+            // a starts on b (e.g. they share the left endpoint): its other endpoint decides
+            return cg3::isPointAtRight(b.getLeftmost(), b.getRightmost(), a.getRightmost());
+        }
+    }
 }
@@ -10,5 +10,7 @@ enum Position {above, middle, below};
 namespace OrientationUtility {
     double det3(double m[3][3]);
     Position getPointPositionRespectToLine(const cg3::Point2d& p, const OrderedSegment& s);
+    // returns true if the segment a is below the segment b. Their x-ranges must overlap and they must not cross (e.g. the order of a sweep status).
+    bool isSegmentBelow(const OrderedSegment& a, const OrderedSegment& b);
 }
 #endif // ORIENTATIONUTILITY_H
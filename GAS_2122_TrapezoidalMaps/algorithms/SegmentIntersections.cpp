@@ -0,0 +1,529 @@
+#include "SegmentIntersections.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <queue>
+#include <set>
+
+#include "cg3/geometry/utils2.h"
+
+#include "OrientationUtility.h"
+#include "data_structures/orderedsegment.h"
+#include "data_structures/segment_intersection_checker.h"
+
+namespace SegmentIntersections {
+    namespace {
+        // a point where a segment has to be split: the position of the segment and the point
+        typedef std::pair<size_t, cg3::Point2d> Cut;
+
+        // 1 if p is above the line through s, -1 if it's below, 0 if it's on it
+        int side(const OrderedSegment& s, const cg3::Point2d& p) {
+            if(cg3::isPointAtLeft(s.getLeftmost(), s.getRightmost(), p))
+                return 1;
+            if(cg3::isPointAtRight(s.getLeftmost(), s.getRightmost(), p))
+                return -1;
+            return 0;
+        }
+
+        // true if p is strictly between the endpoints of s (lexicographically)
+        bool isInside(const OrderedSegment& s, const cg3::Point2d& p) {
+            return s.getLeftmost() < p && p < s.getRightmost();
+        }
+
+        // the cross product of the directions of two segments: positive if b turns left with respect to a
+        double turn(const OrderedSegment& a, const OrderedSegment& b) {
+            const cg3::Point2d u = a.getRightmost() - a.getLeftmost();
+            const cg3::Point2d v = b.getRightmost() - b.getLeftmost();
+            return u.x() * v.y() - u.y() * v.x();
+        }
+
+        /* The crossing point of the lines through two segments, rounded to the multiples of snapSize. If it's that close to an endpoint
+         * of the two segments, it's the endpoint: a segment passing (almost) through the end of another one is cut where the other one
+         * is cut */
+        cg3::Point2d crossingPoint(const OrderedSegment& a, const OrderedSegment& b, double snapSize) {
+            const cg3::Point2d u = a.getRightmost() - a.getLeftmost();
+            const cg3::Point2d v = b.getRightmost() - b.getLeftmost();
+            const cg3::Point2d w = b.getLeftmost() - a.getLeftmost();
+            const double t = (w.x() * v.y() - w.y() * v.x()) / turn(a, b);
+            const cg3::Point2d p = a.getLeftmost() + u * t;
+            for(const cg3::Point2d& endpoint : {a.getLeftmost(), a.getRightmost(), b.getLeftmost(), b.getRightmost()})
+                if(std::abs(p.x() - endpoint.x()) <= snapSize && std::abs(p.y() - endpoint.y()) <= snapSize)
+                    return endpoint;
+            return cg3::Point2d(std::round(p.x() / snapSize) * snapSize, std::round(p.y() / snapSize) * snapSize);
+        }
+
+        /* Sweeps the segments from left to right (Bentley-Ottmann) and appends to cuts the points where they have to be split.
+         * The status is a set whose elements are swapped in place at the crossings: two crossing segments are adjacent just
+         * before the crossing point, and after it they're in the opposite order, so the set stays sorted. The order is computed
+         * only when a segment is inserted, with the orientation tests of OrientationUtility::isSegmentBelow. */
+        void sweepCuts(const std::vector<OrderedSegment>& segments, double snapSize, std::vector<Cut>& cuts) {
+            // The endpoints sorted from left to right: at the same point, the segments ending there come first
+            struct Event {
+                const cg3::Point2d* point;
+                size_t segment;
+                bool isLeft;
+            };
+            std::vector<Event> events;
+            events.reserve(2 * segments.size());
+            for(size_t i = 0; i < segments.size(); i++) {
+                events.push_back({&segments[i].getLeftmost(), i, true});
+                events.push_back({&segments[i].getRightmost(), i, false});
+            }
+            std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+                if(*a.point != *b.point)
+                    return *a.point < *b.point;
+                return !a.isLeft && b.isLeft;
+            });
+
+            // The crossings still to be passed by the sweep line, from the leftmost one
+            struct Crossing {
+                cg3::Point2d point;
+                size_t lower;
+                size_t upper;
+            };
+            auto isAfter = [](const Crossing& a, const Crossing& b) { return b.point < a.point; };
+            std::priority_queue<Crossing, std::vector<Crossing>, decltype(isAfter)> crossings(isAfter);
+
+            // The status: the segments cut by the sweep line, from the bottom to the top. The comparator is only called to
+            // insert a segment, whose left endpoint is the current event
+            struct Entry {
+                mutable size_t segment;
+            };
+            size_t inserting = 0;
+            auto order = [&segments, &inserting](const Entry& a, const Entry& b) {
+                if(a.segment == inserting)
+                    return OrientationUtility::isSegmentBelow(segments[a.segment], segments[b.segment]);
+                return !OrientationUtility::isSegmentBelow(segments[b.segment], segments[a.segment]);
+            };
+            typedef std::set<Entry, decltype(order)> Status;
+            Status status(order);
+            std::vector<Status::iterator> position(segments.size(), status.end());
+
+            cg3::Point2d sweepPoint;
+
+            // the pairs (lower, upper) of segments that became adjacent in the status, still to be tested
+            std::vector<std::pair<size_t, size_t>> adjacent;
+
+            auto isAdjacent = [&](size_t lower, size_t upper) {
+                return position[lower] != status.end() && position[upper] != status.end() &&
+                        std::next(position[lower]) == position[upper];
+            };
+
+            // two adjacent segments cross: the upper one goes below the other one
+            auto swap = [&](size_t lower, size_t upper) {
+                std::swap(position[lower]->segment, position[upper]->segment);
+                std::swap(position[lower], position[upper]);
+                if(position[upper] != status.begin())
+                    adjacent.push_back(std::make_pair(std::prev(position[upper])->segment, upper));
+                if(std::next(position[lower]) != status.end())
+                    adjacent.push_back(std::make_pair(lower, std::next(position[lower])->segment));
+            };
+
+            // records the cuts of two adjacent segments, and schedules their crossing if they still have to swap
+            auto test = [&](size_t lower, size_t upper) {
+                const OrderedSegment& a = segments[lower];
+                const OrderedSegment& b = segments[upper];
+                const int bLeft = side(a, b.getLeftmost());
+                const int bRight = side(a, b.getRightmost());
+
+                // Collinear: each one is split where the other one ends
+                if(bLeft == 0 && bRight == 0) {
+                    for(const cg3::Point2d& p : {b.getLeftmost(), b.getRightmost()})
+                        if(isInside(a, p))
+                            cuts.push_back(Cut(lower, p));
+                    for(const cg3::Point2d& p : {a.getLeftmost(), a.getRightmost()})
+                        if(isInside(b, p))
+                            cuts.push_back(Cut(upper, p));
+                    return;
+                }
+
+                const int aLeft = side(b, a.getLeftmost());
+                const int aRight = side(b, a.getRightmost());
+
+                // Proper crossing: after it, the segment turning right is below. The turn is antisymmetric, so a pair never swaps back.
+                // Both segments are cut at the rounded point even if it isn't between their endpoints (lexicographically): the
+                // rounding can move it to the other side of the vertical line of a vertical segment, which is bent to pass through it
+                if(bLeft * bRight < 0 && aLeft * aRight < 0) {
+                    const cg3::Point2d p = crossingPoint(a, b, snapSize);
+                    if(p != a.getLeftmost() && p != a.getRightmost())
+                        cuts.push_back(Cut(lower, p));
+                    if(p != b.getLeftmost() && p != b.getRightmost())
+                        cuts.push_back(Cut(upper, p));
+                    if(turn(a, b) < 0) {
+                        // The rounding may move the crossing behind the sweep line: the swap can't wait
+                        if(sweepPoint < p)
+                            crossings.push({p, lower, upper});
+                        else
+                            swap(lower, upper);
+                    }
+                    return;
+                }
+
+                // An endpoint of one segment lies on the other one
+                if(bLeft == 0 && isInside(a, b.getLeftmost()))
+                    cuts.push_back(Cut(lower, b.getLeftmost()));
+                if(bRight == 0 && isInside(a, b.getRightmost()))
+                    cuts.push_back(Cut(lower, b.getRightmost()));
+                if(aLeft == 0 && isInside(b, a.getLeftmost()))
+                    cuts.push_back(Cut(upper, a.getLeftmost()));
+                if(aRight == 0 && isInside(b, a.getRightmost()))
+                    cuts.push_back(Cut(upper, a.getRightmost()));
+            };
+
+            /* Cuts the segments passing through the current event, an endpoint of s. They're next to s in the status, but not all of
+             * them are adjacent to a segment ending there: they're found walking from s, once for each point */
+            auto cutThrough = [&](size_t s) {
+                for(Status::iterator it = position[s]; it != status.begin(); ) {
+                    --it;
+                    if(side(segments[it->segment], sweepPoint) != 0)
+                        break;
+                    if(isInside(segments[it->segment], sweepPoint))
+                        cuts.push_back(Cut(it->segment, sweepPoint));
+                }
+                for(Status::iterator it = std::next(position[s]); it != status.end(); ++it) {
+                    if(side(segments[it->segment], sweepPoint) != 0)
+                        break;
+                    if(isInside(segments[it->segment], sweepPoint))
+                        cuts.push_back(Cut(it->segment, sweepPoint));
+                }
+            };
+
+            // tests the adjacent pairs: a swap makes other segments adjacent, so they're tested too
+            auto testAdjacent = [&]() {
+                while(!adjacent.empty()) {
+                    const std::pair<size_t, size_t> pair = adjacent.back();
+                    adjacent.pop_back();
+                    if(isAdjacent(pair.first, pair.second))
+                        test(pair.first, pair.second);
+                }
+            };
+
+            size_t next = 0;
+            while(next < events.size() || !crossings.empty()) {
+                // At the same point, the crossings are passed before the endpoints
+                if(!crossings.empty() && (next == events.size() || !(*events[next].point < crossings.top().point))) {
+                    const Crossing crossing = crossings.top();
+                    crossings.pop();
+                    sweepPoint = crossing.point;
+                    // the same crossing may be scheduled more than once: it's passed only if the pair is still in the old order
+                    if(isAdjacent(crossing.lower, crossing.upper)) {
+                        swap(crossing.lower, crossing.upper);
+                        testAdjacent();
+                    }
+                    continue;
+                }
+
+                const Event& event = events[next++];
+                const size_t s = event.segment;
+                const bool isFirstAtPoint = next == 1 || *events[next - 2].point != *event.point;
+                sweepPoint = *event.point;
+
+                if(!event.isLeft) {
+                    if(isFirstAtPoint)
+                        cutThrough(s);
+                    const Status::iterator it = position[s];
+                    if(it != status.begin() && std::next(it) != status.end())
+                        adjacent.push_back(std::make_pair(std::prev(it)->segment, std::next(it)->segment));
+                    status.erase(it);
+                    position[s] = status.end();
+                    testAdjacent();
+                    continue;
+                }
+
+                // The comparator never finds two equivalent segments (a collinear one goes above), so the insertion succeeds
+                inserting = s;
+                position[s] = status.insert(Entry{s}).first;
+                if(isFirstAtPoint)
+                    cutThrough(s);
+                if(position[s] != status.begin())
+                    adjacent.push_back(std::make_pair(std::prev(position[s])->segment, s));
+                if(std::next(position[s]) != status.end())
+                    adjacent.push_back(std::make_pair(s, std::next(position[s])->segment));
+                testAdjacent();
+            }
+        }
+
+        // Splits the pieces at the cuts (grouped by piece) and removes the duplicates, keeping the first origin. Returns true if a piece has been split
+        bool splitPieces(std::vector<cg3::Segment2d>& pieces, std::vector<size_t>& origins, const std::vector<Cut>& cuts) {
+            std::vector<std::pair<std::pair<cg3::Point2d, cg3::Point2d>, size_t>> split;
+            split.reserve(pieces.size() + cuts.size());
+            std::vector<Cut>::const_iterator cut = cuts.begin();
+            std::vector<std::pair<double, cg3::Point2d>> pieceCuts;
+            for(size_t i = 0; i < pieces.size(); i++) {
+                // The cuts of a piece are sorted along it: a rounded point can be out of the lexicographic order of a vertical piece
+                const cg3::Point2d direction = pieces[i].p2() - pieces[i].p1();
+                pieceCuts.clear();
+                for(; cut != cuts.end() && cut->first == i; ++cut) {
+                    const cg3::Point2d offset = cut->second - pieces[i].p1();
+                    pieceCuts.push_back(std::make_pair(offset.x() * direction.x() + offset.y() * direction.y(), cut->second));
+                }
+                std::sort(pieceCuts.begin(), pieceCuts.end());
+
+                cg3::Point2d start = pieces[i].p1();
+                for(const std::pair<double, cg3::Point2d>& pieceCut : pieceCuts) {
+                    if(pieceCut.second != start) {
+                        split.push_back(std::make_pair(std::make_pair(start, pieceCut.second), origins[i]));
+                        start = pieceCut.second;
+                    }
+                }
+                split.push_back(std::make_pair(std::make_pair(start, pieces[i].p2()), origins[i]));
+            }
+            const bool isSplit = split.size() > pieces.size();
+
+            std::sort(split.begin(), split.end());
+            pieces.clear();
+            origins.clear();
+            for(size_t j = 0; j < split.size(); j++) {
+                if(j == 0 || split[j].first != split[j-1].first) {
+                    pieces.push_back(cg3::Segment2d(split[j].first.first, split[j].first.second));
+                    origins.push_back(split[j].second);
+                }
+            }
+            return isSplit;
+        }
+
+        /* Decides the segments at the given positions (sorted) in the order of the list: each one is discarded if it intersects
+         * one kept before it, as adding the segments one at a time. The pairs are found again */
+        void decideInOrder(const std::vector<cg3::Segment2d>& segments, const std::vector<size_t>& positions, std::vector<bool>& discarded, std::vector<IntersectingPair>& pairs) {
+            // the segments kept so far, with their positions, and the segment hit by each discarded one
+            SegmentIntersectionChecker keptChecker;
+            std::vector<std::pair<std::pair<cg3::Point2d, cg3::Point2d>, size_t>> keptPositions;
+            std::vector<std::pair<std::pair<cg3::Point2d, cg3::Point2d>, size_t>> hits;
+            for(size_t i : positions) {
+                cg3::Segment2d hit;
+                discarded[i] = keptChecker.findIntersection(segments[i], hit);
+                if(discarded[i])
+                    hits.push_back(std::make_pair(std::make_pair(hit.p1(), hit.p2()), i));
+                else {
+                    keptChecker.insert(segments[i]);
+                    keptPositions.push_back(std::make_pair(std::make_pair(segments[i].p1(), segments[i].p2()), i));
+                }
+            }
+
+            // the position of each segment hit, searched among the kept ones sorted by endpoints (the segments are distinct)
+            std::sort(keptPositions.begin(), keptPositions.end());
+            pairs.clear();
+            for(const std::pair<std::pair<cg3::Point2d, cg3::Point2d>, size_t>& hit : hits) {
+                const auto kept = std::lower_bound(keptPositions.begin(), keptPositions.end(), std::make_pair(hit.first, size_t(0)));
+                assert(kept != keptPositions.end() && kept->first == hit.first);
+                pairs.push_back(std::make_pair(kept->second, hit.second));
+            }
+        }
+
+        /* The sweep discards the later segment of each pair it finds, even if the earlier one is discarded afterwards: adding the
+         * segments one at a time would keep it. The segments involved in an intersection are the discarded ones and the kept ones
+         * hitting them (the kept ones don't intersect each other), the others don't intersect any segment: the involved ones are
+         * decided again in the order of the list, each one against the ones kept before it */
+        void decideInvolvedInOrder(const std::vector<cg3::Segment2d>& segments, std::vector<bool>& discarded, std::vector<IntersectingPair>& pairs) {
+            std::vector<size_t> involved;
+            std::vector<cg3::Segment2d> discardedSegments;
+            std::vector<cg3::Segment2d> keptSegments;
+            std::vector<size_t> keptPositions;
+            for(size_t i = 0; i < segments.size(); i++) {
+                if(discarded[i]) {
+                    involved.push_back(i);
+                    discardedSegments.push_back(segments[i]);
+                }
+                else {
+                    keptSegments.push_back(segments[i]);
+                    keptPositions.push_back(i);
+                }
+            }
+            SegmentIntersectionChecker discardedChecker;
+            discardedChecker.insert(discardedSegments);
+            for(size_t k : discardedChecker.findIntersecting(keptSegments))
+                involved.push_back(keptPositions[k]);
+            std::sort(involved.begin(), involved.end());
+            decideInOrder(segments, involved, discarded, pairs);
+        }
+    }
+
+    bool discardIntersecting(const std::vector<cg3::Segment2d>& segments, std::vector<bool>& discarded, std::vector<IntersectingPair>& pairs) {
+        discarded.assign(segments.size(), false);
+        pairs.clear();
+
+        std::vector<OrderedSegment> ordered;
+        ordered.reserve(segments.size());
+        for(size_t i = 0; i < segments.size(); i++)
+            ordered.push_back(OrderedSegment(segments[i], i));
+
+        // The endpoints sorted from left to right: at the same point, the segments ending there come first
+        struct Event {
+            const cg3::Point2d* point;
+            size_t segment;
+            bool isLeft;
+        };
+        std::vector<Event> events;
+        events.reserve(2 * segments.size());
+        for(size_t i = 0; i < ordered.size(); i++) {
+            events.push_back({&ordered[i].getLeftmost(), i, true});
+            events.push_back({&ordered[i].getRightmost(), i, false});
+        }
+        std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+            if(*a.point != *b.point)
+                return *a.point < *b.point;
+            return !a.isLeft && b.isLeft;
+        });
+
+        // The status: the segments cut by the sweep line, from the bottom to the top
+        auto order = [&ordered](size_t a, size_t b) { return OrientationUtility::isSegmentBelow(ordered[a], ordered[b]); };
+        typedef std::set<size_t, decltype(order)> Status;
+        Status status(order);
+        std::vector<Status::iterator> position(segments.size(), status.end());
+
+        // the pairs of segments that became adjacent in the status, still to be tested
+        std::vector<IntersectingPair> adjacent;
+
+        // removes a segment from the status: its two neighbors become adjacent
+        auto remove = [&](size_t s) {
+            const Status::iterator it = position[s];
+            const Status::iterator next = std::next(it);
+            if(it != status.begin() && next != status.end())
+                adjacent.push_back(std::make_pair(*std::prev(it), *next));
+            status.erase(it);
+            position[s] = status.end();
+        };
+
+        // keeps the first segment and discards the second one (if it's in the status, it's removed)
+        auto discard = [&](size_t kept, size_t s) {
+            discarded[s] = true;
+            pairs.push_back(std::make_pair(kept, s));
+            if(position[s] != status.end())
+                remove(s);
+        };
+
+        // tests the adjacent pairs: a segment discarded makes other segments adjacent, so they're tested too
+        auto testAdjacent = [&]() {
+            while(!adjacent.empty()) {
+                const IntersectingPair pair = adjacent.back();
+                adjacent.pop_back();
+                if(discarded[pair.first] || discarded[pair.second])
+                    continue;
+                if(SegmentIntersectionChecker::checkSegmentIntersection(segments[pair.first], segments[pair.second]))
+                    discard(std::min(pair.first, pair.second), std::max(pair.first, pair.second));
+            }
+        };
+
+        /* Each discarded segment costs a check of the involved ones (see decideInvolvedInOrder): when the sweep has discarded many of the
+         * segments started, deciding all the segments in order (as adding them one at a time) is faster, so the sweep gives up */
+        size_t started = 0;
+        for(const Event& event : events) {
+            if(started >= MIN_SWEPT_SEGMENTS && pairs.size() > MAX_SWEPT_DISCARDED_FRACTION * started) {
+                std::vector<size_t> all(segments.size());
+                for(size_t i = 0; i < all.size(); i++)
+                    all[i] = i;
+                decideInOrder(segments, all, discarded, pairs);
+                return pairs.empty();
+            }
+
+            const size_t s = event.segment;
+            started += event.isLeft;
+            if(discarded[s])
+                continue;
+
+            if(!event.isLeft) {
+                remove(s);
+                testAdjacent();
+                continue;
+            }
+
+            // A segment equivalent to s in the order overlaps it: one of them is discarded
+            std::pair<Status::iterator, bool> inserted = status.insert(s);
+            while(!inserted.second) {
+                const size_t other = *inserted.first;
+                if(other < s) {
+                    discard(other, s);
+                    break;
+                }
+                discard(s, other);
+                inserted = status.insert(s);
+            }
+            if(discarded[s])
+                continue;
+
+            position[s] = inserted.first;
+            if(inserted.first != status.begin())
+                adjacent.push_back(std::make_pair(*std::prev(inserted.first), s));
+            if(std::next(inserted.first) != status.end())
+                adjacent.push_back(std::make_pair(s, *std::next(inserted.first)));
+            testAdjacent();
+        }
+
+        if(!pairs.empty())
+            decideInvolvedInOrder(segments, discarded, pairs);
+        return pairs.empty();
+    }
+
+    bool nodeSegments(
+            const std::vector<cg3::Segment2d>& segments,
+            std::vector<cg3::Segment2d>& pieces,
+            std::vector<size_t>& origins,
+            std::vector<cg3::Point2d>& intersectionPoints,
+            double snapSize)
+    {
+        pieces.clear();
+        origins.clear();
+        intersectionPoints.clear();
+
+        double maxCoordinate = 0;
+        for(size_t i = 0; i < segments.size(); i++) {
+            if(segments[i].p1() == segments[i].p2())
+                continue;
+            const OrderedSegment ordered(segments[i], i);
+            pieces.push_back(cg3::Segment2d(ordered.getLeftmost(), ordered.getRightmost()));
+            origins.push_back(i);
+            for(const cg3::Point2d& p : {ordered.getLeftmost(), ordered.getRightmost()})
+                maxCoordinate = std::max(maxCoordinate, std::max(std::abs(p.x()), std::abs(p.y())));
+        }
+
+        if(snapSize <= 0) {
+            int exponent;
+            std::frexp(std::max(maxCoordinate, 1.0), &exponent);
+            snapSize = std::ldexp(1.0, exponent - SNAP_BITS);
+        }
+
+        // The duplicates are removed before the first sweep
+        splitPieces(pieces, origins, std::vector<Cut>());
+
+        std::vector<bool> discarded;
+        std::vector<IntersectingPair> pairs;
+        bool isValid = false;
+        for(size_t round = 1; !isValid; round++) {
+            std::vector<OrderedSegment> ordered;
+            ordered.reserve(pieces.size());
+            for(size_t i = 0; i < pieces.size(); i++)
+                ordered.push_back(OrderedSegment(pieces[i], i));
+
+            std::vector<Cut> cuts;
+            sweepCuts(ordered, snapSize, cuts);
+            std::sort(cuts.begin(), cuts.end());
+            for(const Cut& cut : cuts)
+                intersectionPoints.push_back(cut.second);
+
+            const bool isSplit = splitPieces(pieces, origins, cuts);
+            isValid = discardIntersecting(pieces, discarded, pairs);
+            if(!isSplit || round == MAX_NODING_ROUNDS)
+                break;
+        }
+
+        // The pieces still intersecting (a rounding the sweeps couldn't fix) are discarded
+        if(!isValid) {
+            size_t kept = 0;
+            for(size_t i = 0; i < pieces.size(); i++) {
+                if(!discarded[i]) {
+                    pieces[kept] = pieces[i];
+                    origins[kept] = origins[i];
+                    kept++;
+                }
+            }
+            pieces.resize(kept);
+            origins.resize(kept);
+        }
+
+        std::sort(intersectionPoints.begin(), intersectionPoints.end());
+        intersectionPoints.erase(std::unique(intersectionPoints.begin(), intersectionPoints.end()), intersectionPoints.end());
+        return isValid;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef SEGMENTINTERSECTIONS_H
+#define SEGMENTINTERSECTIONS_H
+
+#include <utility>
+#include <vector>
+
+#include "cg3/geometry/segment2.h"
+
+namespace SegmentIntersections {
+    // a pair of intersecting segments: the positions of the one kept and of the one discarded
+    typedef std::pair<size_t, size_t> IntersectingPair;
+
+    /**
+     * @brief discardIntersecting   sweeps the segments from left to right (Shamos-Hoey) in O(n log n): only the segments adjacent
+     *                              in the sweep status are tested, since the leftmost intersection is between two of them.
+     *                              When two segments intersect, the one with the highest position is discarded and the sweep goes on,
+     *                              so the segments kept never intersect each other. The segments involved in an intersection are then
+     *                              decided again in the order of the list (with an AABB tree of the ones kept), so the result is the
+     *                              same of adding the segments one at a time: a segment is discarded if and only if it intersects
+     *                              one kept before it. Sharing an endpoint is not an intersection, unless the two segments overlap.
+     *                              The points are compared lexicographically (see OrderedSegment).
+     *                              Deciding the involved segments again is the slow part when many segments intersect: once the sweep
+     *                              has discarded more than MAX_SWEPT_DISCARDED_FRACTION of the segments started, it stops and all the
+     *                              segments are decided in order. So the check is O(n log n) when few segments intersect, and when many
+     *                              do it costs as much as adding them one at a time plus the sorting of the endpoints.
+     * @param segments              the segments (non-degenerate and without duplicates). If the first ones are known not to intersect
+     *                              each other (e.g. they're already in a dataset), they're never discarded.
+     * @param [out] discarded       discarded[i] is true if the i-th segment has been discarded.
+     * @param [out] pairs           for each discarded segment, the pair found by the sweep, sorted by the position of the discarded one.
+     * @return                      true if no segment has been discarded.
+     */
+    // the sweep of discardIntersecting gives up when it has discarded more than this fraction of the segments started (at least MIN_SWEPT_SEGMENTS)
+    const double MAX_SWEPT_DISCARDED_FRACTION = 0.4;
+    const size_t MIN_SWEPT_SEGMENTS = 1024;
+
+    bool discardIntersecting(const std::vector<cg3::Segment2d>& segments, std::vector<bool>& discarded, std::vector<IntersectingPair>& pairs);
+
+    // the number of rounds of nodeSegments: the first one splits the segments, the next ones only the crossings made by the snapping
+    const size_t MAX_NODING_ROUNDS = 4;
+    // the default snapping grid has a step 2^-SNAP_BITS times the largest coordinate
+    const int SNAP_BITS = 40;
+
+    /**
+     * @brief nodeSegments              splits the segments at their intersection points, so that they don't cross each other anymore.
+     *                                  The intersections are found with a Bentley-Ottmann sweep in O((n + k) log n) time, where k is the
+     *                                  number of intersections: only the segments adjacent in the sweep status are tested, and two crossing
+     *                                  segments swap their places in the status at the crossing point.
+     *                                  A segment is split where another one crosses it, where an endpoint of another one lies on it, and
+     *                                  where a collinear one overlapping it ends. The crossing points are rounded to the multiples of the
+     *                                  snapping step (a power of two, so the rounding is exact): the same point computed from different
+     *                                  pairs of segments is always the same, and the pieces meeting there share their endpoint.
+     *                                  Rounding may bend a piece across a segment close to the crossing point: the pieces are swept again
+     *                                  (at most MAX_NODING_ROUNDS times) until the check of the dataset (discardIntersecting) finds no
+     *                                  intersection. The pieces still intersecting after the last round are discarded.
+     * @param segments                  the segments. The degenerate ones are ignored.
+     * @param [out] pieces              the pieces, with ordered endpoints (see OrderedSegment) and without duplicates: they may share an
+     *                                  endpoint, but they don't cross nor overlap each other.
+     * @param [out] origins             origins[i] is the position of the segment pieces[i] comes from (the first one, for overlapping segments).
+     * @param [out] intersectionPoints  the points where the segments have been split, sorted and without duplicates.
+     * @param snapSize                  the snapping step. If it's 0, it's chosen from the largest coordinate (see SNAP_BITS).
+     * @return                          true if no piece has been discarded.
+     */
+    bool nodeSegments(
+            const std::vector<cg3::Segment2d>& segments,
+            std::vector<cg3::Segment2d>& pieces,
+            std::vector<size_t>& origins,
+            std::vector<cg3::Point2d>& intersectionPoints,
+            double snapSize = 0);
+}
+
+#endif // SEGMENTINTERSECTIONS_H
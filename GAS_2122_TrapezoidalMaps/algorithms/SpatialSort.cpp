@@ -0,0 +1,46 @@
+#include "SpatialSort.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace SpatialSort {
+    namespace {
+        // quantise a coordinate in [min, max] to a 32-bit integer
+        uint32_t quantise(double value, double min, double max) {
+            if(max <= min)
+                return 0;
+            const double normalized = std::min(1.0, std::max(0.0, (value - min) / (max - min)));
+            return static_cast<uint32_t>(normalized * 4294967295.0);
+        }
+
+        // spread the 32 bits of a value in the even bits of a 64-bit integer
+        uint64_t spreadBits(uint32_t value) {
+            uint64_t x = value;
+            x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+            x = (x | (x << 8))  & 0x00FF00FF00FF00FFull;
+            x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0Full;
+            x = (x | (x << 2))  & 0x3333333333333333ull;
+            x = (x | (x << 1))  & 0x5555555555555555ull;
+            return x;
+        }
+    }
+
+    uint64_t mortonKey(const cg3::Point2d& p, const cg3::BoundingBox2& B) {
+        const uint32_t qx = quantise(p.x(), B.min().x(), B.max().x());
+        const uint32_t qy = quantise(p.y(), B.min().y(), B.max().y());
+        return spreadBits(qx) | (spreadBits(qy) << 1);
+    }
+
+    void sortByMortonKey(const std::vector<cg3::Point2d>& points, const cg3::BoundingBox2& B, std::vector<size_t>& order) {
+        // pairs (key, position): sorting them keeps the position of each point
+        std::vector<std::pair<uint64_t, size_t>> keys(points.size());
+        for(size_t i = 0; i < points.size(); i++)
+            keys[i] = std::make_pair(mortonKey(points[i], B), i);
+
+        std::sort(keys.begin(), keys.end());
+
+        order.resize(points.size());
+        for(size_t i = 0; i < keys.size(); i++)
+            order[i] = keys[i].second;
+    }
+}
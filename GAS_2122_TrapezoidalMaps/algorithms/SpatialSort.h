@@ -0,0 +1,29 @@
+#ifndef SPATIALSORT_H
+#define SPATIALSORT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "cg3/geometry/point2.h"
+#include "cg3/geometry/bounding_box2.h"
+
+namespace SpatialSort {
+    /**
+     * @brief mortonKey     computes the Morton (Z-order) key of a point: the bits of its quantised coordinates are interleaved,
+     *                      so points close in the plane usually have close keys.
+     * @param p             the point.
+     * @param B             the bounding box used to quantise the coordinates (the points outside are clamped on its boundary).
+     * @return              the 64-bit key (32 bits for each coordinate).
+     */
+    uint64_t mortonKey(const cg3::Point2d& p, const cg3::BoundingBox2& B);
+
+    /**
+     * @brief sortByMortonKey   computes the order of a list of points along the Morton curve. The points are not moved.
+     * @param points            the points to sort.
+     * @param B                 the bounding box used to quantise the coordinates.
+     * @param [out] order       the positions of the points in the list, sorted by Morton key.
+     */
+    void sortByMortonKey(const std::vector<cg3::Point2d>& points, const cg3::BoundingBox2& B, std::vector<size_t>& order);
+}
+
+#endif // SPATIALSORT_H
@@ -0,0 +1,24 @@
+# Headless benchmark of the trapezoidal map: it builds the map from dataset files and times the queries.
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= qt app_bundle
+
+# Release configuration
+CONFIG(release, debug|release){
+    QMAKE_CXXFLAGS_RELEASE -= -O2
+    QMAKE_CXXFLAGS += -O3 -DNDEBUG
+}
+
+# Uncomment next line if you want to count the heap allocations of each operation (see utils/allocationcounter.h): the benchmark
+# then checks that the insertions into a warmed-up map allocate only the objects they create, and fails otherwise
+#CONFIG += COUNT_ALLOCATIONS
+
+# Only the core of cg3lib is needed
+CONFIG += CG3_CORE
+include (../cg3lib/cg3.pri)
+
+# The core of the trapezoidal map (no Qt, no OpenGL)
+include (../trapezoidalmap_core.pri)
+
+SOURCES += \
+    main.cpp
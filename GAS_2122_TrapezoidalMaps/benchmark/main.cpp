@@ -0,0 +1,788 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "data_structures/compactlocator.h"
+#include "data_structures/dagnode.h"
+#include "data_structures/gridindex.h"
+#include "data_structures/persistentslablocator.h"
+#include "data_structures/segment_intersection_checker.h"
+#include "data_structures/slabtrapezoidalmap.h"
+#include "data_structures/sweeptrapezoidalmap.h"
+#include "data_structures/trapezoidalmap.h"
+#include "data_structures/trapezoidalmap_dataset.h"
+#include "algorithms/SegmentIntersections.h"
+#include "utils/allocationcounter.h"
+#include "utils/fileutils.h"
+#include "utils/segmentgenerator.h"
+#include "utils/workloadgenerator.h"
+
+// Same bounding box used by the manager of the application
+#define BOUNDINGBOX 1e+6
+
+// Number of random queries used when it is not specified
+#define DEFAULT_N_QUERIES 1000000
+
+// Number of threads of the concurrent insertion: fixed, so that the insertion is concurrent even on a single core
+#define CONCURRENT_THREADS 8
+
+// Number of slabs of the parallel construction: fixed for the same reason (a single slab would be a plain map)
+#define SLABS 8
+
+// Cells per side of the grid of nested polygons, and maximum number of queries checked against them
+#define POLYGON_CELLS 10
+#define POLYGON_QUERIES 100000
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// returns the milliseconds elapsed since the given instant
+double elapsedMilliseconds(const Clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// generates uniformly distributed points inside the bounding box
+std::vector<cg3::Point2d> generateQueries(size_t n, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> distribution(-BOUNDINGBOX, BOUNDINGBOX);
+
+    std::vector<cg3::Point2d> queries(n);
+    for(cg3::Point2d& q : queries)
+        q = cg3::Point2d(distribution(generator), distribution(generator));
+    return queries;
+}
+
+/**
+ * @brief timeQueries       locates the query points with a point locator.
+ * @param locator           the point locator.
+ * @param queries           the query points.
+ * @param [out] checksum    the results are added to it (so the compiler doesn't remove the queries, and two locators can be compared).
+ * @return                  the milliseconds elapsed.
+ */
+double timeQueries(const PointLocator& locator, const std::vector<cg3::Point2d>& queries, size_t& checksum) {
+    const Clock::time_point start = Clock::now();
+    for(const cg3::Point2d& q : queries)
+        checksum += reinterpret_cast<size_t>(locator.pointLocation(q)) >> 4;
+    return elapsedMilliseconds(start);
+}
+
+// returns the number of faces of a map (the ones split by an insertion are not counted)
+size_t liveTrapezoidNumber(const TrapezoidalMap& map) {
+    size_t n = 0;
+    for(const DrawableTrapezoid* trapezoid : map.getTrapezoids())
+        n += !trapezoid->getIsBeingSplitted();
+    return n;
+}
+
+/**
+ * @brief rayShootingMismatches     counts the query points whose segments above and below differ in two maps.
+ * @param locator                   the map checked (any engine with rayShootUp and rayShootDown).
+ * @param map                       the reference map.
+ * @param queries                   the query points.
+ * @return                          the number of queries with a different segment above or below.
+ */
+template<class Locator>
+size_t rayShootingMismatches(const Locator& locator, const TrapezoidalMap& map, const std::vector<cg3::Point2d>& queries) {
+    size_t mismatches = 0;
+    for(const cg3::Point2d& q : queries)
+        mismatches += locator.rayShootUp(q) != map.rayShootUp(q) || locator.rayShootDown(q) != map.rayShootDown(q);
+    return mismatches;
+}
+
+// The key of a face: the ids of its top and bottom segments (NO_ID for the bounding box) and its walls
+typedef std::tuple<size_t, size_t, cg3::Point2d, cg3::Point2d> FaceKey;
+
+// returns the key of a face, or an empty key (no segments, walls in the origin) if there is no face
+FaceKey faceKey(const Trapezoid* t) {
+    if(t == nullptr)
+        return FaceKey(OrderedSegment::NO_ID, OrderedSegment::NO_ID, cg3::Point2d(), cg3::Point2d());
+    return FaceKey(t->getTop().getId(), t->getBottom().getId(), t->getLeftp(), t->getRightp());
+}
+
+/**
+ * @brief faceMismatches    compares the faces of two maps with their neighbors, by key (the trapezoids are different objects).
+ * @param faces             the faces checked (the ones being split are skipped).
+ * @param reference         the faces of the reference map (the ones being split are skipped).
+ * @return                  the number of faces, with their 4 neighbors, found in only one of the two lists.
+ */
+size_t faceMismatches(const std::vector<DrawableTrapezoid*>& faces, const std::vector<DrawableTrapezoid*>& reference) {
+    typedef std::array<FaceKey, 1 + Trapezoid::N_NEIGHBORS> FaceWithNeighbors;
+    auto describe = [](const std::vector<DrawableTrapezoid*>& list) {
+        std::vector<FaceWithNeighbors> described;
+        for(const DrawableTrapezoid* t : list) {
+            if(t->getIsBeingSplitted())
+                continue;
+            described.push_back({{faceKey(t), faceKey(t->getUpperLeftNeighbor()), faceKey(t->getUpperRightNeighbor()),
+                                  faceKey(t->getLowerLeftNeighbor()), faceKey(t->getLowerRightNeighbor())}});
+        }
+        std::sort(described.begin(), described.end());
+        return described;
+    };
+    const std::vector<FaceWithNeighbors> a = describe(faces);
+    const std::vector<FaceWithNeighbors> b = describe(reference);
+    std::vector<FaceWithNeighbors> difference;
+    std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(difference));
+    return difference.size();
+}
+
+/**
+ * @brief checkSteadyAllocations    checks the allocations of the insertions into a warmed-up map (only if they're counted): after
+ *                                  the first half of the segments, each insertion may allocate only the new faces, DAG nodes and
+ *                                  segment it creates. The lists of the map (faces, segments, DAG nodes) may grow too, but they're
+ *                                  reallocated only when their size doubles.
+ * @param segments                  the segments, in insertion order.
+ * @param [out] otherAllocations    the number of the other allocations done by the insertions of the second half.
+ * @param [out] allowedAllocations  the number of reallocations of the lists allowed.
+ * @return                          true if the other allocations are not more than the allowed ones.
+ */
+bool checkSteadyAllocations(const std::vector<cg3::Segment2d>& segments, size_t& otherAllocations, size_t& allowedAllocations) {
+    AllocationCounter::setExpectedSizes(AllocationCounter::ADD_SEGMENT, {sizeof(DrawableTrapezoid), sizeof(DAGNode), sizeof(OrderedSegment)});
+
+    TrapezoidalMap map;
+    map.initialize(cg3::BoundingBox2(cg3::Point2d(-BOUNDINGBOX, -BOUNDINGBOX), cg3::Point2d(BOUNDINGBOX, BOUNDINGBOX)));
+    const size_t half = segments.size() / 2;
+    for(size_t i = 0; i < half; i++)
+        map.addSegment(segments[i]);
+    const AllocationCounter::Stats before = AllocationCounter::getStats(AllocationCounter::ADD_SEGMENT);
+    for(size_t i = half; i < segments.size(); i++)
+        map.addSegment(segments[i]);
+    const AllocationCounter::Stats after = AllocationCounter::getStats(AllocationCounter::ADD_SEGMENT);
+
+    AllocationCounter::setExpectedSizes(AllocationCounter::ADD_SEGMENT, {});
+
+    otherAllocations = (after.allocations - after.expectedAllocations) - (before.allocations - before.expectedAllocations);
+    // The list of the faces is the longest one (the split faces are kept): each list is reallocated at most once for each bit of its size
+    allowedAllocations = 0;
+    for(size_t size = map.getTrapezoids().size(); size > 0; size /= 2)
+        allowedAllocations += 3;
+    return otherAllocations <= allowedAllocations;
+}
+
+/**
+ * @brief validateSegments      validates a list of segments one by one (TrapezoidalMapDataset::addSegment) and at once (addSegments).
+ * @param segments              the segments.
+ * @param [out] inserted        inserted[i] is true if the i-th segment has been inserted one by one.
+ * @param [out] oneByOneTime    the milliseconds elapsed inserting them one by one.
+ * @param [out] atOnceTime      the milliseconds elapsed inserting them at once.
+ * @return                      true if the two ways insert the same segments.
+ */
+bool validateSegments(const std::vector<cg3::Segment2d>& segments, std::vector<bool>& inserted, double& oneByOneTime, double& atOnceTime) {
+    Clock::time_point start = Clock::now();
+    TrapezoidalMapDataset dataset;
+    inserted.resize(segments.size());
+    for(size_t i = 0; i < segments.size(); i++) {
+        bool segmentInserted;
+        dataset.addSegment(segments[i], segmentInserted);
+        inserted[i] = segmentInserted;
+    }
+    oneByOneTime = elapsedMilliseconds(start);
+
+    start = Clock::now();
+    TrapezoidalMapDataset bulkDataset;
+    std::vector<bool> bulkInserted;
+    std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>> intersectingSegments;
+    bulkDataset.addSegments(segments, bulkInserted, intersectingSegments);
+    atOnceTime = elapsedMilliseconds(start);
+
+    return bulkInserted == inserted;
+}
+
+/**
+ * @brief checkNoding           splits crossing segments at their intersections (SegmentIntersections::nodeSegments) and checks the pieces:
+ *                              they don't intersect each other, the pieces of each segment cover its whole length (the snapping moves
+ *                              their endpoints by less than the step), and they build a map whose faces contain the points located in them.
+ * @param segments              the segments (they can cross each other).
+ * @param queries               the query points of the map of the pieces.
+ * @param [out] nPieces         the number of pieces.
+ * @param [out] nIntersections  the number of intersection points.
+ * @param [out] time            the milliseconds elapsed splitting the segments.
+ * @return                      true if all the checks pass.
+ */
+bool checkNoding(const std::vector<cg3::Segment2d>& segments, const std::vector<cg3::Point2d>& queries, size_t& nPieces, size_t& nIntersections, double& time) {
+    // The snapping step of the coordinates of the bounding box
+    const double step = std::ldexp(BOUNDINGBOX, -SegmentIntersections::SNAP_BITS);
+
+    const Clock::time_point start = Clock::now();
+    std::vector<cg3::Segment2d> pieces;
+    std::vector<size_t> origins;
+    std::vector<cg3::Point2d> intersectionPoints;
+    const bool complete = SegmentIntersections::nodeSegments(segments, pieces, origins, intersectionPoints, step);
+    time = elapsedMilliseconds(start);
+    nPieces = pieces.size();
+    nIntersections = intersectionPoints.size();
+
+    // Each piece intersects only itself
+    SegmentIntersectionChecker checker;
+    for(const cg3::Segment2d& piece : pieces)
+        checker.insert(piece);
+    const bool disjoint = checker.countIntersection(pieces) == pieces.size();
+
+    // The pieces of a segment sum up to its length: each endpoint is moved by at most half step (on both axes) by the snapping
+    std::vector<double> lengths(segments.size(), 0);
+    std::vector<size_t> pieceNumbers(segments.size(), 0);
+    for(size_t i = 0; i < pieces.size(); i++) {
+        lengths[origins[i]] += pieces[i].length();
+        pieceNumbers[origins[i]]++;
+    }
+    bool lengthsAgree = true;
+    for(size_t i = 0; i < segments.size(); i++) {
+        if(std::fabs(lengths[i] - segments[i].length()) > 2 * step * (pieceNumbers[i] + 1))
+            lengthsAgree = false;
+    }
+
+    // The pieces are all accepted by a dataset, and the map built with them locates every point in a face containing it
+    TrapezoidalMapDataset dataset;
+    std::vector<bool> inserted;
+    std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>> intersectingSegments;
+    const bool accepted = dataset.addSegments(pieces, inserted, intersectingSegments) == pieces.size();
+    TrapezoidalMap map;
+    map.initialize(cg3::BoundingBox2(cg3::Point2d(-BOUNDINGBOX, -BOUNDINGBOX), cg3::Point2d(BOUNDINGBOX, BOUNDINGBOX)));
+    for(const cg3::Segment2d& piece : pieces)
+        map.addSegment(piece);
+    bool located = true;
+    for(const cg3::Point2d& q : queries)
+        located = map.pointLocation(q)->containsPoint(q) && located;
+
+    return complete && disjoint && lengthsAgree && accepted && located;
+}
+
+/**
+ * @brief checkFacesCrossedBy   checks TrapezoidalMap::facesCrossedBy on segments between the query points: every point sampled along a
+ *                              segment is located in one of its faces, and the faces of the points follow the order of the list.
+ *                              The long segments cross the segments of the map (the faces are searched through the DAG), the short
+ *                              ones mostly don't (the faces are found walking the map).
+ * @param map                   the map.
+ * @param checker               the segments of the map, to tell the two cases apart.
+ * @param queries               the query points: the segments go from one to the next one, or to a point close to it.
+ * @param [out] nWalks          the number of segments not crossing the segments of the map.
+ * @param [out] nSearches       the number of segments crossing them.
+ * @return                      true if all the checks pass.
+ */
+bool checkFacesCrossedBy(const TrapezoidalMap& map, SegmentIntersectionChecker& checker, const std::vector<cg3::Point2d>& queries, size_t& nWalks, size_t& nSearches) {
+    const size_t N_SEGMENTS = 1000;
+    const size_t N_SAMPLES = 64;
+    const double shortLength = 2 * BOUNDINGBOX / std::sqrt(static_cast<double>(std::max<size_t>(map.segmentNumber(), 1)));
+
+    nWalks = nSearches = 0;
+    bool passed = true;
+    std::vector<DrawableTrapezoid*> faces;
+    std::vector<size_t> segmentIds;
+    for(size_t i = 0; i + 1 < queries.size() && i < N_SEGMENTS; i++) {
+        const cg3::Point2d& p = queries[i];
+        const cg3::Point2d direction = queries[i + 1] - p;
+        const cg3::Point2d q = i % 2 == 0 ? queries[i + 1] : p + direction * (shortLength / std::max(direction.dist(cg3::Point2d()), 1.0));
+        const cg3::Segment2d segment(p, q);
+        if(segment.p1() == segment.p2())
+            continue;
+        map.facesCrossedBy(segment, faces, segmentIds);
+        if(checker.checkIntersections(segment))
+            nSearches++;
+        else
+            nWalks++;
+
+        // The samples go from the leftmost endpoint to the rightmost one (lexicographically), as the faces
+        const OrderedSegment s(segment);
+        size_t previous = 0;
+        for(size_t k = 0; k < N_SAMPLES; k++) {
+            const cg3::Point2d sample = s.getLeftmost() + (s.getRightmost() - s.getLeftmost()) * ((k + 0.5) / N_SAMPLES);
+            const size_t position = std::find(faces.begin(), faces.end(), map.pointLocation(sample)) - faces.begin();
+            if(position == faces.size() || position < previous)
+                passed = false;
+            previous = position;
+        }
+    }
+    return passed;
+}
+
+// returns true if a segment intersects a box (touching counts as intersecting): Liang-Barsky clipping of p + t*(q-p), t in [0,1]
+bool segmentHitsBox(const cg3::Segment2d& s, const cg3::BoundingBox2& box) {
+    const double p[4] = {-(s.p2().x() - s.p1().x()), s.p2().x() - s.p1().x(), -(s.p2().y() - s.p1().y()), s.p2().y() - s.p1().y()};
+    const double q[4] = {s.p1().x() - box.min().x(), box.max().x() - s.p1().x(), s.p1().y() - box.min().y(), box.max().y() - s.p1().y()};
+    double t0 = 0, t1 = 1;
+    for(size_t i = 0; i < 4; i++) {
+        if(p[i] == 0) {
+            if(q[i] < 0)
+                return false;
+        }
+        else if(p[i] < 0)
+            t0 = std::max(t0, q[i] / p[i]);
+        else
+            t1 = std::min(t1, q[i] / p[i]);
+    }
+    return t0 <= t1;
+}
+
+/**
+ * @brief checkWindowQuery      checks TrapezoidalMap::windowQuery on boxes with a corner in the query points, of different sizes:
+ *                              the segments found must be the ones intersecting the box among all the segments of the map, and
+ *                              random points inside the box must be located in the trapezoids found.
+ * @param map                   the map.
+ * @param segments              the segments of the map, in insertion order (the position of a segment is its id).
+ * @param queries               the query points.
+ * @param [out] nSegmentsFound  the number of segments found in all the boxes.
+ * @return                      true if all the checks pass.
+ */
+bool checkWindowQuery(const TrapezoidalMap& map, const std::vector<cg3::Segment2d>& segments, const std::vector<cg3::Point2d>& queries, size_t& nSegmentsFound) {
+    const size_t N_BOXES = 300;
+    const size_t N_POINTS = 16;
+    const double scales[3] = {1, 0.1, 0.01};
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> unit(0, 1);
+    nSegmentsFound = 0;
+    bool passed = true;
+    std::vector<DrawableTrapezoid*> trapezoids;
+    std::vector<size_t> segmentIds;
+    for(size_t i = 0; i + 1 < queries.size() && i < N_BOXES; i++) {
+        const cg3::Point2d& a = queries[i];
+        const cg3::Point2d b = a + (queries[i + 1] - a) * scales[i % 3];
+        const cg3::BoundingBox2 box(cg3::Point2d(std::min(a.x(), b.x()), std::min(a.y(), b.y())), cg3::Point2d(std::max(a.x(), b.x()), std::max(a.y(), b.y())));
+        map.windowQuery(box, trapezoids, segmentIds);
+        nSegmentsFound += segmentIds.size();
+
+        // brute force over all the segments
+        std::vector<size_t> expectedIds;
+        for(size_t id = 0; id < segments.size(); id++)
+            if(segmentHitsBox(segments[id], box))
+                expectedIds.push_back(id);
+        std::sort(segmentIds.begin(), segmentIds.end());
+        if(segmentIds != expectedIds)
+            passed = false;
+
+        for(size_t k = 0; k < N_POINTS; k++) {
+            const cg3::Point2d q(box.min().x() + unit(generator) * (box.max().x() - box.min().x()), box.min().y() + unit(generator) * (box.max().y() - box.min().y()));
+            if(std::find(trapezoids.begin(), trapezoids.end(), map.pointLocation(q)) == trapezoids.end())
+                passed = false;
+        }
+    }
+    return passed;
+}
+
+/**
+ * @brief benchmarkSegments     builds the trapezoidal map of a set of segments and queries it, printing the timings.
+ * @param name                  the name of the set (e.g. its file).
+ * @param segments              the segments.
+ * @param queries               the query points.
+ * @param sorted                if true, the segments are inserted from left to right (a bad order for the randomized incremental construction).
+ * @return                      false if a check failed, i.e. two ways of computing the same result disagree.
+ */
+bool benchmarkSegments(const std::string& name, const std::vector<cg3::Segment2d>& segments, const std::vector<cg3::Point2d>& queries, bool sorted) {
+    // Validation of the segments, as the application does when loading a file
+    double validationTime, bulkValidationTime;
+    std::vector<bool> inserted;
+    bool bulkAgrees = validateSegments(segments, inserted, validationTime, bulkValidationTime);
+    std::vector<cg3::Segment2d> validSegments;
+    for(size_t i = 0; i < segments.size(); i++) {
+        if(inserted[i])
+            validSegments.push_back(segments[i]);
+    }
+
+    // The same check on a list full of intersections: each segment rotated around its midpoint, before all the segments.
+    // The rotated segments discard each other, so many segments hit only segments discarded before them
+    std::vector<cg3::Segment2d> crossedSegments;
+    for(const cg3::Segment2d& s : segments) {
+        const cg3::Point2d middle = (s.p1() + s.p2()) / 2;
+        const cg3::Point2d half = (s.p2() - s.p1()) / 2;
+        crossedSegments.push_back(cg3::Segment2d(middle + cg3::Point2d(-half.y(), half.x()), middle - cg3::Point2d(-half.y(), half.x())));
+    }
+    crossedSegments.insert(crossedSegments.end(), segments.begin(), segments.end());
+    double crossedValidationTime, crossedBulkValidationTime;
+    std::vector<bool> crossedInserted;
+    bulkAgrees = validateSegments(crossedSegments, crossedInserted, crossedValidationTime, crossedBulkValidationTime) && bulkAgrees;
+
+    // Check of a change set against the valid ones, sequential and with one thread for each core. The change set isn't in the
+    // checker: each segment is rotated around its midpoint and stretched 4 times, so it crosses its own segment only if it
+    // is valid and it can hit any number of the others
+    std::vector<cg3::Segment2d> changeSet;
+    for(const cg3::Segment2d& s : segments) {
+        const cg3::Point2d middle = (s.p1() + s.p2()) / 2;
+        const cg3::Point2d half = (s.p2() - s.p1()) * 2;
+        changeSet.push_back(cg3::Segment2d(middle + cg3::Point2d(-half.y(), half.x()), middle - cg3::Point2d(-half.y(), half.x())));
+    }
+    SegmentIntersectionChecker checker;
+    for(const cg3::Segment2d& s : validSegments)
+        checker.insert(s);
+    Clock::time_point start = Clock::now();
+    const size_t sequentialIntersections = checker.countIntersection(changeSet);
+    const double sequentialCheckTime = elapsedMilliseconds(start);
+    start = Clock::now();
+    const size_t parallelIntersections = checker.countIntersection(changeSet, 0);
+    const double parallelCheckTime = elapsedMilliseconds(start);
+
+    // Noding of the valid segments with a short copy of each one, rotated around its midpoint. The copies are at most 16 times
+    // the side of the box over the number of segments long, so they cross a few segments each (long copies of the thin segments
+    // would cross each other O(n^2) times)
+    std::vector<cg3::Segment2d> nodingSegments(validSegments);
+    const double maxHalfLength = 16 * BOUNDINGBOX / std::max<size_t>(validSegments.size(), 1);
+    for(const cg3::Segment2d& s : validSegments) {
+        const cg3::Point2d middle = (s.p1() + s.p2()) / 2;
+        const cg3::Point2d half = (s.p2() - s.p1()) * (std::min(0.5, maxHalfLength / s.length()));
+        nodingSegments.push_back(cg3::Segment2d(middle + cg3::Point2d(-half.y(), half.x()), middle - cg3::Point2d(-half.y(), half.x())));
+    }
+    size_t nPieces, nIntersections;
+    double nodingTime;
+    const bool nodingAgrees = checkNoding(nodingSegments, queries, nPieces, nIntersections, nodingTime);
+
+    if(sorted) {
+        std::sort(validSegments.begin(), validSegments.end(), [](const cg3::Segment2d& a, const cg3::Segment2d& b) {
+            return std::min(a.p1().x(), a.p2().x()) < std::min(b.p1().x(), b.p2().x());
+        });
+    }
+
+    // Construction of the map
+    start = Clock::now();
+    TrapezoidalMap map;
+    map.initialize(cg3::BoundingBox2(cg3::Point2d(-BOUNDINGBOX, -BOUNDINGBOX), cg3::Point2d(BOUNDINGBOX, BOUNDINGBOX)));
+    for(const cg3::Segment2d& s : validSegments)
+        map.addSegment(s);
+    const double buildTime = elapsedMilliseconds(start);
+
+    // Allocations of the insertions into a warmed-up map
+    size_t otherAllocations = 0;
+    size_t allowedAllocations = 0;
+    const bool steadyAllocationsAgree = !AllocationCounter::isEnabled() || checkSteadyAllocations(validSegments, otherAllocations, allowedAllocations);
+    std::string steadyAllocations = "not checked (build with CONFIG += COUNT_ALLOCATIONS)";
+    if(AllocationCounter::isEnabled()) {
+        steadyAllocations = std::to_string(otherAllocations) + " allocations besides the new faces, DAG nodes and segments in the second half"
+                " of the insertions (at most " + std::to_string(allowedAllocations) + ", " + (steadyAllocationsAgree ? "ok" : "FAILED") + ")";
+    }
+
+    // Concurrent insertion of the same segments: it must build the same faces
+    start = Clock::now();
+    TrapezoidalMap concurrentMap;
+    concurrentMap.initialize(map.getBoundingBox());
+    concurrentMap.addSegments(validSegments, CONCURRENT_THREADS);
+    const double concurrentBuildTime = elapsedMilliseconds(start);
+    const size_t concurrentTrapezoids = liveTrapezoidNumber(concurrentMap);
+    const size_t trapezoids = liveTrapezoidNumber(map);
+    const size_t concurrentMismatches = rayShootingMismatches(concurrentMap, map, queries);
+
+    // The faces crossed by a segment
+    start = Clock::now();
+    size_t nWalks, nSearches;
+    const bool crossedFacesAgree = checkFacesCrossedBy(map, checker, queries, nWalks, nSearches);
+    const double crossedFacesTime = elapsedMilliseconds(start);
+
+    // The segments and the faces in a box
+    start = Clock::now();
+    size_t nWindowSegments;
+    const bool windowAgrees = checkWindowQuery(map, validSegments, queries, nWindowSegments);
+    const double windowTime = elapsedMilliseconds(start);
+
+    // Queries (the checksum prevents the compiler from removing them)
+    size_t checksum = 0;
+    const double queryTime = timeQueries(map, queries, checksum);
+
+    // Batch query (sorted along the Morton curve)
+    start = Clock::now();
+    std::vector<DrawableTrapezoid*> batchResult;
+    map.pointLocation(queries, batchResult);
+    const double batchQueryTime = elapsedMilliseconds(start);
+
+    // Queries through the grid index
+    start = Clock::now();
+    GridIndex grid(map);
+    const double gridBuildTime = elapsedMilliseconds(start);
+    size_t gridChecksum = 0;
+    const double gridQueryTime = timeQueries(grid, queries, gridChecksum);
+
+    // Queries through the persistent tree of the slabs
+    start = Clock::now();
+    PersistentSlabLocator persistent(map);
+    const double persistentBuildTime = elapsedMilliseconds(start);
+    size_t persistentChecksum = 0;
+    const double persistentQueryTime = timeQueries(persistent, queries, persistentChecksum);
+
+    // Queries through the single-precision copy of the DAG: each one must find the face found by the DAG
+    start = Clock::now();
+    CompactLocator compact(map);
+    const double compactBuildTime = elapsedMilliseconds(start);
+    size_t compactChecksum = 0;
+    const double compactQueryTime = timeQueries(compact, queries, compactChecksum);
+    size_t compactMismatches = 0;
+    size_t compactFallbacks = 0;
+    for(const cg3::Point2d& q : queries) {
+        bool fallback;
+        compactMismatches += compact.pointLocation(q, fallback) != map.pointLocation(q);
+        compactFallbacks += fallback;
+    }
+
+    // The engine answering these queries in the least time, counting its construction (the grid and the persistent tree need the DAG)
+    const double dagTotal = buildTime + queryTime;
+    const double gridTotal = buildTime + gridBuildTime + gridQueryTime;
+    const double persistentTotal = buildTime + persistentBuildTime + persistentQueryTime;
+    const char* bestEngine = dagTotal <= gridTotal && dagTotal <= persistentTotal ? "DAG" : (gridTotal <= persistentTotal ? "grid" : "persistent");
+
+    // Parallel construction (one thread for each slab) and queries through the slabs
+    start = Clock::now();
+    SlabTrapezoidalMap slabMap;
+    slabMap.build(map.getBoundingBox(), validSegments, SLABS);
+    const double slabBuildTime = elapsedMilliseconds(start);
+    start = Clock::now();
+    const size_t slabMismatches = rayShootingMismatches(slabMap, map, queries);
+    const double slabQueryTime = elapsedMilliseconds(start);
+
+    // Static construction with the sweep, and queries through its persistent tree: it must build the same faces, with the same neighbors
+    start = Clock::now();
+    SweepTrapezoidalMap sweepMap;
+    sweepMap.build(map.getBoundingBox(), validSegments);
+    const double sweepBuildTime = elapsedMilliseconds(start);
+    size_t sweepChecksum = 0;
+    const double sweepQueryTime = timeQueries(sweepMap, queries, sweepChecksum);
+    const size_t sweepFaceMismatches = faceMismatches(sweepMap.getTrapezoids(), map.getTrapezoids());
+    const size_t sweepMismatches = rayShootingMismatches(sweepMap, map, queries);
+
+    std::cout << name << std::endl
+              << "    segments:   " << validSegments.size() << "/" << segments.size() << " valid" << std::endl
+              << "    validation: " << validationTime << " ms one by one, " << bulkValidationTime << " ms at once; with rotated copies "
+              << crossedValidationTime << " ms one by one, " << crossedBulkValidationTime << " ms at once ("
+              << (bulkAgrees ? "agree" : "DISAGREE") << ")" << std::endl
+              << "    check:      " << sequentialCheckTime << " ms sequential, " << parallelCheckTime << " ms parallel, "
+              << parallelIntersections << " intersections of " << changeSet.size() << " stretched rotated copies (" << (parallelIntersections == sequentialIntersections ? "agree" : "DISAGREE") << ")" << std::endl
+              << "    noding:     " << nodingTime << " ms, " << nodingSegments.size() << " segments (the valid ones and their short rotated copies) split into " << nPieces << " pieces at " << nIntersections
+              << " points (" << (nodingAgrees ? "ok" : "FAILED") << ")" << std::endl
+              << "    build:      " << buildTime << " ms" << std::endl
+              << "    steady:     " << steadyAllocations << std::endl
+              << "    concurrent: " << concurrentBuildTime << " ms (" << CONCURRENT_THREADS << " threads), " << concurrentTrapezoids << "/" << trapezoids
+              << " trapezoids, " << concurrentMismatches << " ray-shooting mismatches" << std::endl
+              << "    crossed:    " << crossedFacesTime << " ms, " << nWalks << " segments walked and " << nSearches << " searched through the DAG, "
+              << "samples " << (crossedFacesAgree ? "inside the faces found, in their order" : "OUTSIDE the faces found or out of order") << std::endl
+              << "    window:     " << windowTime << " ms, " << nWindowSegments << " segments found in the boxes, "
+              << (windowAgrees ? "same as the brute force, points inside the faces found" : "DIFFERENT from the brute force or points outside the faces found") << std::endl
+              << "    queries:    " << queryTime << " ms (" << 1e6 * queryTime / std::max<size_t>(queries.size(), 1) << " ns/query)" << std::endl
+              << "    batch:      " << batchQueryTime << " ms (" << 1e6 * batchQueryTime / std::max<size_t>(queries.size(), 1) << " ns/query)" << std::endl
+              << "    grid:       " << gridQueryTime << " ms (" << 1e6 * gridQueryTime / std::max<size_t>(queries.size(), 1) << " ns/query), "
+              << grid.getResolution() << "x" << grid.getResolution() << " cells built in " << gridBuildTime << " ms, "
+              << grid.getRootCellNumber() << " cells at the root" << std::endl
+              << "    persistent: " << persistentQueryTime << " ms (" << 1e6 * persistentQueryTime / std::max<size_t>(queries.size(), 1) << " ns/query), "
+              << persistent.getNodeNumber() << " nodes for " << persistent.getSlabNumber() << " slabs built in " << persistentBuildTime << " ms, "
+              << persistent.getMemoryFootprint() / 1024 << " KB" << std::endl
+              << "    compact:    " << compactQueryTime << " ms (" << 1e6 * compactQueryTime / std::max<size_t>(queries.size(), 1) << " ns/query), "
+              << compactFallbacks << " fallbacks to the DAG, " << compactMismatches << " mismatches, built in " << compactBuildTime << " ms, "
+              << compact.getMemoryFootprint() / 1024 << " KB on top of the " << map.getDAG().getMemoryFootprint() / 1024 << " KB of the DAG" << std::endl
+              << "    slabs:      " << slabMap.getSlabNumber() << " slabs (" << SLABS << " requested) built in " << slabBuildTime << " ms, "
+              << slabMismatches << " ray-shooting mismatches (" << slabQueryTime << " ms, both maps queried)" << std::endl
+              << "    sweep:      " << sweepQueryTime << " ms (" << 1e6 * sweepQueryTime / std::max<size_t>(queries.size(), 1) << " ns/query), "
+              << sweepMap.getTrapezoids().size() << " trapezoids built in " << sweepBuildTime << " ms, " << sweepFaceMismatches
+              << " faces different from the DAG (with their neighbors), " << sweepMismatches << " ray-shooting mismatches" << std::endl
+              << "    checksum:   " << checksum << " (grid " << (gridChecksum == checksum ? "agrees" : "DISAGREES") << ", persistent "
+              << (persistentChecksum == checksum ? "agrees" : "DISAGREES") << " with the DAG)" << std::endl
+              << "    fastest:    " << bestEngine << " (construction and queries)" << std::endl;
+
+    return bulkAgrees && steadyAllocationsAgree && parallelIntersections == sequentialIntersections && nodingAgrees &&
+            concurrentTrapezoids == trapezoids && crossedFacesAgree && windowAgrees && concurrentMismatches == 0 && slabMismatches == 0 && sweepMismatches == 0 && sweepFaceMismatches == 0 &&
+            compactMismatches == 0 && gridChecksum == checksum && persistentChecksum == checksum;
+}
+
+// returns true if a point is inside a ring (even-odd ray casting, with a horizontal ray going right)
+bool insideRing(const std::vector<cg3::Point2d>& ring, const cg3::Point2d& q) {
+    bool inside = false;
+    for(size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        const cg3::Point2d& a = ring[i];
+        const cg3::Point2d& b = ring[j];
+        if((a.y() > q.y()) != (b.y() > q.y()) && q.x() < a.x() + (q.y() - a.y()) * (b.x() - a.x()) / (b.y() - a.y()))
+            inside = !inside;
+    }
+    return inside;
+}
+
+// returns the area of a ring (shoelace formula)
+double ringArea(const std::vector<cg3::Point2d>& ring) {
+    double doubleArea = 0;
+    for(size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+        doubleArea += ring[j].x() * ring[i].y() - ring[i].x() * ring[j].y();
+    return std::abs(doubleArea) / 2;
+}
+
+/**
+ * @brief benchmarkNestedPolygons   builds a map of nested polygons and checks pointInPolygon against ray casting.
+ *                                  Each cell of a grid over the bounding box has an outer polygon containing two nests of 1 to 3 polygons.
+ *                                  The polygons are star-shaped around their center, with the radii of each level in a separate band,
+ *                                  so they don't cross; every other one is clockwise.
+ *                                  The reference is the innermost (smallest) polygon containing the point by ray casting.
+ * @param queries                   the query points (the first POLYGON_QUERIES ones are used).
+ * @return                          true if the map and the ray casting agree on every point.
+ */
+bool benchmarkNestedPolygons(const std::vector<cg3::Point2d>& queries) {
+    const size_t N_VERTICES = 24;
+    const double pi = std::acos(-1.0);
+    const double cell = 2 * (BOUNDINGBOX - 1) / POLYGON_CELLS;
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::vector<std::vector<cg3::Point2d>> rings;
+    // a ring around a center, with the radii in [minRadius, maxRadius]
+    auto addRing = [&](const cg3::Point2d& center, const double minRadius, const double maxRadius) {
+        const double rotation = unit(generator) * 2 * pi;
+        std::vector<cg3::Point2d> ring;
+        for(size_t k = 0; k < N_VERTICES; k++) {
+            const double angle = rotation + 2 * pi * k / N_VERTICES;
+            const double radius = minRadius + unit(generator) * (maxRadius - minRadius);
+            ring.push_back(center + cg3::Point2d(std::cos(angle), std::sin(angle)) * radius);
+        }
+        if(rings.size() % 2 == 1)
+            std::reverse(ring.begin(), ring.end());
+        rings.push_back(ring);
+    };
+    for(size_t i = 0; i < POLYGON_CELLS; i++) {
+        for(size_t j = 0; j < POLYGON_CELLS; j++) {
+            const cg3::Point2d center(-BOUNDINGBOX + 1 + (i + 0.5) * cell, -BOUNDINGBOX + 1 + (j + 0.5) * cell);
+            addRing(center, 0.40 * cell, 0.48 * cell);
+            // the level k of a nest of depth d has radii in [0.8, 1] * 0.18 * (d-k)/d of the cell: at most 2/3 of the level above
+            const size_t depth = 1 + (i + j) % 3;
+            for(double side : {-1.0, 1.0}) {
+                for(size_t k = 0; k < depth; k++) {
+                    const double radius = 0.18 * cell * (depth - k) / depth;
+                    addRing(center + cg3::Point2d(side * 0.2 * cell, 0), 0.8 * radius, radius);
+                }
+            }
+        }
+    }
+
+    Clock::time_point start = Clock::now();
+    TrapezoidalMap map;
+    map.initialize(cg3::BoundingBox2(cg3::Point2d(-BOUNDINGBOX, -BOUNDINGBOX), cg3::Point2d(BOUNDINGBOX, BOUNDINGBOX)));
+    for(size_t id = 0; id < rings.size(); id++)
+        map.addPolygon(rings[id], id);
+    const double buildTime = elapsedMilliseconds(start);
+    start = Clock::now();
+    map.labelPolygonFaces();
+    const double labelTime = elapsedMilliseconds(start);
+
+    const size_t nQueries = std::min<size_t>(queries.size(), POLYGON_QUERIES);
+    start = Clock::now();
+    std::vector<size_t> ids(nQueries);
+    for(size_t i = 0; i < nQueries; i++)
+        ids[i] = map.pointInPolygon(queries[i]);
+    const double queryTime = elapsedMilliseconds(start);
+
+    // The reference: the smallest ring containing the point (the bounding boxes skip most of the rings)
+    std::vector<cg3::BoundingBox2> boxes;
+    std::vector<double> areas;
+    for(const std::vector<cg3::Point2d>& ring : rings) {
+        cg3::BoundingBox2 box(ring[0], ring[0]);
+        for(const cg3::Point2d& p : ring)
+            box = cg3::BoundingBox2(cg3::Point2d(std::min(box.min().x(), p.x()), std::min(box.min().y(), p.y())),
+                                    cg3::Point2d(std::max(box.max().x(), p.x()), std::max(box.max().y(), p.y())));
+        boxes.push_back(box);
+        areas.push_back(ringArea(ring));
+    }
+    size_t nInside = 0;
+    size_t mismatches = 0;
+    for(size_t i = 0; i < nQueries; i++) {
+        const cg3::Point2d& q = queries[i];
+        size_t expected = OrderedSegment::NO_ID;
+        for(size_t id = 0; id < rings.size(); id++) {
+            if(boxes[id].isInside(q) && (expected == OrderedSegment::NO_ID || areas[id] < areas[expected]) && insideRing(rings[id], q))
+                expected = id;
+        }
+        nInside += expected != OrderedSegment::NO_ID;
+        mismatches += ids[i] != expected;
+    }
+
+    std::cout << "nested polygons " << POLYGON_CELLS << "x" << POLYGON_CELLS << std::endl
+              << "    polygons:   " << rings.size() << " polygons (" << rings.size() * N_VERTICES << " edges) inserted in " << buildTime
+              << " ms, faces labelled in " << labelTime << " ms" << std::endl
+              << "    queries:    " << queryTime << " ms for " << nQueries << " points, " << nInside << " inside a polygon, "
+              << mismatches << " different from the ray casting" << std::endl << std::endl;
+    return mismatches == 0;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <dataset file>... [-r <number of segments>]... [-g <shape> <number of segments>]..." << std::endl
+                  << "       [-q <number of queries> | -Q <query file>] [-s]" << std::endl
+                  << "    -r    benchmark also random non-intersecting segments (see SegmentGenerator), generated with a fixed seed" << std::endl
+                  << "    -g    benchmark also a generated workload (see WorkloadGenerator): uniform, clustered, thin, vertical, grid or roads" << std::endl
+                  << "    -Q    read the query points from a file (text or binary, see the workload generator) instead of generating them" << std::endl
+                  << "    -s    insert the segments sorted from left to right instead of in the order of the file" << std::endl
+                  << "Every run benchmarks also a grid of nested polygons (pointInPolygon is checked against ray casting)." << std::endl
+                  << "The exit status is a failure if a check fails (two ways of computing the same result disagree)." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Parsing the arguments
+    size_t nQueries = DEFAULT_N_QUERIES;
+    bool sorted = false;
+    std::vector<std::string> filenames;
+    std::vector<size_t> randomSizes;
+    std::vector<std::pair<WorkloadGenerator::SegmentShape, size_t>> workloads;
+    std::string queryFilename;
+    for(int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        if(argument == "-q" && i + 1 < argc)
+            nQueries = std::strtoul(argv[++i], nullptr, 10);
+        else if(argument == "-r" && i + 1 < argc)
+            randomSizes.push_back(std::strtoul(argv[++i], nullptr, 10));
+        else if(argument == "-g" && i + 2 < argc) {
+            WorkloadGenerator::SegmentShape shape;
+            if(!WorkloadGenerator::parseShape(argv[++i], shape)) {
+                std::cerr << "Unknown shape: " << argv[i] << std::endl;
+                return EXIT_FAILURE;
+            }
+            workloads.push_back(std::make_pair(shape, std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if(argument == "-Q" && i + 1 < argc)
+            queryFilename = argv[++i];
+        else if(argument == "-s")
+            sorted = true;
+        else
+            filenames.push_back(argument);
+    }
+
+    bool isComplete = true;
+    const std::vector<cg3::Point2d> queries = queryFilename.empty() ? generateQueries(nQueries, 42) : FileUtils::getPointsFromFile(queryFilename, isComplete);
+    if(!isComplete) {
+        std::cerr << "Can't read the query points of " << queryFilename << ": the file is missing, unreadable or truncated" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The benchmark fails if a check of a set fails
+    bool passed = true;
+    for(const std::string& filename : filenames) {
+        AllocationCounter::reset();
+        passed = benchmarkSegments(filename, FileUtils::getSegmentsFromFile(filename), queries, sorted) && passed;
+        AllocationCounter::report(std::cout);
+        std::cout << std::endl;
+    }
+
+    const cg3::BoundingBox2 box(cg3::Point2d(-BOUNDINGBOX + 1, -BOUNDINGBOX + 1), cg3::Point2d(BOUNDINGBOX - 1, BOUNDINGBOX - 1));
+    for(size_t n : randomSizes) {
+        const Clock::time_point start = Clock::now();
+        const std::vector<cg3::Segment2d> segments = SegmentGenerator::randomNonIntersectingSegments(n, box, 42);
+        std::cout << n << " random segments generated in " << elapsedMilliseconds(start) << " ms" << std::endl;
+
+        AllocationCounter::reset();
+        passed = benchmarkSegments("random " + std::to_string(n), segments, queries, sorted) && passed;
+        AllocationCounter::report(std::cout);
+        std::cout << std::endl;
+    }
+
+    for(const std::pair<WorkloadGenerator::SegmentShape, size_t>& workload : workloads) {
+        const std::string name = std::string(WorkloadGenerator::getShapeName(workload.first)) + " " + std::to_string(workload.second);
+        const Clock::time_point start = Clock::now();
+        const std::vector<cg3::Segment2d> segments = WorkloadGenerator::generateSegments(workload.first, workload.second, box, 42);
+        std::cout << name << " generated in " << elapsedMilliseconds(start) << " ms" << std::endl;
+
+        AllocationCounter::reset();
+        passed = benchmarkSegments(name, segments, queries, sorted) && passed;
+        AllocationCounter::report(std::cout);
+        std::cout << std::endl;
+    }
+
+    passed = benchmarkNestedPolygons(queries) && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,39 @@
+# Library of the core of the trapezoidal map (see ../trapezoidalmap_core.pri): it depends only on the core of cg3lib, so
+# services and headless tools can link it without Qt and OpenGL. The public API is in trapezoidalmapcore.h.
+#
+# To use it, add to the project:
+#   INCLUDEPATH += <root of the project> <root of the project>/cg3lib
+#   LIBS += -L<build folder of this project> -ltrapezoidalmap
+# with the same cg3lib configuration (CONFIG += CG3_CORE) and the same COUNT_ALLOCATIONS option.
+TEMPLATE = lib
+TARGET = trapezoidalmap
+VERSION = 1.0.0
+CONFIG += c++11 thread
+CONFIG -= qt
+
+# Static library by default: uncomment next line for a shared one (only on unix, the classes are not exported on windows)
+#CONFIG += TRAPEZOIDALMAP_SHARED
+TRAPEZOIDALMAP_SHARED {
+    CONFIG += shared
+}
+else {
+    CONFIG += staticlib
+}
+
+# Release configuration
+CONFIG(release, debug|release){
+    QMAKE_CXXFLAGS_RELEASE -= -O2
+    QMAKE_CXXFLAGS += -O3 -DNDEBUG
+}
+
+# Uncomment next line if you want to count the heap allocations of each operation (see utils/allocationcounter.h)
+#CONFIG += COUNT_ALLOCATIONS
+
+# Only the core of cg3lib is needed
+CONFIG += CG3_CORE
+include (../cg3lib/cg3.pri)
+
+include (../trapezoidalmap_core.pri)
+
+HEADERS += \
+    trapezoidalmapcore.h
@@ -0,0 +1,28 @@
+#ifndef TRAPEZOIDALMAPCORE_H
+#define TRAPEZOIDALMAPCORE_H
+
+/* Public API of the core library of the trapezoidal map (core/core.pro), built without Qt and OpenGL:
+ * - TrapezoidalMap: the map, built incrementally, with its point location and ray shooting queries (DAG and Trapezoid
+ *   are its search structure and its faces);
+ * - the static point locators built on a map: GridIndex, CompactLocator, PersistentSlabLocator (see PointLocator);
+ * - TrapezoidalMapDataset: the validation of the segments (no intersections, no duplicates) before they're inserted;
+ * - FileUtils: the text and binary files of segments and query points.
+ *
+ * The headers are the ones of the sources of the application (the include path is the root of the project).
+ * The version changes its major number when one of these classes changes in an incompatible way: a program built against a
+ * version works with the later ones with the same major number. The faces of the maps are DrawableTrapezoid objects, for the
+ * application: the library never computes their graphics (see DrawableTrapezoid::calculateGraphics). */
+
+#define TRAPEZOIDALMAP_VERSION_MAJOR 1
+#define TRAPEZOIDALMAP_VERSION_MINOR 0
+
+#include "data_structures/compactlocator.h"
+#include "data_structures/dag.h"
+#include "data_structures/gridindex.h"
+#include "data_structures/persistentslablocator.h"
+#include "data_structures/trapezoid.h"
+#include "data_structures/trapezoidalmap.h"
+#include "data_structures/trapezoidalmap_dataset.h"
+#include "utils/fileutils.h"
+
+#endif // TRAPEZOIDALMAPCORE_H
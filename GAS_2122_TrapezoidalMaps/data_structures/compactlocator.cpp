@@ -0,0 +1,162 @@
+#include "compactlocator.h"
+
+#include <cmath>
+
+/* Error bounds of the quantised comparisons, expressed in the normalized space [0,1]x[0,1].
+ * Each coordinate is rounded to float, so its error is at most half unit in the last place, i.e. 2^-25 (we take 2^-24).
+ *      x-node:     the difference of two quantised values is wrong by at most 2 errors, rounded once more.
+ *      y-node:     the orientation determinant involves 3 differences and 2 products, every factor is at most 1 in absolute value:
+ *                  the overall error is below 17 * 2^-24, we take a safety margin.
+ * When a comparison is inside its band, the quantised result is not trusted. */
+static const double COORDINATE_ERROR = std::ldexp(1.0, -24);
+static const float X_NODE_BAND = static_cast<float>(4 * COORDINATE_ERROR);
+static const float Y_NODE_BAND = static_cast<float>(32 * COORDINATE_ERROR);
+
+/// CONSTRUCTORS ///
+CompactLocator::CompactLocator() {}
+
+CompactLocator::CompactLocator(const TrapezoidalMap& map) {
+    build(map);
+}
+///////////////////////////////////////
+
+
+void CompactLocator::build(const TrapezoidalMap& map) {
+    clear();
+    assert(map.getDAG().getRoot() != nullptr);
+
+    this->map = &map;
+
+    // Saving the quantisation parameters: the bounding box is mapped into [0,1]x[0,1]
+    const cg3::BoundingBox2& B = map.getBoundingBox();
+    origin = B.min();
+    scaleX = B.lengthX() > 0 ? 1.0 / B.lengthX() : 1.0;
+    scaleY = B.lengthY() > 0 ? 1.0 / B.lengthY() : 1.0;
+
+    // Visit the DAG: the root will be the first node of the list
+    std::unordered_map<const DAGNode*, uint32_t> exported;
+    exportNode(map.getDAG().getRoot(), exported);
+
+    nodes.shrink_to_fit();
+    xValues.shrink_to_fit();
+    segmentValues.shrink_to_fit();
+    faces.shrink_to_fit();
+}
+
+DrawableTrapezoid* CompactLocator::pointLocation(const cg3::Point2d& pointToQuery) const {
+    bool fallback;
+    return pointLocation(pointToQuery, fallback);
+}
+
+DrawableTrapezoid* CompactLocator::pointLocation(const cg3::Point2d& pointToQuery, bool& fallback) const {
+    assert(map != nullptr);
+    fallback = true;
+
+    const float qx = quantiseX(pointToQuery.x());
+    const float qy = quantiseY(pointToQuery.y());
+
+    // The error bounds hold only inside the bounding box
+    if(qx < 0.0f || qx > 1.0f || qy < 0.0f || qy > 1.0f)
+        return map->pointLocation(pointToQuery);
+
+    uint32_t current = 0;
+    while(nodes[current].type != leaf) {
+        const Node& node = nodes[current];
+
+        if(node.type == x_node) {
+            const float difference = qx - xValues[node.payload];
+            // too close to the x-value: the full-precision DAG decides
+            if(std::fabs(difference) <= X_NODE_BAND)
+                return map->pointLocation(pointToQuery);
+
+            // q.x < node.x => go left, else go right
+            current = difference < 0 ? node.lc : node.rc;
+        }
+        else {
+            const float* s = &segmentValues[4 * size_t(node.payload)];
+            const float det = (s[2] - s[0]) * (qy - s[1]) - (s[3] - s[1]) * (qx - s[0]);
+            // too close to the segment: the full-precision DAG decides
+            if(std::fabs(det) <= Y_NODE_BAND)
+                return map->pointLocation(pointToQuery);
+
+            // q above segment => go left, else go right
+            current = det > 0 ? node.lc : node.rc;
+        }
+    }
+
+    fallback = false;
+    return faces[nodes[current].payload];
+}
+
+double CompactLocator::getErrorBound() const {
+    return COORDINATE_ERROR * std::max(1.0 / scaleX, 1.0 / scaleY);
+}
+
+size_t CompactLocator::getMemoryFootprint() const {
+    return nodes.capacity() * sizeof(Node)
+            + xValues.capacity() * sizeof(float)
+            + segmentValues.capacity() * sizeof(float)
+            + faces.capacity() * sizeof(DrawableTrapezoid*);
+}
+
+void CompactLocator::clear() {
+    nodes.clear();
+    xValues.clear();
+    segmentValues.clear();
+    faces.clear();
+    map = nullptr;
+}
+
+
+float CompactLocator::quantiseX(double x) const {
+    return static_cast<float>((x - origin.x()) * scaleX);
+}
+
+float CompactLocator::quantiseY(double y) const {
+    return static_cast<float>((y - origin.y()) * scaleY);
+}
+
+uint32_t CompactLocator::exportNode(const DAGNode* node, std::unordered_map<const DAGNode*, uint32_t>& exported) {
+    // If the node has already been exported (i.e. it has several parents), return its index
+    auto alreadyExported = exported.find(node);
+    if(alreadyExported != exported.end())
+        return alreadyExported->second;
+
+    // Reserve the position of the node before exporting its children
+    const uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node());
+    exported.insert(std::make_pair(node, index));
+
+    Node compactNode;
+    compactNode.lc = 0;
+    compactNode.rc = 0;
+
+    if(node->isXNode()) {
+        compactNode.type = x_node;
+        compactNode.payload = static_cast<uint32_t>(xValues.size());
+        xValues.push_back(quantiseX(node->getPointStored().x()));
+    }
+    else if(node->isYNode()) {
+        const DAGNode::SegmentCoordinates& s = node->getSegmentCoordinates();
+        compactNode.type = y_node;
+        compactNode.payload = static_cast<uint32_t>(segmentValues.size() / 4);
+        segmentValues.push_back(quantiseX(s.x1));
+        segmentValues.push_back(quantiseY(s.y1));
+        segmentValues.push_back(quantiseX(s.x2));
+        segmentValues.push_back(quantiseY(s.y2));
+    }
+    else {
+        compactNode.type = leaf;
+        compactNode.payload = static_cast<uint32_t>(faces.size());
+        faces.push_back(node->getTrapezoidStored());
+    }
+
+    // Export the children (the leaves have none)
+    if(!node->isLeaf()) {
+        compactNode.lc = exportNode(node->lc, exported);
+        compactNode.rc = exportNode(node->rc, exported);
+    }
+
+    nodes[index] = compactNode;
+    return index;
+}
@@ -0,0 +1,110 @@
+#ifndef COMPACTLOCATOR_H
+#define COMPACTLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "cg3/geometry/point2.h"
+#include "cg3/geometry/bounding_box2.h"
+#include "trapezoidalmap.h"
+#include "pointlocator.h"
+
+/**
+ * @brief The CompactLocator class is a read-only, single-precision copy of the DAG of a trapezoidal map.
+ * The coordinates are quantised to float relative to the bounding box of the map (i.e. they are mapped in [0,1]x[0,1]),
+ * the nodes are stored in a flat array and the children are referred by 32-bit indices.
+ * Every comparison whose result could be changed by the quantisation error is not trusted: in that case the query
+ * falls back to the full-precision DAG of the map, so the answer is always the same of TrapezoidalMap::pointLocation.
+ *
+ * The locator is a snapshot: if new segments are inserted into the map, it has to be built again.
+ *
+ * It reduces the cache footprint of the queries, not the memory of the map: the search walks 16-byte nodes and floats instead of
+ * the DAG nodes, but the map (its trapezoids, returned by the queries, and its DAG, used as fallback) must stay alive, so the
+ * locator takes memory on top of it (see getMemoryFootprint).
+ */
+class CompactLocator : public PointLocator
+{
+public:
+    // Constructor: it creates an empty locator
+    CompactLocator();
+    // Constructor: it exports the map given in input
+    CompactLocator(const TrapezoidalMap& map);
+
+    /**
+     * @brief build     exports the DAG of a trapezoidal map into the compact representation. The previous content is discarded.
+     * @param map       the trapezoidal map to export. It must outlive the locator since it's used as fallback.
+     */
+    void build(const TrapezoidalMap& map);
+
+    /**
+     * @brief pointLocation     query a point in the compact locator.
+     * @param pointToQuery      the query point.
+     * @return                  the (drawable) trapezoid containing the query point.
+     */
+    DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery) const;
+
+    /**
+     * @brief pointLocation     query a point in the compact locator, telling if the full-precision DAG has been used.
+     * @param pointToQuery      the query point.
+     * @param [out] fallback    true if a comparison was inside the error band (or the point is outside the bounding box).
+     * @return                  the (drawable) trapezoid containing the query point.
+     */
+    DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery, bool& fallback) const;
+
+    // returns the maximum error (in the coordinates of the map) introduced by the quantisation of a coordinate
+    double getErrorBound() const;
+
+    // returns the number of bytes used by the compact representation (in addition to the map)
+    size_t getMemoryFootprint() const;
+
+    // removes all the nodes of the locator
+    void clear();
+
+private:
+    // Same meaning of DAGNode::nodeType, stored in a single byte
+    enum nodeType : uint8_t {x_node, y_node, leaf};
+
+    /**
+     * @brief The Node struct is the compact version of a DAGNode (16 bytes).
+     * The payload is an index into xValues (x-node), into segmentValues (y-node) or into faces (leaf).
+     */
+    struct Node {
+        uint32_t lc;
+        uint32_t rc;
+        uint32_t payload;
+        nodeType type;
+    };
+
+    // the nodes of the DAG, the root is the first one
+    std::vector<Node> nodes;
+    // quantised x-values of the x-nodes
+    std::vector<float> xValues;
+    // quantised endpoints of the segments of the y-nodes: 4 floats for each segment (x1, y1, x2, y2)
+    std::vector<float> segmentValues;
+    // trapezoids pointed by the leaves
+    std::vector<DrawableTrapezoid*> faces;
+
+    // the map used as fallback when a comparison is inside the error band
+    const TrapezoidalMap* map = nullptr;
+
+    // origin and scale factors used to quantise the coordinates
+    cg3::Point2d origin;
+    double scaleX = 1.0;
+    double scaleY = 1.0;
+
+    // quantise a coordinate of the map
+    float quantiseX(double x) const;
+    float quantiseY(double y) const;
+
+    /**
+     * @brief exportNode    recursively copies a DAG node (and its descendants) in the compact representation.
+     *                      Since a DAG node can be shared by several parents, the nodes already exported are skipped.
+     * @param node          the node to export.
+     * @param exported      [in/out] map from the nodes already exported to their index.
+     * @return              the index of the exported node.
+     */
+    uint32_t exportNode(const DAGNode* node, std::unordered_map<const DAGNode*, uint32_t>& exported);
+};
+
+#endif // COMPACTLOCATOR_H
@@ -1,7 +1,8 @@
 #include "dag.h"
 
+#include <algorithm>
+
 #include "cg3/geometry/utils2.h"
-#include "cg3/geometry/line2.h"
 
 /// CONSTRUCTOR AND DESTRUCTOR ///
 DAG::DAG()
@@ -42,17 +43,17 @@ void DAG::replaceNodeWithSubtree(DAGNode* const leafToUpdate, const OrderedSegme
     assert(bottomFace != nullptr);
 
     // Creating the segment subtree (it's always created in every case)
-    auto segmentNode = generateNode(&segmentSplitting);
+    auto segmentNode = generateNode(segmentSplitting);
     segmentNode->lc = generateNode(topFace);
     segmentNode->rc = generateNode(bottomFace);
 
     /* SIMPLE CASE: THE WHOLE SEGMENT IS INSIDE A FACE */
     if(leftFace != nullptr && rightFace != nullptr) {
         leafToUpdate->lc = generateNode(leftFace);
-        leafToUpdate->rc = generateNode(&segmentSplitting.getRightmost());
+        leafToUpdate->rc = generateNode(segmentSplitting.getRightmost());
         leafToUpdate->rc->lc = segmentNode;
         leafToUpdate->rc->rc = generateNode(rightFace);
-        leafToUpdate->convertToXNode(&segmentSplitting.getLeftmost());
+        leafToUpdate->convertToXNode(segmentSplitting.getLeftmost());
     }
 
     /* COMPLEX CASE: SEVERAL FACES ARE INTERSECTED BY THE SEGMENT AND leafToUpdate IS ONE OF THEM */
@@ -60,13 +61,13 @@ void DAG::replaceNodeWithSubtree(DAGNode* const leafToUpdate, const OrderedSegme
     else if (leftFace != nullptr) {
         leafToUpdate->lc = generateNode(leftFace);
         leafToUpdate->rc = segmentNode;
-        leafToUpdate->convertToXNode(&segmentSplitting.getLeftmost());
+        leafToUpdate->convertToXNode(segmentSplitting.getLeftmost());
     }
     // If it's the last face (k-th) intersected AND the segment is not intersecting the rightp of the old face.
     else if (rightFace != nullptr) {
         leafToUpdate->lc = segmentNode;
         leafToUpdate->rc = generateNode(rightFace);
-        leafToUpdate->convertToXNode(&segmentSplitting.getRightmost());
+        leafToUpdate->convertToXNode(segmentSplitting.getRightmost());
     }
     /* Else it's a i-th face with i in [2, k-1]
      *      OR the first face AND the segment is intersecting the leftp of the old face
@@ -74,7 +75,7 @@ void DAG::replaceNodeWithSubtree(DAGNode* const leafToUpdate, const OrderedSegme
     else {
         leafToUpdate->lc = segmentNode->lc;
         leafToUpdate->rc = segmentNode->rc;
-        leafToUpdate->convertToYNode(&segmentSplitting);
+        leafToUpdate->convertToYNode(segmentSplitting);
     }
 
     // Asserting the double links
@@ -92,19 +93,48 @@ DrawableTrapezoid* DAG::queryFaceContaininingPoint(const cg3::Point2d& q) const
     return queryRec(s, this->root);
 }
 
+DrawableTrapezoid* DAG::queryFaceContaininingPoint(const cg3::Point2d& q, const DAGNode* start) const {
+    OrderedSegment s = OrderedSegment(q,q);
+    return queryRec(s, start);
+}
+
 DrawableTrapezoid* DAG::queryLeftmostFaceIntersectingSegment(const OrderedSegment& s) const {
     return queryRec(s, this->root);
 }
 
+void DAG::queryFacesIntersectingBox(const cg3::BoundingBox2& box, std::vector<DrawableTrapezoid*>& faces) const {
+    std::unordered_set<const DAGNode*> visited;
+    queryBoxRec(box, this->root, visited, faces);
+}
+
+void DAG::queryFacesIntersectingSegment(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& faces) const {
+    std::unordered_set<const DAGNode*> visited;
+    querySegmentRec(s, this->root, visited, faces);
+}
+
+const DAGNode* DAG::getRoot() const {
+    return this->root;
+}
+
+size_t DAG::getNodeNumber() const {
+    return uniquePointers.size();
+}
+
+size_t DAG::getMemoryFootprint() const {
+    return uniquePointers.size() * sizeof(DAGNode) + uniquePointers.capacity() * sizeof(DAGNode*);
+}
+
 //////////////////////////////////////////////// NODE GENERATORS ////////////////////////////////
-DAGNode* DAG::generateNode(const cg3::Point2d* const pointToStore) {
+DAGNode* DAG::generateNode(const cg3::Point2d& pointToStore) {
     auto pointNode = DAGNode::generateXNode(pointToStore);
+    std::lock_guard<std::mutex> lock(uniquePointersMutex);
     uniquePointers.push_back(pointNode);
     return pointNode;
 }
 
-DAGNode* DAG::generateNode(const OrderedSegment* const segmentToStore) {
+DAGNode* DAG::generateNode(const OrderedSegment& segmentToStore) {
     auto segmentNode = DAGNode::generateYNode(segmentToStore);
+    std::lock_guard<std::mutex> lock(uniquePointersMutex);
     uniquePointers.push_back(segmentNode);
     return segmentNode;
 }
@@ -112,54 +142,152 @@ DAGNode* DAG::generateNode(DrawableTrapezoid* const trapezoidToStore) {
     bool alreadyPresent;
     auto trapezoidNode = DAGNode::generateLeafNode(trapezoidToStore, alreadyPresent);
     // If a leaf containing the trapezoid was already present, do NOT push the node (again) in the list
-    if(!alreadyPresent)
-            uniquePointers.push_back(trapezoidNode);
+    if(!alreadyPresent) {
+        std::lock_guard<std::mutex> lock(uniquePointersMutex);
+        uniquePointers.push_back(trapezoidNode);
+    }
     return trapezoidNode;
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
-DrawableTrapezoid* DAG::queryRec(const OrderedSegment& new_segment, DAGNode* const node) const {
-    auto q = new_segment.getLeftmost();
+DrawableTrapezoid* DAG::queryRec(const OrderedSegment& new_segment, const DAGNode* const node) const {
+    const cg3::Point2d& q = new_segment.getLeftmost();
 
     if(node->isXNode()) {
-        // q.x < node.x => go left
-        auto p_x = node->getPointStored()->x();
-        if(q.x() < p_x) {
+        /* q < node => go left. The points are compared lexicographically (symbolic shear):
+         * if q.x = node.x, q is on the left when it's below the point stored. */
+        if(q < node->getPointStored()) {
             return queryRec(new_segment, node->lc);
         }
-        // q.x >= node.x => go right
+        // q >= node => go right
         else {
             return queryRec(new_segment, node->rc);
         }
     }
     else if (node->isYNode()) {
+        // the segment is stored inside the node, no other object is dereferenced (nor built)
         // q above segment => go left
-        if(cg3::isPointAtLeft(node->getOrientedSegmentStored()->getLeftmost(), node->getOrientedSegmentStored()->getRightmost(), q)){
+        if(node->isPointAbove(q)){
             return queryRec(new_segment, node->lc);
         }
         // q below segment => go right
-        else if(cg3::isPointAtRight(node->getOrientedSegmentStored()->getLeftmost(), node->getOrientedSegmentStored()->getRightmost(), q)) {
+        else if(node->isPointBelow(q)) {
             return queryRec(new_segment, node->rc);
         }
-        // q ON THE SEGMENT
+        /* q ON THE SEGMENT: the new segment starts from q (i.e. they share the left endpoint),
+         * so its right endpoint tells if it lies above or below. The orientation test works with the vertical segments too,
+         * which have no slope. A query point on the segment (a degenerate new segment) goes above. */
         else {
-            // slopes of the (line passing through the) old segment
-            double m_old_segment = cg3::Line2(*node->getOrientedSegmentStored()).m();
-            // slopes of the (line passing through the) new segment
-            double m_new_segment = cg3::Line2(new_segment).m();
-
-            // slope(new_segment) > slope(old_segment) => q lies above
-            if(m_new_segment > m_old_segment)
-                return queryRec(new_segment, node->lc);
-            // slope(new_segment) < slope(old_segment) => q lies below
-            else if (m_new_segment < m_old_segment)
+            // the right endpoint of the new segment is below the old segment => go right
+            if(node->isPointBelow(new_segment.getRightmost()))
                 return queryRec(new_segment, node->rc);
-
-            // same slope should be impossible
-            assert(false);
+            // above (or on the segment, only for a query point) => go left
+            return queryRec(new_segment, node->lc);
         }
     }
 
     // else we reached a leaf, the point is contained in the trapezoid associated to the node
     return node->getTrapezoidStored();
 }
+
+void DAG::queryBoxRec(const cg3::BoundingBox2& box, const DAGNode* const node, std::unordered_set<const DAGNode*>& visited, std::vector<DrawableTrapezoid*>& faces) const {
+    // If the node has already been visited (i.e. it has several parents), its subtree has been visited too
+    if(!visited.insert(node).second)
+        return;
+
+    if(node->isXNode()) {
+        const cg3::Point2d p = node->getPointStored();
+        // a part of the box is on the left of the point (min is the lexicographically smallest point of the box) => go left
+        if(box.min() < p)
+            queryBoxRec(box, node->lc, visited, faces);
+        // a part of the box is on the right of the point (or on it) => go right
+        if(!(box.max() < p))
+            queryBoxRec(box, node->rc, visited, faces);
+    }
+    else if(node->isYNode()) {
+        const DAGNode::SegmentCoordinates& s = node->getSegmentCoordinates();
+
+        // A vertical segment has no x-range to clip the box to: both sides are visited
+        if(s.x1 == s.x2) {
+            queryBoxRec(box, node->lc, visited, faces);
+            queryBoxRec(box, node->rc, visited, faces);
+            return;
+        }
+
+        // The points reaching this node are inside the x-range of the segment: clip the box to it
+        const double x0 = std::max(box.min().x(), s.x1);
+        const double x1 = std::min(box.max().x(), s.x2);
+        const double y0 = yOnLine(s, x0);
+        const double y1 = yOnLine(s, x1);
+
+        // a part of the (clipped) box is above the segment => go left
+        if(box.max().y() >= std::min(y0, y1))
+            queryBoxRec(box, node->lc, visited, faces);
+        // a part of the (clipped) box is below the segment => go right
+        if(box.min().y() <= std::max(y0, y1))
+            queryBoxRec(box, node->rc, visited, faces);
+    }
+    // else we reached a leaf: its trapezoid can intersect the box
+    else {
+        faces.push_back(node->getTrapezoidStored());
+    }
+}
+
+void DAG::querySegmentRec(const OrderedSegment& s, const DAGNode* const node, std::unordered_set<const DAGNode*>& visited, std::vector<DrawableTrapezoid*>& faces) const {
+    // If the node has already been visited (i.e. it has several parents), its subtree has been visited too
+    if(!visited.insert(node).second)
+        return;
+
+    if(node->isXNode()) {
+        const cg3::Point2d p = node->getPointStored();
+        // a part of the segment is on the left of the point => go left
+        if(s.getLeftmost() < p)
+            querySegmentRec(s, node->lc, visited, faces);
+        // a part of the segment is on the right of the point (or on it) => go right
+        if(!(s.getRightmost() < p))
+            querySegmentRec(s, node->rc, visited, faces);
+    }
+    else if(node->isYNode()) {
+        const DAGNode::SegmentCoordinates& old_segment = node->getSegmentCoordinates();
+
+        // If one of the segments is vertical, the vertical distances aren't defined: both sides are visited
+        if(old_segment.x1 == old_segment.x2 || s.getLeftmost().x() == s.getRightmost().x()) {
+            querySegmentRec(s, node->lc, visited, faces);
+            querySegmentRec(s, node->rc, visited, faces);
+            return;
+        }
+
+        // The points reaching this node are inside the x-range of the stored segment: clip the query segment to it
+        const double x0 = std::max(s.getLeftmost().x(), old_segment.x1);
+        const double x1 = std::min(s.getRightmost().x(), old_segment.x2);
+        if(x0 > x1)
+            return;
+
+        // vertical distances of the query segment from the stored one at the ends of the common x-range
+        const double d0 = yOnLine(s, x0) - yOnLine(old_segment, x0);
+        const double d1 = yOnLine(s, x1) - yOnLine(old_segment, x1);
+
+        // a part of the (clipped) query segment is above the stored segment => go left
+        if(std::max(d0, d1) >= 0)
+            querySegmentRec(s, node->lc, visited, faces);
+        // a part of the (clipped) query segment is below the stored segment => go right
+        if(std::min(d0, d1) <= 0)
+            querySegmentRec(s, node->rc, visited, faces);
+    }
+    // else we reached a leaf: its trapezoid can intersect the segment
+    else {
+        faces.push_back(node->getTrapezoidStored());
+    }
+}
+
+double DAG::yOnLine(const OrderedSegment& s, const double x) {
+    const cg3::Point2d& p1 = s.getLeftmost();
+    const cg3::Point2d& p2 = s.getRightmost();
+    return yOnLine(DAGNode::SegmentCoordinates{p1.x(), p1.y(), p2.x(), p2.y()}, x);
+}
+
+double DAG::yOnLine(const DAGNode::SegmentCoordinates& s, const double x) {
+    if(s.x2 == s.x1)
+        return s.y1;
+    return s.y1 + (s.y2 - s.y1) * (x - s.x1) / (s.x2 - s.x1);
+}
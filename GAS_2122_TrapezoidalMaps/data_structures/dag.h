@@ -1,7 +1,11 @@
 #ifndef DAG_H
 #define DAG_H
 
+#include <mutex>
+#include <unordered_set>
+
 #include "cg3/geometry/point2.h"
+#include "cg3/geometry/bounding_box2.h"
 #include "orderedsegment.h"
 #include "dagnode.h"
 
@@ -37,6 +41,14 @@ public:
      */
     DrawableTrapezoid* queryFaceContaininingPoint(const cg3::Point2d& q) const;
 
+    /**
+     * @brief queryFaceContaininingPoint visits the DAG from a given node searching for the trapezoid containing the point q.
+     * @param q         the query point.
+     * @param start     the node from which the visit starts. It must be the root or a node whose region contains q.
+     * @return          the trapezoid containing the point q.
+     */
+    DrawableTrapezoid* queryFaceContaininingPoint(const cg3::Point2d& q, const DAGNode* start) const;
+
     /**
      * @brief queryLeftmostFaceIntersectingSegment visits the DAG searching for the trapezoid containing the leftmost endpoint of a given (ordered)segment
      * @param s         the query orderedsegment.
@@ -44,6 +56,32 @@ public:
      */
     DrawableTrapezoid* queryLeftmostFaceIntersectingSegment(const OrderedSegment& s) const;
 
+    /**
+     * @brief queryFacesIntersectingBox visits all the nodes of the DAG whose region can intersect a box, collecting the trapezoids reached.
+     * The regions are tested conservatively: some of the trapezoids found could not intersect the box, but all the ones intersecting it are found.
+     * @param box               the query box.
+     * @param [out] faces       the trapezoids found (each one only once) are appended to this list.
+     */
+    void queryFacesIntersectingBox(const cg3::BoundingBox2& box, std::vector<DrawableTrapezoid*>& faces) const;
+
+    /**
+     * @brief queryFacesIntersectingSegment visits all the nodes of the DAG whose region can intersect a segment, collecting the trapezoids reached.
+     * Unlike queryLeftmostFaceIntersectingSegment, the segment can cross the segments stored in the DAG.
+     * The regions are tested conservatively: some of the trapezoids found could not intersect the segment, but all the ones intersecting it are found.
+     * @param s                 the query segment.
+     * @param [out] faces       the trapezoids found (each one only once) are appended to this list.
+     */
+    void queryFacesIntersectingSegment(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& faces) const;
+
+    // returns the pointer to the root of the DAG (nullptr if the DAG has not been initialized yet)
+    const DAGNode* getRoot() const;
+
+    // returns the number of nodes of the DAG
+    size_t getNodeNumber() const;
+
+    // returns the number of bytes used by the nodes of the DAG (the trapezoids pointed by the leaves are not counted)
+    size_t getMemoryFootprint() const;
+
 
 private:
     // pointer to the root of the DAG
@@ -55,12 +93,14 @@ private:
      * * if an already freed memory was freed, a runtime error would occur
      */
     std::vector<DAGNode*> uniquePointers;
+    // protects uniquePointers: the concurrent insertion (TrapezoidalMap::addSegments) replaces different leaves at the same time
+    std::mutex uniquePointersMutex;
 
     //////////////////////////////////////////////// NODE GENERATORS ////////////////////////////////////////////////
     /// \brief they create nodes and save them in the DAG.
-    /// \param The paramater can be a pointer to a point, to an ordered segment or to a trapezoid.
-    DAGNode* generateNode(const cg3::Point2d* const pointToStore);
-    DAGNode* generateNode(const OrderedSegment* const segmentToStore);
+    /// \param The paramater can be a point, an ordered segment (both copied inside the node) or a pointer to a trapezoid.
+    DAGNode* generateNode(const cg3::Point2d& pointToStore);
+    DAGNode* generateNode(const OrderedSegment& segmentToStore);
     DAGNode* generateNode(DrawableTrapezoid* const trapezoidToStore);
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -72,7 +112,29 @@ private:
      * @param root          the current node of the DAG to visit.
      * @return              the trapezoid containing the leftmost point of the segment.
      */
-    DrawableTrapezoid* queryRec(const OrderedSegment& new_segment, DAGNode* const root) const;
+    DrawableTrapezoid* queryRec(const OrderedSegment& new_segment, const DAGNode* const root) const;
+
+    /**
+     * @brief queryBoxRec       is a private method that visits recursively the nodes whose region can intersect a box. It's used by queryFacesIntersectingBox.
+     * @param box               the query box.
+     * @param node              the current node of the DAG to visit.
+     * @param visited           [in/out] the nodes already visited (a node can be reached from several parents).
+     * @param faces             [out] the trapezoids found are appended to this list.
+     */
+    void queryBoxRec(const cg3::BoundingBox2& box, const DAGNode* const node, std::unordered_set<const DAGNode*>& visited, std::vector<DrawableTrapezoid*>& faces) const;
+
+    /**
+     * @brief querySegmentRec   is a private method that visits recursively the nodes whose region can intersect a segment. It's used by queryFacesIntersectingSegment.
+     * @param s                 the query segment.
+     * @param node              the current node of the DAG to visit.
+     * @param visited           [in/out] the nodes already visited (a node can be reached from several parents).
+     * @param faces             [out] the trapezoids found are appended to this list.
+     */
+    void querySegmentRec(const OrderedSegment& s, const DAGNode* const node, std::unordered_set<const DAGNode*>& visited, std::vector<DrawableTrapezoid*>& faces) const;
+
+    // returns the y-value of the line passing through a segment (or the segment stored by a y-node) at a given x
+    static double yOnLine(const OrderedSegment& s, const double x);
+    static double yOnLine(const DAGNode::SegmentCoordinates& s, const double x);
 };
 
 
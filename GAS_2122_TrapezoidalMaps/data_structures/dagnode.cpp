@@ -3,15 +3,19 @@
 
 
 /////////// STATIC NODE GENERATORS ////////////////////////////
-DAGNode* DAGNode::generateXNode(const cg3::Point2d* const p) {
+DAGNode* DAGNode::generateXNode(const cg3::Point2d& p) {
     DAGNode::info info;
-    info.p = p;
+    info.p.x = p.x();
+    info.p.y = p.y();
     return DAGNode::newNode(x_node, info);
 }
 
-DAGNode* DAGNode::generateYNode(const OrderedSegment* const s) {
+DAGNode* DAGNode::generateYNode(const OrderedSegment& s) {
     DAGNode::info info;
-    info.s = s;
+    info.s.x1 = s.getLeftmost().x();
+    info.s.y1 = s.getLeftmost().y();
+    info.s.x2 = s.getRightmost().x();
+    info.s.y2 = s.getRightmost().y();
     return DAGNode::newNode(y_node, info);
 }
 
@@ -63,13 +67,13 @@ bool DAGNode::isXNode() const {
 bool DAGNode::isYNode() const {
     return getNodeType() == y_node;
 }
-const cg3::Point2d* DAGNode::getPointStored() const {
-    if(!isXNode()) return nullptr;
-    return this->value.p;
+cg3::Point2d DAGNode::getPointStored() const {
+    assert(isXNode());
+    return cg3::Point2d(this->value.p.x, this->value.p.y);
 }
-const OrderedSegment* DAGNode::getOrientedSegmentStored() const {
-    if(!isYNode()) return nullptr;
-    return this->value.s;
+OrderedSegment DAGNode::getOrientedSegmentStored() const {
+    assert(isYNode());
+    return OrderedSegment(cg3::Point2d(this->value.s.x1, this->value.s.y1), cg3::Point2d(this->value.s.x2, this->value.s.y2));
 }
 DrawableTrapezoid* DAGNode::getTrapezoidStored() const {
     if(!isLeaf()) return nullptr;
@@ -79,14 +83,17 @@ DrawableTrapezoid* DAGNode::getTrapezoidStored() const {
 
 
 ////////////////////////////// CONVERTERS ////////////////////////////
-void DAGNode::convertToXNode(const cg3::Point2d* const p) {
+void DAGNode::convertToXNode(const cg3::Point2d& p) {
     this->type = x_node;
-    this->value.p = p;
-
+    this->value.p.x = p.x();
+    this->value.p.y = p.y();
 }
-void DAGNode::convertToYNode(const OrderedSegment* const s) {
+void DAGNode::convertToYNode(const OrderedSegment& s) {
     this->type = y_node;
-    this->value.s = s;
+    this->value.s.x1 = s.getLeftmost().x();
+    this->value.s.y1 = s.getLeftmost().y();
+    this->value.s.x2 = s.getRightmost().x();
+    this->value.s.y2 = s.getRightmost().y();
 }
 void DAGNode::convertToLeafNode(DrawableTrapezoid* const t) {
     this->type = leaf;
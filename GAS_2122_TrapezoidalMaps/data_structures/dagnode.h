@@ -1,6 +1,8 @@
 #ifndef DAGNODE_H
 #define DAGNODE_H
 
+#include <limits>
+
 #include "cg3/geometry/point2.h"
 #include "orderedsegment.h"
 #include "drawables/drawabletrapezoid.h"
@@ -17,34 +19,39 @@ public:
      */
     enum nodeType {x_node, y_node, leaf};
 
+    // The endpoints of the segment stored by a y-node: (x1, y1) is the leftmost one
+    struct SegmentCoordinates { double x1, y1, x2, y2; };
+
 
     /**
-     * @brief The info union represents the type of information pointed by a node. A node can point to a:
-     *      point,
-     *      segment,
-     *      or a trapezoid.
-     *      The union allow us to save some space and it's suitable to our needs since only 1 of the 3 pointer will be stored in a given moment.
+     * @brief The info union represents the information stored by a node. A node can store:
+     *      a point (x-node),
+     *      the two endpoints of a segment (y-node),
+     *      or a pointer to a trapezoid (leaf).
+     *      The point and the segment are stored inline (and not by pointer), so a comparison during a query
+     *      touches only the node and doesn't need to dereference other objects.
+     *      The union allow us to save some space and it's suitable to our needs since only 1 of the 3 fields will be stored in a given moment.
      */
     union info {
-        const cg3::Point2d* p;
-        const OrderedSegment* s;
+        struct { double x, y; } p;
+        SegmentCoordinates s;
         DrawableTrapezoid* t;
     };
 
     /////////// STATIC NODE GENERATORS: they generate a new node given the information to store in input ////////////////////////////
     /**
-     * @brief generateXNode creates an x-node containing a pointer to a given point.
-     * @param p         the pointer to the point to store inside the node.
+     * @brief generateXNode creates an x-node containing a copy of a given point.
+     * @param p         the point to store inside the node.
      * @return          the pointer to new node created.
      */
-    static DAGNode* generateXNode(const cg3::Point2d* const p);
+    static DAGNode* generateXNode(const cg3::Point2d& p);
 
     /**
-     * @brief generateYNode creates a y-node containing a pointer to a given ordered segment.
-     * @param s         the pointer to the orderedsegment to store inside the node.
+     * @brief generateYNode creates a y-node containing a copy of the endpoints of a given ordered segment.
+     * @param s         the orderedsegment to store inside the node.
      * @return          the pointer to the new node created.
      */
-    static DAGNode* generateYNode(const OrderedSegment* const s);
+    static DAGNode* generateYNode(const OrderedSegment& s);
 
     /**
      * @brief generateLeafNode creates a leaf containing a pointer to a given trapezoid.
@@ -80,11 +87,23 @@ public:
     // return true if this node is a y-node, false otherwise
     bool isYNode() const;
 
-    // return the point pointed by this node if it's a x-node, nullptr otherwise
-    const cg3::Point2d* getPointStored() const;
+    // return the point stored by this node. The node must be a x-node.
+    cg3::Point2d getPointStored() const;
+
+    // return the oriented segment stored by this node. The node must be a y-node.
+    OrderedSegment getOrientedSegmentStored() const;
+
+    // return the endpoints of the segment stored by this node, without building a segment (the queries use it). The node must be a y-node.
+    const SegmentCoordinates& getSegmentCoordinates() const;
 
-    // return the oriented segment pointed by this node if it's a y-node, nullptr otherwise
-    const OrderedSegment* getOrientedSegmentStored() const;
+    /**
+     * @brief isPointAbove/isPointBelow     the orientation tests of cg3::isPointAtLeft/isPointAtRight (with the same tolerance) against
+     *                                      the segment stored by this node, computed on its coordinates. The node must be a y-node.
+     * @param q                             the point.
+     * @return                              true if the point is strictly above/below the line through the segment.
+     */
+    bool isPointAbove(const cg3::Point2d& q) const;
+    bool isPointBelow(const cg3::Point2d& q) const;
 
     // return the (drawable) trapezoid pointed by this node if it's a leaf, nullptr otherwise
     DrawableTrapezoid* getTrapezoidStored() const;
@@ -95,15 +114,15 @@ public:
     ////////////////////////////// CONVERTERS: they convert this node into another (e.g. from leaf to x-node) ////////////////////////////
     /**
      * @brief convertToXNode    converts this node into a x-node node.
-     * @param p                 the pointer to the point to store inside the node.
+     * @param p                 the point to store inside the node.
      */
-    void convertToXNode(const cg3::Point2d* const p);
+    void convertToXNode(const cg3::Point2d& p);
 
     /**
      * @brief convertToYNode    converts this node into a y-node node.
-     * @param s                 the pointer to the orderedsegment to store inside the node.
+     * @param s                 the orderedsegment to store inside the node.
      */
-    void convertToYNode(const OrderedSegment* const s);
+    void convertToYNode(const OrderedSegment& s);
 
     /**
      * @brief convertToLeafNode     converts this node into a leaf.
@@ -120,8 +139,26 @@ public:
 private:
     // the type of this node
     nodeType type;
-    // the (union containing the) value pointed by this node
+    // the (union containing the) value stored by this node
     info value;
+
+    // the orientation determinant of a point with respect to the segment stored (positive above it)
+    double orientation(const cg3::Point2d& q) const;
 };
 
+// The accessors of the y-nodes are inline: they're used at every step of the queries
+inline const DAGNode::SegmentCoordinates& DAGNode::getSegmentCoordinates() const {
+    return this->value.s;
+}
+inline double DAGNode::orientation(const cg3::Point2d& q) const {
+    const SegmentCoordinates& s = this->value.s;
+    return (s.x2 - s.x1) * (q.y() - s.y1) - (s.y2 - s.y1) * (q.x() - s.x1);
+}
+inline bool DAGNode::isPointAbove(const cg3::Point2d& q) const {
+    return orientation(q) > std::numeric_limits<double>::epsilon();
+}
+inline bool DAGNode::isPointBelow(const cg3::Point2d& q) const {
+    return orientation(q) < -std::numeric_limits<double>::epsilon();
+}
+
 #endif // DAGNODE_H
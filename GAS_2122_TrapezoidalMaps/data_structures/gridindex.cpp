@@ -0,0 +1,123 @@
+#include "gridindex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cg3/geometry/utils2.h"
+
+const size_t GridIndex::MAX_RESOLUTION;
+
+/// CONSTRUCTORS ///
+GridIndex::GridIndex() {}
+
+GridIndex::GridIndex(const TrapezoidalMap& map) {
+    build(map);
+}
+///////////////////////////////////////
+
+
+void GridIndex::build(const TrapezoidalMap& map) {
+    clear();
+    assert(map.getDAG().getRoot() != nullptr);
+
+    this->map = &map;
+    B = map.getBoundingBox();
+
+    // About one cell for each segment (at least one cell)
+    resolution = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(map.segmentNumber()))));
+    resolution = std::max<size_t>(1, std::min(resolution, MAX_RESOLUTION));
+    cellWidth = B.lengthX() / resolution;
+    cellHeight = B.lengthY() / resolution;
+
+    /* The region of each cell is enlarged by a small tolerance: a point assigned to a cell by pointLocation
+     * could be slightly outside the cell computed here because of the rounding. */
+    const double toleranceX = 1e-9 * B.lengthX();
+    const double toleranceY = 1e-9 * B.lengthY();
+
+    const DAGNode* root = map.getDAG().getRoot();
+    cells.resize(resolution * resolution);
+    for(size_t j = 0; j < resolution; j++) {
+        for(size_t i = 0; i < resolution; i++) {
+            const cg3::Point2d min(B.min().x() + i * cellWidth - toleranceX, B.min().y() + j * cellHeight - toleranceY);
+            const cg3::Point2d max(B.min().x() + (i+1) * cellWidth + toleranceX, B.min().y() + (j+1) * cellHeight + toleranceY);
+            cells[j * resolution + i] = deepestNodeContainingCell(root, cg3::BoundingBox2(min, max));
+        }
+    }
+}
+
+DrawableTrapezoid* GridIndex::pointLocation(const cg3::Point2d& pointToQuery) const {
+    assert(map != nullptr);
+
+    // The points outside the bounding box are searched from the root
+    if(!B.isInside(pointToQuery))
+        return map->pointLocation(pointToQuery);
+
+    // Find the cell (the points on the max boundary belong to the last cell)
+    const size_t i = std::min(resolution - 1, static_cast<size_t>((pointToQuery.x() - B.min().x()) / cellWidth));
+    const size_t j = std::min(resolution - 1, static_cast<size_t>((pointToQuery.y() - B.min().y()) / cellHeight));
+
+    return map->getDAG().queryFaceContaininingPoint(pointToQuery, cells[j * resolution + i]);
+}
+
+size_t GridIndex::getResolution() const {
+    return resolution;
+}
+
+size_t GridIndex::getRootCellNumber() const {
+    if(map == nullptr)
+        return 0;
+    return static_cast<size_t>(std::count(cells.begin(), cells.end(), map->getDAG().getRoot()));
+}
+
+size_t GridIndex::getMemoryFootprint() const {
+    return cells.capacity() * sizeof(const DAGNode*);
+}
+
+void GridIndex::clear() {
+    cells.clear();
+    resolution = 0;
+    map = nullptr;
+}
+
+
+const DAGNode* GridIndex::deepestNodeContainingCell(const DAGNode* root, const cg3::BoundingBox2& cell) {
+    const cg3::Point2d corners[4] = {
+        cell.min(), cg3::Point2d(cell.max().x(), cell.min().y()),
+        cell.max(), cg3::Point2d(cell.min().x(), cell.max().y())
+    };
+
+    const DAGNode* node = root;
+    while(!node->isLeaf()) {
+        if(node->isXNode()) {
+            const cg3::Point2d& p = node->getPointStored();
+            // the whole cell is on the left of the point (lexicographically, as in the query) => go left
+            if(cell.max() < p)
+                node = node->lc;
+            // the whole cell is on the right of the point (or on it) => go right
+            else if(!(cell.min() < p))
+                node = node->rc;
+            // the (sheared) vertical line through the point cuts the cell
+            else
+                break;
+        }
+        else {
+            // a cell is convex: if its 4 corners are on the same side of the line, the whole cell is on that side
+            size_t above = 0, below = 0;
+            for(const cg3::Point2d& corner : corners) {
+                if(node->isPointAbove(corner))
+                    above++;
+                else if(node->isPointBelow(corner))
+                    below++;
+            }
+
+            if(above == 4)
+                node = node->lc;
+            else if(below == 4)
+                node = node->rc;
+            // the segment cuts the cell (or touches it)
+            else
+                break;
+        }
+    }
+    return node;
+}
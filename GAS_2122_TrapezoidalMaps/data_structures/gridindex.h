@@ -0,0 +1,80 @@
+#ifndef GRIDINDEX_H
+#define GRIDINDEX_H
+
+#include <vector>
+
+#include "cg3/geometry/point2.h"
+#include "cg3/geometry/bounding_box2.h"
+#include "trapezoidalmap.h"
+#include "pointlocator.h"
+
+/**
+ * @brief The GridIndex class is a uniform grid over the bounding box of a trapezoidal map, used to skip the first levels of the DAG.
+ * Each cell stores the deepest DAG node whose region contains the whole cell (a leaf if the cell is inside a single trapezoid):
+ * a query starts the visit of the DAG from the node of its cell instead of the root.
+ * A cell cut by the segments close to the root of the DAG stores a node near the root (at worst the root itself),
+ * so the memory is bounded by the number of cells.
+ *
+ * The index remains valid if new segments are inserted into the map, since the DAG replaces its leaves in place:
+ * the nodes stored still contain their cells, they just become less deep. It has to be built again if the map is cleared.
+ */
+class GridIndex : public PointLocator
+{
+public:
+    // Constructor: it creates an empty index
+    GridIndex();
+    // Constructor: it builds the index of the map given in input
+    GridIndex(const TrapezoidalMap& map);
+
+    /**
+     * @brief build     builds the grid over a trapezoidal map. The previous content is discarded.
+     *                  The resolution is chosen from the number of segments of the map (about one cell for each segment).
+     * @param map       the trapezoidal map. It must outlive the index.
+     */
+    void build(const TrapezoidalMap& map);
+
+    /**
+     * @brief pointLocation     query a point starting from the DAG node stored in its cell.
+     * @param pointToQuery      the query point.
+     * @return                  the (drawable) trapezoid containing the query point (the same returned by TrapezoidalMap::pointLocation).
+     */
+    DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery) const;
+
+    // returns the number of cells on each side of the grid
+    size_t getResolution() const;
+
+    // returns the number of cells storing the root of the DAG (i.e. no level is skipped)
+    size_t getRootCellNumber() const;
+
+    // returns the number of bytes used by the grid
+    size_t getMemoryFootprint() const;
+
+    // removes all the cells of the grid
+    void clear();
+
+private:
+    // maximum number of cells on each side of the grid
+    static const size_t MAX_RESOLUTION = 2048;
+
+    // the DAG node of each cell, row by row (the cell (i, j) is at position j * resolution + i)
+    std::vector<const DAGNode*> cells;
+    size_t resolution = 0;
+
+    // the map whose DAG is indexed
+    const TrapezoidalMap* map = nullptr;
+
+    // the bounding box of the grid and the size of a cell
+    cg3::BoundingBox2 B;
+    double cellWidth = 0;
+    double cellHeight = 0;
+
+    /**
+     * @brief deepestNodeContainingCell     descends the DAG as long as all the points of a cell follow the same path.
+     * @param root                          the node from which the descent starts.
+     * @param cell                          the region of the cell.
+     * @return                              the last node reached by the whole cell.
+     */
+    static const DAGNode* deepestNodeContainingCell(const DAGNode* root, const cg3::BoundingBox2& cell);
+};
+
+#endif // GRIDINDEX_H
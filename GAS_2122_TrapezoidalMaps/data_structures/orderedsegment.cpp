@@ -1,10 +1,12 @@
 #include "orderedsegment.h"
 
-OrderedSegment::OrderedSegment(const cg3::Segment2d unordered_s)  : cg3::Segment2d(unordered_s) {
+const size_t OrderedSegment::NO_ID;
+
+OrderedSegment::OrderedSegment(const cg3::Segment2d unordered_s, const size_t id)  : cg3::Segment2d(unordered_s), id(id) {
     orderSegment();
 }
 
-OrderedSegment::OrderedSegment(const cg3::Point2d unordered_p1, const cg3::Point2d unordered_p2) : cg3::Segment2d(unordered_p1, unordered_p2)  {
+OrderedSegment::OrderedSegment(const cg3::Point2d unordered_p1, const cg3::Point2d unordered_p2, const size_t id) : cg3::Segment2d(unordered_p1, unordered_p2), id(id)  {
     orderSegment();
 }
 
@@ -16,9 +18,26 @@ const cg3::Point2d& OrderedSegment::getRightmost() const  {
     return this->p2();
 }
 
+size_t OrderedSegment::getId() const {
+    return this->id;
+}
+
+size_t OrderedSegment::getPolygonId() const {
+    return this->polygonId;
+}
+
+bool OrderedSegment::isPolygonInteriorAbove() const {
+    return this->polygonInteriorAbove;
+}
+
+void OrderedSegment::setPolygon(const size_t polygonId, const bool interiorAbove) {
+    this->polygonId = polygonId;
+    this->polygonInteriorAbove = interiorAbove;
+}
+
 void OrderedSegment::orderSegment() {
-    // if p1.x > p2.x => swap the points
-    if(this->p1().x() > this->p2().x()) {
+    // if p1 > p2 (lexicographically: p1.x > p2.x, or p1.x = p2.x and p1.y > p2.y) => swap the points
+    if(this->p2() < this->p1()) {
         cg3::Point2d tmp = this->p1();
         setP1(this->p2());
         setP2(tmp);
@@ -4,33 +4,61 @@
 #include "cg3/geometry/segment2.h"
 #include "cg3/geometry/point2.h"
 
+#include <limits>
+
 
 // Class created because we need to know the leftmost/rightmost verteces of a segment but I don't want to check it every time a runtime...
 /**
  * @extends cg3::Segment2d
  * @brief The OrderedSegment class represents a segment sorted by the x-value (from the endpoint with smallest x to the endpoint with highest x).
- * I recall segments are in general position, ergo the two endpoints of the segment cannot have the same x-value.
+ * The endpoints are compared lexicographically (by x, then by y), as if the plane were sheared by an infinitesimal amount:
+ * two points with the same x-value are never on the same vertical line, so a vertical segment goes from its bottom endpoint to the top one.
  */
 class OrderedSegment : public cg3::Segment2d
 {
 public:
+    // Id of the segments that don't come from the input (e.g. the edges of the bounding box)
+    static const size_t NO_ID = std::numeric_limits<size_t>::max();
+
     // Trivial constructors
-    OrderedSegment(const cg3::Segment2d unordered_s);
-    OrderedSegment(const cg3::Point2d unordered_p1, const cg3::Point2d unordered_p2);
+    OrderedSegment(const cg3::Segment2d unordered_s, const size_t id = NO_ID);
+    OrderedSegment(const cg3::Point2d unordered_p1, const cg3::Point2d unordered_p2, const size_t id = NO_ID);
 
     /**
      * @brief getLeftmost
-     * @return the endpoint of the segment with SMALLEST x-value.
+     * @return the endpoint of the segment with SMALLEST x-value (the bottom one if the segment is vertical).
      */
     const cg3::Point2d& getLeftmost() const;
 
     /**
      * @brief getRightmost
-     * @return the endpoint of the segment with HIGHEST x-value.
+     * @return the endpoint of the segment with HIGHEST x-value (the top one if the segment is vertical).
      */
     const cg3::Point2d& getRightmost() const;
 
+    // returns the id of the input segment (NO_ID if the segment doesn't come from the input)
+    size_t getId() const;
+
+    // returns the id of the polygon having the segment as edge (NO_ID if the segment is not an edge of a polygon)
+    size_t getPolygonId() const;
+    // returns true if the interior of the polygon is above the segment, false if it's below
+    bool isPolygonInteriorAbove() const;
+
+    /**
+     * @brief setPolygon        marks the segment as an edge of a polygon.
+     * @param polygonId         the id of the polygon.
+     * @param interiorAbove     true if the interior of the polygon is above the segment, false if it's below.
+     */
+    void setPolygon(const size_t polygonId, const bool interiorAbove);
+
 private:
+    // id of the input segment
+    size_t id;
+
+    // id of the polygon having the segment as edge, and the side of its interior
+    size_t polygonId = NO_ID;
+    bool polygonInteriorAbove = false;
+
     /**
      * @brief orderSegment sort the two endpoints if there's need.
      * At the end the inheritated attribute "p1" will contain the leftmost point,
@@ -0,0 +1,158 @@
+#include "packedaabbtree.h"
+
+#include <algorithm>
+#include <limits>
+
+PackedAABBTree::PackedAABBTree() {}
+
+PackedAABBTree::PackedAABBTree(const std::vector<cg3::Segment2d>& segments) {
+    build(segments);
+}
+
+void PackedAABBTree::build(const std::vector<cg3::Segment2d>& newSegments) {
+    clear();
+    if(newSegments.empty())
+        return;
+
+    std::vector<uint32_t> order(newSegments.size());
+    std::vector<cg3::Point2d> centers(newSegments.size());
+    for(size_t i = 0; i < newSegments.size(); i++) {
+        order[i] = static_cast<uint32_t>(i);
+        centers[i] = (newSegments[i].p1() + newSegments[i].p2()) * 0.5;
+    }
+
+    // The leaves hold at least LEAF_SIZE / 2 segments, and there are less than twice as many nodes as leaves
+    nodes.reserve(4 * newSegments.size() / LEAF_SIZE + 1);
+    buildHelper(newSegments, order, centers, 0, order.size());
+
+    // The segments are stored in the order of the leaves, so a leaf reads a contiguous range
+    segments.reserve(order.size());
+    boxes.reserve(order.size());
+    for(uint32_t i : order) {
+        segments.push_back(newSegments[i]);
+        boxes.push_back(segmentBox(newSegments[i]));
+    }
+}
+
+void PackedAABBTree::buildHelper(
+        const std::vector<cg3::Segment2d>& source,
+        std::vector<uint32_t>& order,
+        const std::vector<cg3::Point2d>& centers,
+        size_t begin,
+        size_t end)
+{
+    const size_t index = nodes.size();
+    nodes.push_back(Node());
+
+    Box box = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+               std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+    Box centerBox = box;
+    for(size_t i = begin; i < end; i++) {
+        const Box segment = segmentBox(source[order[i]]);
+        box.minX = std::min(box.minX, segment.minX);
+        box.minY = std::min(box.minY, segment.minY);
+        box.maxX = std::max(box.maxX, segment.maxX);
+        box.maxY = std::max(box.maxY, segment.maxY);
+        const cg3::Point2d& center = centers[order[i]];
+        centerBox.minX = std::min(centerBox.minX, center.x());
+        centerBox.minY = std::min(centerBox.minY, center.y());
+        centerBox.maxX = std::max(centerBox.maxX, center.x());
+        centerBox.maxY = std::max(centerBox.maxY, center.y());
+    }
+
+    if(end - begin <= LEAF_SIZE) {
+        nodes[index].first = static_cast<uint32_t>(begin);
+        nodes[index].count = static_cast<uint32_t>(end - begin);
+    }
+    else {
+        // Median split along the axis where the centers are more spread out
+        const bool alongX = centerBox.maxX - centerBox.minX >= centerBox.maxY - centerBox.minY;
+        const size_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](uint32_t a, uint32_t b) {
+            return alongX ? centers[a].x() < centers[b].x() : centers[a].y() < centers[b].y();
+        });
+        buildHelper(source, order, centers, begin, middle);
+        buildHelper(source, order, centers, middle, end);
+        nodes[index].first = 0;
+        nodes[index].count = 0;
+    }
+    nodes[index].box = box;
+    nodes[index].next = static_cast<uint32_t>(nodes.size());
+}
+
+// Calls visitor(s) for each segment s of the tree intersecting the given one, until it returns true
+template<class Visitor>
+void PackedAABBTree::visitOverlaps(const cg3::Segment2d& segment, SegmentOverlapChecker overlapChecker, Visitor visitor) const {
+    const Box box = segmentBox(segment);
+    size_t i = 0;
+    while(i < nodes.size()) {
+        const Node& node = nodes[i];
+        if(!overlaps(box, node.box)) {
+            i = node.next;
+            continue;
+        }
+        if(node.count > 0) {
+            for(size_t j = node.first; j < node.first + node.count; j++) {
+                if(overlaps(box, boxes[j]) && overlapChecker(segment, segments[j]) && visitor(segments[j]))
+                    return;
+            }
+        }
+        // the first child of an internal node is the next node, the node after a leaf is the next one too
+        i++;
+    }
+}
+
+size_t PackedAABBTree::countOverlaps(const cg3::Segment2d& segment, SegmentOverlapChecker overlapChecker) const {
+    size_t count = 0;
+    visitOverlaps(segment, overlapChecker, [&count](const cg3::Segment2d&) {
+        count++;
+        return false;
+    });
+    return count;
+}
+
+bool PackedAABBTree::checkOverlap(const cg3::Segment2d& segment, SegmentOverlapChecker overlapChecker) const {
+    bool found = false;
+    visitOverlaps(segment, overlapChecker, [&found](const cg3::Segment2d&) {
+        found = true;
+        return true;
+    });
+    return found;
+}
+
+bool PackedAABBTree::findOverlap(const cg3::Segment2d& segment, SegmentOverlapChecker overlapChecker, cg3::Segment2d& overlapping) const {
+    bool found = false;
+    visitOverlaps(segment, overlapChecker, [&found, &overlapping](const cg3::Segment2d& other) {
+        found = true;
+        overlapping = other;
+        return true;
+    });
+    return found;
+}
+
+const std::vector<cg3::Segment2d>& PackedAABBTree::getSegments() const {
+    return segments;
+}
+
+size_t PackedAABBTree::size() const {
+    return segments.size();
+}
+
+bool PackedAABBTree::empty() const {
+    return segments.empty();
+}
+
+void PackedAABBTree::clear() {
+    nodes.clear();
+    segments.clear();
+    boxes.clear();
+}
+
+PackedAABBTree::Box PackedAABBTree::segmentBox(const cg3::Segment2d& segment) {
+    return {std::min(segment.p1().x(), segment.p2().x()), std::min(segment.p1().y(), segment.p2().y()),
+            std::max(segment.p1().x(), segment.p2().x()), std::max(segment.p1().y(), segment.p2().y())};
+}
+
+bool PackedAABBTree::overlaps(const Box& a, const Box& b) {
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
@@ -0,0 +1,99 @@
+#ifndef PACKEDAABBTREE_H
+#define PACKEDAABBTREE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "cg3/geometry/segment2.h"
+
+/**
+ * @brief The PackedAABBTree class is a static bounding volume hierarchy of segments, bulk-loaded with median splits.
+ * The nodes are stored in a flat array in pre-order: the first child of a node is the next one, and each node stores the position
+ * of the node following its subtree, so the tree is visited with a single loop and no stack. The boxes are stored inline in the
+ * nodes and in a copy of the segments, sorted like the leaves. The box tests are plain 2D comparisons, with no call through a
+ * value extractor.
+ *
+ * The tree can't be modified: SegmentIntersectionChecker keeps some of them of decreasing size, and merges them as segments are
+ * inserted.
+ */
+class PackedAABBTree
+{
+public:
+    // Function telling if two segments intersect, called on the pairs whose boxes overlap
+    typedef bool (*SegmentOverlapChecker)(const cg3::Segment2d& seg1, const cg3::Segment2d& seg2);
+
+    // maximum number of segments of a leaf
+    static const size_t LEAF_SIZE = 8;
+
+    // Constructor: it creates an empty tree
+    PackedAABBTree();
+    // Constructor: it builds the tree of the segments given in input
+    PackedAABBTree(const std::vector<cg3::Segment2d>& segments);
+
+    /**
+     * @brief build         builds the tree in O(n log n): each node is split at the median of the centers of its segments,
+     *                      along the axis where they're more spread out. The previous content is discarded.
+     * @param segments      the segments.
+     */
+    void build(const std::vector<cg3::Segment2d>& segments);
+
+    /**
+     * @brief countOverlaps     counts the segments of the tree intersecting a segment.
+     * @param segment           the query segment.
+     * @param overlapChecker    the exact test, called only when the boxes overlap.
+     * @return                  the number of segments for which overlapChecker returned true.
+     */
+    size_t countOverlaps(const cg3::Segment2d& segment, SegmentOverlapChecker overlapChecker) const;
+
+    // Returns true if a segment of the tree intersects the given one (it stops at the first one)
+    bool checkOverlap(const cg3::Segment2d& segment, SegmentOverlapChecker overlapChecker) const;
+
+    // Same as checkOverlap, and it returns the segment of the tree found
+    bool findOverlap(const cg3::Segment2d& segment, SegmentOverlapChecker overlapChecker, cg3::Segment2d& overlapping) const;
+
+    // Returns the segments of the tree (in the order of the leaves)
+    const std::vector<cg3::Segment2d>& getSegments() const;
+
+    size_t size() const;
+    bool empty() const;
+
+    void clear();
+
+private:
+    struct Box {
+        double minX, minY, maxX, maxY;
+    };
+
+    /**
+     * @brief The Node struct is a node of the tree (48 bytes). A leaf has count > 0 and refers to the segments
+     * in [first, first + count); an internal node has count == 0 and its first child is the next node.
+     */
+    struct Node {
+        Box box;
+        // position of the node following the subtree of this one
+        uint32_t next;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    static Box segmentBox(const cg3::Segment2d& segment);
+    static bool overlaps(const Box& a, const Box& b);
+
+    // builds the subtree of the segments in [begin, end) of order (positions in source), appending its nodes
+    void buildHelper(
+            const std::vector<cg3::Segment2d>& source,
+            std::vector<uint32_t>& order,
+            const std::vector<cg3::Point2d>& centers,
+            size_t begin,
+            size_t end);
+
+    template<class Visitor>
+    void visitOverlaps(const cg3::Segment2d& segment, SegmentOverlapChecker overlapChecker, Visitor visitor) const;
+
+    std::vector<Node> nodes;
+    // the segments and their boxes, sorted like the leaves
+    std::vector<cg3::Segment2d> segments;
+    std::vector<Box> boxes;
+};
+
+#endif // PACKEDAABBTREE_H
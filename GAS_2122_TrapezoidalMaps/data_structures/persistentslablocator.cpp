@@ -0,0 +1,397 @@
+#include "persistentslablocator.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "cg3/geometry/utils2.h"
+#include "algorithms/OrientationUtility.h"
+
+const uint32_t PersistentSlabLocator::NIL;
+const uint32_t PersistentSlabLocator::NO_VERSION;
+const uint32_t PersistentSlabLocator::BOUNDINGBOX_BOTTOM;
+
+/// CONSTRUCTORS ///
+PersistentSlabLocator::PersistentSlabLocator() {}
+
+PersistentSlabLocator::PersistentSlabLocator(const TrapezoidalMap& map) {
+    build(map);
+}
+///////////////////////////////////////
+
+
+void PersistentSlabLocator::build(const TrapezoidalMap& map) {
+    assert(map.getDAG().getRoot() != nullptr);
+    build(map.getTrapezoids());
+}
+
+void PersistentSlabLocator::build(const std::vector<DrawableTrapezoid*>& trapezoids) {
+    clear();
+
+    // Index the segments bounding the trapezoids from below: the bottom edge of the bounding box is the only one without id
+    std::unordered_map<const OrderedSegment*, uint32_t> index;
+    std::vector<std::pair<uint32_t, DrawableTrapezoid*>> bottoms;
+    segments.push_back(nullptr);
+    for(DrawableTrapezoid* t : trapezoids) {
+        if(t->getIsBeingSplitted())
+            continue;
+
+        const OrderedSegment* bottom = &t->getBottom();
+        if(bottom->getId() == OrderedSegment::NO_ID) {
+            segments[BOUNDINGBOX_BOTTOM] = bottom;
+            bottoms.push_back(std::make_pair(BOUNDINGBOX_BOTTOM, t));
+            continue;
+        }
+
+        auto inserted = index.insert(std::make_pair(bottom, static_cast<uint32_t>(segments.size())));
+        if(inserted.second)
+            segments.push_back(bottom);
+        bottoms.push_back(std::make_pair(inserted.first->second, t));
+    }
+    assert(segments[BOUNDINGBOX_BOTTOM] != nullptr);
+
+    // The trapezoids above each segment, from left to right
+    std::sort(bottoms.begin(), bottoms.end(), [](const std::pair<uint32_t, DrawableTrapezoid*>& a, const std::pair<uint32_t, DrawableTrapezoid*>& b) {
+        return a.first != b.first ? a.first < b.first : a.second->getLeftp() < b.second->getLeftp();
+    });
+    faceOffsets.assign(segments.size() + 1, 0);
+    faces.reserve(bottoms.size());
+    for(const std::pair<uint32_t, DrawableTrapezoid*>& bottom : bottoms) {
+        faceOffsets[bottom.first + 1]++;
+        faces.push_back(bottom.second);
+    }
+    for(size_t i = 1; i < faceOffsets.size(); i++)
+        faceOffsets[i] += faceOffsets[i-1];
+
+    /* The endpoints of the segments (the bounding box is not swept), and the distinct ones delimiting the slabs.
+     * They're sorted lexicographically (symbolic shear): the points with the same x are on distinct slab lines, so a vertical segment spans some slabs too. */
+    std::vector<std::pair<cg3::Point2d, uint32_t>> starting, ending;
+    for(uint32_t i = BOUNDINGBOX_BOTTOM + 1; i < segments.size(); i++) {
+        starting.push_back(std::make_pair(segments[i]->getLeftmost(), i));
+        ending.push_back(std::make_pair(segments[i]->getRightmost(), i));
+        endpoints.push_back(segments[i]->getLeftmost());
+        endpoints.push_back(segments[i]->getRightmost());
+    }
+    std::sort(starting.begin(), starting.end());
+    std::sort(ending.begin(), ending.end());
+    std::sort(endpoints.begin(), endpoints.end());
+    endpoints.erase(std::unique(endpoints.begin(), endpoints.end()), endpoints.end());
+    assert(endpoints.size() < NO_VERSION);
+
+    // The sentinel
+    nodes.push_back({BOUNDINGBOX_BOTTOM, {NIL, NIL}, 0, NO_VERSION, NIL, LEFT});
+    balance.push_back({NIL, NIL, false});
+    nodeOf.assign(segments.size(), NIL);
+
+    /* Sweep: at each endpoint, the segments ending there are removed and the ones starting there are inserted.
+     * The tree obtained is the version of the slab on the right of the endpoint. */
+    size_t nextStarting = 0, nextEnding = 0;
+    roots.reserve(endpoints.size());
+    for(version = 0; version < endpoints.size(); version++) {
+        const cg3::Point2d& p = endpoints[version];
+        for(; nextEnding < ending.size() && ending[nextEnding].first == p; nextEnding++)
+            remove(ending[nextEnding].second);
+        for(; nextStarting < starting.size() && starting[nextStarting].first == p; nextStarting++)
+            insert(starting[nextStarting].second);
+        roots.push_back(root);
+    }
+
+    // The state of the construction is not needed by the queries
+    std::vector<Balance>().swap(balance);
+    std::vector<uint32_t>().swap(nodeOf);
+    nodes.shrink_to_fit();
+}
+
+DrawableTrapezoid* PersistentSlabLocator::pointLocation(const cg3::Point2d& pointToQuery) const {
+    assert(!faces.empty());
+
+    // The slab containing the point (a point on the line of an endpoint belongs to the slab on its right, as in the DAG)
+    const size_t slab = static_cast<size_t>(std::upper_bound(endpoints.begin(), endpoints.end(), pointToQuery) - endpoints.begin());
+
+    // The segment below the point (or through it): the lowest segment above which the point lies, in the version of the slab
+    uint32_t below = BOUNDINGBOX_BOTTOM;
+    if(slab > 0) {
+        const uint32_t v = static_cast<uint32_t>(slab - 1);
+        uint32_t x = roots[v];
+        while(x != NIL) {
+            const Node& node = nodes[x];
+            const OrderedSegment& s = *segments[node.segment];
+            const bool above = !cg3::isPointAtRight(s.getLeftmost(), s.getRightmost(), pointToQuery);
+            if(above)
+                below = node.segment;
+            x = childAt(node, above ? RIGHT : LEFT, v);
+        }
+    }
+
+    // The trapezoid above that segment whose x-range contains the point (the last one if the point is on the right of the segment)
+    const auto first = faces.begin() + faceOffsets[below];
+    const auto last = faces.begin() + faceOffsets[below + 1];
+    const auto face = std::upper_bound(first, last, pointToQuery, [](const cg3::Point2d& q, const DrawableTrapezoid* t) {
+        return q < t->getRightp();
+    });
+    return face != last ? *face : *(last - 1);
+}
+
+size_t PersistentSlabLocator::getSlabNumber() const {
+    return roots.size();
+}
+
+size_t PersistentSlabLocator::getNodeNumber() const {
+    // the sentinel is not counted
+    return nodes.empty() ? 0 : nodes.size() - 1;
+}
+
+size_t PersistentSlabLocator::getMemoryFootprint() const {
+    return nodes.capacity() * sizeof(Node) + roots.capacity() * sizeof(uint32_t) + endpoints.capacity() * sizeof(cg3::Point2d) +
+           segments.capacity() * sizeof(const OrderedSegment*) + faceOffsets.capacity() * sizeof(size_t) +
+           faces.capacity() * sizeof(DrawableTrapezoid*);
+}
+
+void PersistentSlabLocator::clear() {
+    nodes.clear();
+    roots.clear();
+    endpoints.clear();
+    segments.clear();
+    faceOffsets.clear();
+    faces.clear();
+    version = 0;
+    root = NIL;
+    balance.clear();
+    nodeOf.clear();
+}
+
+
+uint32_t PersistentSlabLocator::childAt(const Node& node, const side s, const uint32_t v) {
+    return node.modVersion <= v && node.modChild == s ? node.modPointer : node.children[s];
+}
+
+///////////////////////////////////// Last version /////////////////////////////////////
+uint32_t PersistentSlabLocator::current(uint32_t x) const {
+    while(balance[x].forward != NIL)
+        x = balance[x].forward;
+    return x;
+}
+
+uint32_t PersistentSlabLocator::child(const uint32_t x, const side s) const {
+    return childAt(nodes[current(x)], s, version);
+}
+
+uint32_t PersistentSlabLocator::parent(const uint32_t x) const {
+    return balance[current(x)].parent;
+}
+
+bool PersistentSlabLocator::isRed(const uint32_t x) const {
+    return balance[current(x)].red;
+}
+
+void PersistentSlabLocator::setParent(const uint32_t x, const uint32_t p) {
+    balance[current(x)].parent = current(p);
+}
+
+void PersistentSlabLocator::setRed(const uint32_t x, const bool red) {
+    assert(!red || x != NIL);
+    balance[current(x)].red = red;
+}
+
+PersistentSlabLocator::side PersistentSlabLocator::sideOf(const uint32_t x) const {
+    return child(parent(x), LEFT) == current(x) ? LEFT : RIGHT;
+}
+
+void PersistentSlabLocator::setChild(uint32_t x, const side s, uint32_t c) {
+    x = current(x);
+    c = current(c);
+    assert(x != NIL);
+
+    Node& node = nodes[x];
+    // The node belongs only to this version: it can be modified
+    if(node.version == version) {
+        node.children[s] = c;
+        return;
+    }
+    // The extra pointer is free (or it's the same child, already changed by this version)
+    if(node.modVersion == NO_VERSION || (node.modVersion == version && node.modChild == s)) {
+        node.modVersion = version;
+        node.modChild = s;
+        node.modPointer = c;
+        return;
+    }
+
+    // The node is full: it's copied with the children of the last version
+    Node copy = {node.segment, {child(x, LEFT), child(x, RIGHT)}, version, NO_VERSION, NIL, LEFT};
+    copy.children[s] = c;
+    const uint32_t y = static_cast<uint32_t>(nodes.size());
+    assert(y < std::numeric_limits<uint32_t>::max());
+    nodes.push_back(copy);
+    balance.push_back({balance[x].parent, NIL, balance[x].red});
+    balance[x].forward = y;
+    nodeOf[copy.segment] = y;
+
+    for(uint32_t newChild : copy.children)
+        if(newChild != NIL)
+            balance[newChild].parent = y;
+
+    /* The copy replaces the node in its parent. The node could be detached from the tree during a removal
+     * (its parent doesn't point to it anymore): in that case the copy is attached later, as the node would be. */
+    const uint32_t p = balance[y].parent;
+    if(p == NIL) {
+        if(root == x)
+            root = y;
+    }
+    else if(child(p, LEFT) == x)
+        setChild(p, LEFT, y);
+    else if(child(p, RIGHT) == x)
+        setChild(p, RIGHT, y);
+}
+
+void PersistentSlabLocator::rotate(const uint32_t x, const side s) {
+    const side other = s == LEFT ? RIGHT : LEFT;
+    const uint32_t y = child(x, other);
+    const uint32_t middle = child(y, s);
+    assert(y != NIL);
+
+    // the subtree between x and y changes parent
+    setChild(x, other, middle);
+    if(middle != NIL)
+        setParent(middle, x);
+
+    // y takes the place of x
+    const uint32_t p = parent(x);
+    setParent(y, p);
+    if(p == NIL)
+        root = current(y);
+    else
+        setChild(p, sideOf(x), y);
+
+    setChild(y, s, x);
+    setParent(x, y);
+}
+
+void PersistentSlabLocator::transplant(const uint32_t u, const uint32_t v) {
+    const uint32_t p = parent(u);
+    if(p == NIL)
+        root = current(v);
+    else
+        setChild(p, sideOf(u), v);
+    setParent(v, p);
+}
+
+void PersistentSlabLocator::insert(const uint32_t segment) {
+    // The new node is a red leaf
+    const uint32_t z = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({segment, {NIL, NIL}, version, NO_VERSION, NIL, LEFT});
+    balance.push_back({NIL, NIL, true});
+    nodeOf[segment] = z;
+
+    uint32_t p = NIL;
+    side s = LEFT;
+    for(uint32_t x = root; x != NIL; x = child(x, s)) {
+        p = x;
+        s = OrientationUtility::isSegmentBelow(*segments[segment], *segments[nodes[x].segment]) ? LEFT : RIGHT;
+    }
+    setParent(z, p);
+    if(p == NIL)
+        root = z;
+    else
+        setChild(p, s, z);
+
+    // Fix the red nodes having a red parent, going up
+    uint32_t x = z;
+    while(isRed(parent(x))) {
+        const uint32_t xParent = parent(x);
+        const uint32_t grandparent = parent(xParent);
+        const side parentSide = sideOf(xParent);
+        const side otherSide = parentSide == LEFT ? RIGHT : LEFT;
+        const uint32_t uncle = child(grandparent, otherSide);
+
+        if(isRed(uncle)) {
+            setRed(xParent, false);
+            setRed(uncle, false);
+            setRed(grandparent, true);
+            x = grandparent;
+        }
+        else {
+            // x is an inner grandchild: it becomes an outer one
+            if(sideOf(x) == otherSide) {
+                x = xParent;
+                rotate(x, parentSide);
+            }
+            setRed(parent(x), false);
+            setRed(grandparent, true);
+            rotate(grandparent, otherSide);
+        }
+    }
+    setRed(root, false);
+}
+
+void PersistentSlabLocator::remove(const uint32_t segment) {
+    const uint32_t z = nodeOf[segment];
+    uint32_t y = z;
+    bool removedRed = isRed(y);
+    uint32_t x;
+
+    if(child(z, LEFT) == NIL) {
+        x = child(z, RIGHT);
+        transplant(z, x);
+    }
+    else if(child(z, RIGHT) == NIL) {
+        x = child(z, LEFT);
+        transplant(z, x);
+    }
+    else {
+        // the successor of z takes its place
+        y = child(z, RIGHT);
+        while(child(y, LEFT) != NIL)
+            y = child(y, LEFT);
+        removedRed = isRed(y);
+        x = child(y, RIGHT);
+
+        if(parent(y) == current(z))
+            setParent(x, y);
+        else {
+            transplant(y, x);
+            setChild(y, RIGHT, child(z, RIGHT));
+            setParent(child(y, RIGHT), y);
+        }
+        transplant(z, y);
+        setChild(y, LEFT, child(z, LEFT));
+        setParent(child(y, LEFT), y);
+        setRed(y, isRed(z));
+    }
+    nodeOf[segment] = NIL;
+
+    if(removedRed)
+        return;
+
+    // x has an extra black: it's moved up until a red node (or the root) takes it
+    while(current(x) != root && !isRed(x)) {
+        const side s = sideOf(x);
+        const side other = s == LEFT ? RIGHT : LEFT;
+        uint32_t sibling = child(parent(x), other);
+
+        if(isRed(sibling)) {
+            setRed(sibling, false);
+            setRed(parent(x), true);
+            rotate(parent(x), s);
+            sibling = child(parent(x), other);
+        }
+
+        if(!isRed(child(sibling, LEFT)) && !isRed(child(sibling, RIGHT))) {
+            setRed(sibling, true);
+            x = parent(x);
+        }
+        else {
+            if(!isRed(child(sibling, other))) {
+                setRed(child(sibling, s), false);
+                setRed(sibling, true);
+                rotate(sibling, other);
+                sibling = child(parent(x), other);
+            }
+            setRed(sibling, isRed(parent(x)));
+            setRed(parent(x), false);
+            setRed(child(sibling, other), false);
+            rotate(parent(x), s);
+            x = root;
+        }
+    }
+    setRed(x, false);
+}
@@ -0,0 +1,155 @@
+#ifndef PERSISTENTSLABLOCATOR_H
+#define PERSISTENTSLABLOCATOR_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "cg3/geometry/point2.h"
+#include "trapezoidalmap.h"
+#include "pointlocator.h"
+
+/**
+ * @brief The PersistentSlabLocator class answers the point location in a trapezoidal map with the classic slab method,
+ * without storing each slab: the vertical lines through the endpoints cut the plane into slabs, and the segments crossing
+ * a slab are the sweep status between two consecutive endpoints. The status is a partially persistent red-black tree
+ * (Sarnak & Tarjan): every slab is a version of the tree, built by the sweep with the deletions and the insertions of its endpoints.
+ *
+ * The persistence uses the node copying: each node has one extra child pointer, tagged with the version that set it.
+ * When a node already used it, the node is copied and the copy replaces it in its parent (which can be copied in turn).
+ * A red-black update changes O(1) pointers (at most 3 rotations) and the colours are needed only by the last version,
+ * so they aren't persistent: the tree takes O(n) memory, and a query is a binary search on the slabs plus a root-to-leaf
+ * path of the version of its slab, i.e. O(log n) in the worst case.
+ *
+ * The trapezoid containing the point is found above the segment below it (the trapezoids above each segment are sorted from left to right).
+ * The trapezoids returned are the ones of the map, so the locator is a snapshot: if new segments are inserted, it has to be built again.
+ */
+class PersistentSlabLocator : public PointLocator
+{
+public:
+    // Constructor: it creates an empty locator
+    PersistentSlabLocator();
+    // Constructor: it builds the locator of the map given in input
+    PersistentSlabLocator(const TrapezoidalMap& map);
+
+    /**
+     * @brief build     sweeps the segments of a trapezoidal map building a version of the tree for each slab. The previous content is discarded.
+     * @param map       the trapezoidal map. It must outlive the locator.
+     */
+    void build(const TrapezoidalMap& map);
+
+    /**
+     * @brief build         same as above, on the trapezoids of a map built in any way (e.g. by SweepTrapezoidalMap): only the trapezoids,
+     *                      their top and bottom segments and their walls are used.
+     * @param trapezoids    the trapezoids of the map (the ones being split are skipped). They must outlive the locator, with their segments.
+     */
+    void build(const std::vector<DrawableTrapezoid*>& trapezoids);
+
+    /**
+     * @brief pointLocation     query a point in the version of the tree of its slab.
+     * @param pointToQuery      the query point.
+     * @return                  the (drawable) trapezoid of the map containing the query point.
+     */
+    DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery) const;
+
+    // returns the number of slabs (i.e. of versions of the tree)
+    size_t getSlabNumber() const;
+
+    // returns the number of nodes of the tree (the nodes of the segments plus their copies)
+    size_t getNodeNumber() const;
+
+    // returns the number of bytes used by the locator
+    size_t getMemoryFootprint() const;
+
+    // removes all the versions of the tree
+    void clear();
+
+private:
+    // index of the empty tree (the sentinel node, always black)
+    static const uint32_t NIL = 0;
+    // version of an unused extra pointer
+    static const uint32_t NO_VERSION = std::numeric_limits<uint32_t>::max();
+    // position of the bottom edge of the bounding box in the list of the segments: it's below every point, so it's not in the tree
+    static const uint32_t BOUNDINGBOX_BOTTOM = 0;
+
+    // sides of a child: the left one is below, the right one is above
+    enum side : uint8_t {LEFT, RIGHT};
+
+    /**
+     * @brief The Node struct is a node of the persistent tree. The two children are the ones of the version creating the node,
+     * then the extra pointer replaces one of them from its version on.
+     */
+    struct Node {
+        uint32_t segment;
+        uint32_t children[2];
+        uint32_t version;
+        uint32_t modVersion;
+        uint32_t modPointer;
+        side modChild;
+    };
+
+    // The fields needed only to update the last version: they are discarded at the end of the construction
+    struct Balance {
+        uint32_t parent;
+        // the copy of the node in the last version (NIL if the node is still in it)
+        uint32_t forward;
+        bool red;
+    };
+
+    // the nodes of all the versions, the first one is NIL
+    std::vector<Node> nodes;
+    // the root of each version: the version k is the status of the slab between endpoints[k] and endpoints[k+1] (sorted lexicographically)
+    std::vector<uint32_t> roots;
+    std::vector<cg3::Point2d> endpoints;
+
+    // the segments of the map: the bottom edge of the bounding box first, then the segments bounding a trapezoid from below
+    std::vector<const OrderedSegment*> segments;
+
+    // the trapezoids above the segment i are faces[faceOffsets[i]...faceOffsets[i+1]-1], sorted from left to right
+    std::vector<size_t> faceOffsets;
+    std::vector<DrawableTrapezoid*> faces;
+
+    // State of the construction: the version being built, its root, the balance fields and the node of each segment
+    uint32_t version = 0;
+    uint32_t root = NIL;
+    std::vector<Balance> balance;
+    std::vector<uint32_t> nodeOf;
+
+    // returns the child of a node in a given version (the extra pointer is used only from its version on)
+    static uint32_t childAt(const Node& node, const side s, const uint32_t v);
+
+    ////////////////// Last version (used by the construction) //////////////////
+    // returns the node replacing a given one in the last version (itself if it hasn't been copied)
+    uint32_t current(uint32_t x) const;
+    uint32_t child(const uint32_t x, const side s) const;
+    uint32_t parent(const uint32_t x) const;
+    bool isRed(const uint32_t x) const;
+    void setParent(const uint32_t x, const uint32_t p);
+    void setRed(const uint32_t x, const bool red);
+
+    // returns the side of a node with respect to its parent
+    side sideOf(const uint32_t x) const;
+
+    /**
+     * @brief setChild  sets a child of a node in the version being built: the node is modified if it has been created in this version
+     *                  or if its extra pointer is free, otherwise it's copied (and the copy replaces it in its parent).
+     * @param x         the node.
+     * @param s         the side of the child.
+     * @param c         the new child.
+     */
+    void setChild(uint32_t x, const side s, uint32_t c);
+
+    // rotates the subtree of a node: the node goes down on the side s, its child on the other side takes its place
+    void rotate(const uint32_t x, const side s);
+
+    // replaces the subtree of u with the subtree of v (the parent of u points to v)
+    void transplant(const uint32_t u, const uint32_t v);
+
+    // inserts a segment in the last version (restoring the red-black properties)
+    void insert(const uint32_t segment);
+
+    // removes a segment from the last version (restoring the red-black properties)
+    void remove(const uint32_t segment);
+};
+
+#endif // PERSISTENTSLABLOCATOR_H
@@ -0,0 +1,11 @@
+#include "pointlocator.h"
+
+PointLocator::~PointLocator() {}
+
+size_t PointLocator::rayShootUp(const cg3::Point2d& q) const {
+    return pointLocation(q)->getTop().getId();
+}
+
+size_t PointLocator::rayShootDown(const cg3::Point2d& q) const {
+    return pointLocation(q)->getBottom().getId();
+}
@@ -0,0 +1,34 @@
+#ifndef POINTLOCATOR_H
+#define POINTLOCATOR_H
+
+#include "cg3/geometry/point2.h"
+#include "drawables/drawabletrapezoid.h"
+
+/**
+ * @brief The PointLocator class is the interface shared by the search structures answering the point location in a trapezoidal map
+ * (the DAG of TrapezoidalMap, the indices built over it and the static engines), so they can be compared and swapped in the same code.
+ * The ray-shooting queries are answered through the trapezoid found, unless an engine has a faster way.
+ */
+class PointLocator
+{
+public:
+    // Destructor
+    virtual ~PointLocator();
+
+    /**
+     * @brief pointLocation     query a point.
+     * @param pointToQuery      the query point.
+     * @return                  the (drawable) trapezoid containing the query point.
+     */
+    virtual DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery) const = 0;
+
+    /**
+     * @brief rayShootUp/rayShootDown   find the input segment directly above/below a point (the top/bottom of the trapezoid containing it).
+     * @param q                         the query point.
+     * @return                          the id of the segment, OrderedSegment::NO_ID if the ray hits the bounding box.
+     */
+    virtual size_t rayShootUp(const cg3::Point2d& q) const;
+    virtual size_t rayShootDown(const cg3::Point2d& q) const;
+};
+
+#endif // POINTLOCATOR_H
@@ -1,78 +1,223 @@
 #include "segment_intersection_checker.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include <cg3/geometry/intersections2.h>
 
+namespace {
+
+//The number of threads to use: 0 means one for each core
+size_t threadNumber(size_t nThreads)
+{
+    return nThreads == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : nThreads;
+}
+
+//Runs body(begin, end, thread) on the chunks of [0, n) with at most nThreads threads: each one takes the next chunk until
+//they're over. The calling thread is the thread 0, and it works alone if there's a single chunk
+template<class Body>
+void parallelChunks(size_t n, size_t nThreads, Body body)
+{
+    const size_t chunkSize = SegmentIntersectionChecker::CHUNK_SIZE;
+    nThreads = std::max<size_t>(1, std::min(nThreads, (n + chunkSize - 1) / chunkSize));
+
+    std::atomic<size_t> nextChunk(0);
+    auto work = [n, chunkSize, &nextChunk, &body](size_t thread) {
+        for (size_t begin = nextChunk.fetch_add(chunkSize); begin < n; begin = nextChunk.fetch_add(chunkSize)) {
+            body(begin, std::min(begin + chunkSize, n), thread);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t thread = 1; thread < nThreads; thread++) {
+        threads.push_back(std::thread(work, thread));
+    }
+    work(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+}
+
 SegmentIntersectionChecker::SegmentIntersectionChecker()
-    : aabbTree(&aabbValueExtractor),
-      keyOverlapChecker(&checkSegmentIntersection)
 {
 
 }
 
 void SegmentIntersectionChecker::insert(const cg3::Segment2d& seg) {
-    aabbTree.insert(seg);
+    pending.push_back(seg);
+    if (pending.size() >= MAX_PENDING) {
+        trees.push_back(PackedAABBTree(pending));
+        pending.clear();
+        mergeTrees();
+    }
+}
+
+void SegmentIntersectionChecker::insert(const std::vector<cg3::Segment2d>& segVec) {
+    if (segVec.size() < MAX_PENDING) {
+        for (const cg3::Segment2d& seg : segVec) {
+            insert(seg);
+        }
+    }
+    else {
+        trees.push_back(PackedAABBTree(segVec));
+        mergeTrees();
+    }
+}
+
+void SegmentIntersectionChecker::mergeTrees() {
+    while (trees.size() >= 2 && trees[trees.size() - 2].size() < 2 * trees.back().size()) {
+        std::vector<cg3::Segment2d> merged = trees[trees.size() - 2].getSegments();
+        merged.insert(merged.end(), trees.back().getSegments().begin(), trees.back().getSegments().end());
+        trees.pop_back();
+        trees.back().build(merged);
+    }
 }
 
 size_t SegmentIntersectionChecker::countIntersections(const cg3::Segment2d& seg) {
-    std::vector<cg3::AABBTree<2, cg3::Segment2d>::iterator> out;
-    aabbTree.aabbOverlapQuery(seg, std::back_inserter(out), this->keyOverlapChecker);
-    return out.size();
+    size_t result = 0;
+    for (const PackedAABBTree& tree : trees) {
+        result += tree.countOverlaps(seg, &checkSegmentIntersection);
+    }
+    for (const cg3::Segment2d& other : pending) {
+        if (checkSegmentIntersection(seg, other)) {
+            result++;
+        }
+    }
+    return result;
 }
 
 bool SegmentIntersectionChecker::checkIntersections(const cg3::Segment2d& seg) {
-    return aabbTree.aabbOverlapCheck(seg, this->keyOverlapChecker);
+    for (const PackedAABBTree& tree : trees) {
+        if (tree.checkOverlap(seg, &checkSegmentIntersection)) {
+            return true;
+        }
+    }
+    for (const cg3::Segment2d& other : pending) {
+        if (checkSegmentIntersection(seg, other)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SegmentIntersectionChecker::findIntersection(const cg3::Segment2d& seg, cg3::Segment2d& other) {
+    for (const PackedAABBTree& tree : trees) {
+        if (tree.findOverlap(seg, &checkSegmentIntersection, other)) {
+            return true;
+        }
+    }
+    for (const cg3::Segment2d& pendingSeg : pending) {
+        if (checkSegmentIntersection(seg, pendingSeg)) {
+            other = pendingSeg;
+            return true;
+        }
+    }
+    return false;
 }
 
 size_t SegmentIntersectionChecker::countIntersection(const std::vector<cg3::Segment2d>& segVec) {
     size_t result = 0;
     for (const cg3::Segment2d& seg : segVec) {
-        std::vector<cg3::AABBTree<2, cg3::Segment2d>::iterator> out;
-        aabbTree.aabbOverlapQuery(seg, std::back_inserter(out), this->keyOverlapChecker);
-        result += out.size();
+        result += countIntersections(seg);
     }
     return result;
 }
 
 bool SegmentIntersectionChecker::checkIntersections(const std::vector<cg3::Segment2d>& segVec) {
     for (const cg3::Segment2d& seg : segVec) {
-        if (aabbTree.aabbOverlapCheck(seg, this->keyOverlapChecker)) {
+        if (checkIntersections(seg)) {
             return true;
         }
     }
     return false;
 }
 
-double SegmentIntersectionChecker::aabbValueExtractor(
-        const cg3::Segment2d& segment,
-        const cg3::AABBValueType& valueType,
-        const int& dim)
-{
-    if (valueType == cg3::AABBValueType::MIN) {
-        switch (dim) {
-        case 1:
-            return static_cast<double>(std::min(segment.p1().x(), segment.p2().x()));
-        case 2:
-            return static_cast<double>(std::min(segment.p1().y(), segment.p2().y()));
+size_t SegmentIntersectionChecker::countIntersection(const std::vector<cg3::Segment2d>& segVec, size_t nThreads) {
+    std::vector<size_t> threadResults(threadNumber(nThreads), 0);
+    parallelChunks(segVec.size(), threadResults.size(), [&](size_t begin, size_t end, size_t thread) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) {
+            count += countIntersections(segVec[i]);
         }
+        threadResults[thread] += count;
+    });
+
+    size_t result = 0;
+    for (size_t threadResult : threadResults) {
+        result += threadResult;
     }
-    else if (valueType == cg3::AABBValueType::MAX) {
-        switch (dim) {
-        case 1:
-            return static_cast<double>(std::max(segment.p1().x(), segment.p2().x()));
-        case 2:
-            return static_cast<double>(std::max(segment.p1().y(), segment.p2().y()));
+    return result;
+}
+
+bool SegmentIntersectionChecker::checkIntersections(const std::vector<cg3::Segment2d>& segVec, size_t nThreads) {
+    //As soon as a thread finds an intersection, the others skip their remaining segments
+    std::atomic<bool> found(false);
+    parallelChunks(segVec.size(), threadNumber(nThreads), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end && !found.load(std::memory_order_relaxed); i++) {
+            if (checkIntersections(segVec[i])) {
+                found = true;
+            }
         }
-    }
-    throw new std::runtime_error("Impossible to extract an AABB value.");
+    });
+    return found;
 }
 
+std::vector<size_t> SegmentIntersectionChecker::findIntersecting(const std::vector<cg3::Segment2d>& segVec, size_t nThreads) {
+    std::vector<std::vector<size_t>> threadResults(threadNumber(nThreads));
+    parallelChunks(segVec.size(), threadResults.size(), [&](size_t begin, size_t end, size_t thread) {
+        for (size_t i = begin; i < end; i++) {
+            if (checkIntersections(segVec[i])) {
+                threadResults[thread].push_back(i);
+            }
+        }
+    });
+
+    //Each thread found its positions in increasing order, chunk after chunk: merging the lists sorts them
+    std::vector<size_t> result;
+    for (const std::vector<size_t>& threadResult : threadResults) {
+        const size_t middle = result.size();
+        result.insert(result.end(), threadResult.begin(), threadResult.end());
+        std::inplace_merge(result.begin(), result.begin() + middle, result.end());
+    }
+    return result;
+}
 
 bool SegmentIntersectionChecker::checkSegmentIntersection(const cg3::Segment2d& seg1, const cg3::Segment2d& seg2)
 {
-    return cg3::checkSegmentIntersection2(seg1, seg2, true);
+    //The intersection point is a local: the default one is a global, written by every thread of the parallel queries
+    char code;
+    cg3::Point2d intersection;
+    cg3::checkSegmentIntersection2(seg1, seg2, code, cg3::CG3_EPSILON, intersection);
+
+    //Proper intersection (or an endpoint in the interior of the other segment), or the same segment
+    if (code == '1' || code == 's') {
+        return true;
+    }
+    if (code == '0') {
+        return false;
+    }
+
+    //The segments touch (a common endpoint, or a collinear overlap): it's an intersection
+    //only if they are collinear and they share more than a point
+    const cg3::Point2d d = seg1.p2() - seg1.p1();
+    const cg3::Point2d a = seg2.p1() - seg1.p1();
+    const cg3::Point2d b = seg2.p2() - seg1.p1();
+    if (d.x() * a.y() - d.y() * a.x() != 0 || d.x() * b.y() - d.y() * b.x() != 0) {
+        return false;
+    }
+
+    //Project the second segment on the first one (which goes from 0 to |d|^2)
+    const double length = d.x() * d.x() + d.y() * d.y();
+    const double ta = d.x() * a.x() + d.y() * a.y();
+    const double tb = d.x() * b.x() + d.y() * b.y();
+    return std::min(std::max(ta, tb), length) > std::max(std::min(ta, tb), 0.0);
 }
 
 void SegmentIntersectionChecker::clear()
 {
-    aabbTree.clear();
+    trees.clear();
+    pending.clear();
 }
@@ -1,42 +1,59 @@
 #ifndef SEGMENTINTERSECTIONCHECKER_H
 #define SEGMENTINTERSECTIONCHECKER_H
 
-#include <cg3/data_structures/trees/aabbtree.h>
+#include <vector>
+
 #include <cg3/geometry/segment2.h>
 
+#include "data_structures/packedaabbtree.h"
+
 
 class SegmentIntersectionChecker {
 
 public:
 
-    typedef cg3::AABBTree<2, cg3::Segment2d> AABBTree;
-    typedef AABBTree::KeyOverlapChecker KeyOverlapChecker;
-
     SegmentIntersectionChecker();
 
     void insert(const cg3::Segment2d& seg);
+    //Inserts many segments at once: they're bulk-loaded in a single tree, in O(n log n)
+    void insert(const std::vector<cg3::Segment2d>& segVec);
 
     size_t countIntersections(const cg3::Segment2d& seg);
     bool checkIntersections(const cg3::Segment2d& seg);
+    //Same as checkIntersections, and it returns a segment intersecting the given one
+    bool findIntersection(const cg3::Segment2d& seg, cg3::Segment2d& other);
 
     size_t countIntersection(const std::vector<cg3::Segment2d>& segVec);
     bool checkIntersections(const std::vector<cg3::Segment2d>& segVec);
 
+    //Parallel versions: the tree is only read by the queries, so the segments are split in chunks among nThreads threads
+    //(0 means one for each core). Each thread keeps its own results, merged at the end
+    size_t countIntersection(const std::vector<cg3::Segment2d>& segVec, size_t nThreads);
+    bool checkIntersections(const std::vector<cg3::Segment2d>& segVec, size_t nThreads);
+    //Returns the positions (sorted) of the segments intersecting the ones in the tree
+    std::vector<size_t> findIntersecting(const std::vector<cg3::Segment2d>& segVec, size_t nThreads = 0);
 
-    static double aabbValueExtractor(
-            const cg3::Segment2d& segment,
-            const cg3::AABBValueType& valueType,
-            const int& dim);
 
     static bool checkSegmentIntersection(
             const cg3::Segment2d& seg1, const cg3::Segment2d& seg2);
 
     void clear();
 
+    //Number of segments of a chunk: a thread takes the next chunk when it finishes its own one
+    static const size_t CHUNK_SIZE = 256;
+
+    //Maximum number of segments inserted and not in a tree yet
+    static const size_t MAX_PENDING = 32;
+
 private:
 
-    AABBTree aabbTree;
-    KeyOverlapChecker keyOverlapChecker;
+    //Merges the last trees until each one is at least twice as large as the next one
+    void mergeTrees();
+
+    //The segments are stored in static trees of decreasing size, plus the last ones inserted (at most MAX_PENDING) which are
+    //tested one by one. Inserting n segments one at a time rebuilds the tree of each segment O(log n) times
+    std::vector<PackedAABBTree> trees;
+    std::vector<cg3::Segment2d> pending;
 
 };
 
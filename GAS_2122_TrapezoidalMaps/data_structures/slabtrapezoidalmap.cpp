@@ -0,0 +1,142 @@
+#include "slabtrapezoidalmap.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+const size_t SlabTrapezoidalMap::MIN_SEGMENTS_PER_SLAB;
+
+/// CONSTRUCTORS ///
+SlabTrapezoidalMap::SlabTrapezoidalMap() {}
+
+SlabTrapezoidalMap::~SlabTrapezoidalMap() {
+    clear();
+}
+///////////////////////////////////////
+
+
+void SlabTrapezoidalMap::build(const cg3::BoundingBox2& B, const std::vector<cg3::Segment2d>& segments, size_t nSlabs) {
+    clear();
+
+    // One slab for each core, but not too small
+    if(nSlabs == 0)
+        nSlabs = std::max<size_t>(1, std::thread::hardware_concurrency());
+    nSlabs = std::max<size_t>(1, std::min(nSlabs, segments.size() / MIN_SEGMENTS_PER_SLAB));
+
+    // The x-values of all the endpoints, sorted: the slabs get the same number of them
+    std::vector<double> xValues;
+    xValues.reserve(2 * segments.size());
+    for(const cg3::Segment2d& s : segments) {
+        xValues.push_back(s.p1().x());
+        xValues.push_back(s.p2().x());
+    }
+    std::sort(xValues.begin(), xValues.end());
+
+    /* Each boundary is the midpoint between two consecutive distinct x-values. The band of a boundary (a quarter of the gap
+     * on each side of it) doesn't contain any endpoint: the segments crossing the boundary are clipped inside it. */
+    std::vector<double> bands;
+    size_t lastPosition = 0;
+    for(size_t j = 1; j < nSlabs; j++) {
+        size_t k = std::max(j * xValues.size() / nSlabs, lastPosition + 1);
+        while(k < xValues.size() && xValues[k] == xValues[k-1])
+            k++;
+        if(k >= xValues.size())
+            break;
+
+        const double boundary = (xValues[k-1] + xValues[k]) / 2;
+        // the two values could be too close to have a double in between
+        if(xValues[k-1] < boundary && boundary < xValues[k]) {
+            boundaries.push_back(boundary);
+            bands.push_back((xValues[k] - xValues[k-1]) / 4);
+        }
+        lastPosition = k;
+    }
+    nSlabs = boundaries.size() + 1;
+
+    /* Clip the segments: a segment crossing a boundary b is cut at b + band/2 in the left slab and at b - band/2 in the right
+     * slab. The clipped endpoints of a boundary share their x-value, as any other endpoints: the maps handle them with the symbolic shear. */
+    std::vector<std::vector<std::pair<cg3::Segment2d, size_t>>> pieces(nSlabs);
+    for(size_t id = 0; id < segments.size(); id++) {
+        const cg3::Point2d& left = segments[id].p1().x() < segments[id].p2().x() ? segments[id].p1() : segments[id].p2();
+        const cg3::Point2d& right = segments[id].p1().x() < segments[id].p2().x() ? segments[id].p2() : segments[id].p1();
+        const double slope = (right.y() - left.y()) / (right.x() - left.x());
+
+        const size_t first = slabContaining(left.x());
+        const size_t last = slabContaining(right.x());
+        cg3::Point2d pieceLeft = left;
+        for(size_t slab = first; slab <= last; slab++) {
+            if(slab == last) {
+                pieces[slab].push_back(std::make_pair(cg3::Segment2d(pieceLeft, right), id));
+                break;
+            }
+
+            const double rightX = boundaries[slab] + bands[slab] / 2;
+            const double leftX = boundaries[slab] - bands[slab] / 2;
+            pieces[slab].push_back(std::make_pair(cg3::Segment2d(pieceLeft, cg3::Point2d(rightX, left.y() + slope * (rightX - left.x()))), id));
+            pieceLeft = cg3::Point2d(leftX, left.y() + slope * (leftX - left.x()));
+        }
+    }
+
+    // Build the maps of the slabs, each one in its thread. A slab map covers its slab and the bands of its boundaries.
+    slabs.resize(nSlabs);
+    std::vector<std::thread> threads;
+    threads.reserve(nSlabs);
+    for(size_t slab = 0; slab < nSlabs; slab++) {
+        const double minX = slab == 0 ? B.min().x() : boundaries[slab-1] - bands[slab-1];
+        const double maxX = slab == nSlabs - 1 ? B.max().x() : boundaries[slab] + bands[slab];
+        const cg3::BoundingBox2 slabBox(cg3::Point2d(minX, B.min().y()), cg3::Point2d(maxX, B.max().y()));
+
+        slabs[slab] = new TrapezoidalMap();
+        TrapezoidalMap* map = slabs[slab];
+        const std::vector<std::pair<cg3::Segment2d, size_t>>* slabPieces = &pieces[slab];
+        threads.push_back(std::thread([map, slabBox, slabPieces]() {
+            map->initialize(slabBox);
+            for(const std::pair<cg3::Segment2d, size_t>& piece : *slabPieces)
+                map->addSegment(piece.first, piece.second);
+        }));
+    }
+
+    for(std::thread& thread : threads)
+        thread.join();
+}
+
+DrawableTrapezoid* SlabTrapezoidalMap::pointLocation(const cg3::Point2d& pointToQuery) const {
+    assert(!slabs.empty());
+    return slabs[slabContaining(pointToQuery.x())]->pointLocation(pointToQuery);
+}
+
+size_t SlabTrapezoidalMap::rayShootUp(const cg3::Point2d& q) const {
+    assert(!slabs.empty());
+    return slabs[slabContaining(q.x())]->rayShootUp(q);
+}
+
+size_t SlabTrapezoidalMap::rayShootDown(const cg3::Point2d& q) const {
+    assert(!slabs.empty());
+    return slabs[slabContaining(q.x())]->rayShootDown(q);
+}
+
+size_t SlabTrapezoidalMap::getSlabNumber() const {
+    return slabs.size();
+}
+
+const TrapezoidalMap& SlabTrapezoidalMap::getSlab(const size_t slab) const {
+    assert(slab < slabs.size());
+    return *slabs[slab];
+}
+
+const std::vector<double>& SlabTrapezoidalMap::getBoundaries() const {
+    return boundaries;
+}
+
+void SlabTrapezoidalMap::clear() {
+    for(TrapezoidalMap* slab : slabs)
+        delete slab;
+    slabs.clear();
+    boundaries.clear();
+}
+
+
+size_t SlabTrapezoidalMap::slabContaining(const double x) const {
+    // a point on a boundary belongs to the slab on its right
+    return static_cast<size_t>(std::upper_bound(boundaries.begin(), boundaries.end(), x) - boundaries.begin());
+}
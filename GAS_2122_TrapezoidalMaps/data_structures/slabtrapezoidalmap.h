@@ -0,0 +1,88 @@
+#ifndef SLABTRAPEZOIDALMAP_H
+#define SLABTRAPEZOIDALMAP_H
+
+#include <vector>
+
+#include "cg3/geometry/point2.h"
+#include "cg3/geometry/segment2.h"
+#include "cg3/geometry/bounding_box2.h"
+#include "trapezoidalmap.h"
+#include "pointlocator.h"
+
+/**
+ * @brief The SlabTrapezoidalMap class builds a trapezoidal map in parallel, splitting the bounding box into vertical slabs.
+ * The slab boundaries are chosen so that each slab contains about the same number of endpoints, and every boundary lies
+ * between two consecutive (distinct) x-values of the endpoints. The segments crossing a boundary are clipped there,
+ * then each slab is an independent TrapezoidalMap built by its own thread.
+ * A query first finds its slab with a binary search on the boundaries, then it's located in the map of that slab.
+ *
+ * The trapezoids of a slab are the trapezoids of the whole map cut by the slab boundaries, so the point location returns
+ * a trapezoid of the slab. The ray-shooting queries return the same ids of a single TrapezoidalMap, since every clipped part
+ * keeps the id of its segment.
+ *
+ * N.B. the clipped endpoints are placed just outside the slab, in a band without other endpoints, so the pieces don't
+ * change the faces of the slab.
+ */
+class SlabTrapezoidalMap : public PointLocator
+{
+public:
+    // Constructor: it creates an empty map (without slabs)
+    SlabTrapezoidalMap();
+    // Destructor: it'll deallocate the map of each slab
+    ~SlabTrapezoidalMap();
+
+    // the maps of the slabs are owned by this object, so it cannot be copied
+    SlabTrapezoidalMap(const SlabTrapezoidalMap&) = delete;
+    SlabTrapezoidalMap& operator=(const SlabTrapezoidalMap&) = delete;
+
+    /**
+     * @brief build         builds the maps of the slabs in parallel (one thread for each slab). The previous content is discarded.
+     * @param B             the bounding box that encloses all the segments.
+     * @param segments      the segments to insert (they must not cross each other). The id of each segment is its position in the list.
+     * @param nSlabs        the number of slabs, i.e. of threads (0 means one for each core).
+     *                      Fewer slabs are used if there are too few segments (see MIN_SEGMENTS_PER_SLAB) or too few distinct x-values.
+     */
+    void build(const cg3::BoundingBox2& B, const std::vector<cg3::Segment2d>& segments, size_t nSlabs = 0);
+
+    /**
+     * @brief pointLocation     query a point in the map of its slab.
+     * @param pointToQuery      the query point.
+     * @return                  the (drawable) trapezoid of the slab containing the query point.
+     */
+    DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery) const;
+
+    /**
+     * @brief rayShootUp/rayShootDown   find the input segment directly above/below a point (see TrapezoidalMap::rayShootUp).
+     * @param q                         the query point.
+     * @return                          the id of the segment, OrderedSegment::NO_ID if the ray hits the bounding box.
+     */
+    size_t rayShootUp(const cg3::Point2d& q) const;
+    size_t rayShootDown(const cg3::Point2d& q) const;
+
+    // returns the number of slabs
+    size_t getSlabNumber() const;
+
+    // returns the map of a slab (read-only)
+    const TrapezoidalMap& getSlab(const size_t slab) const;
+
+    // returns the x-values separating the slabs (the slab i covers the x-values in [boundaries[i-1], boundaries[i]))
+    const std::vector<double>& getBoundaries() const;
+
+    // deletes the maps of all the slabs
+    void clear();
+
+private:
+    // minimum number of segments for each slab: below this, the threads cost more than the construction
+    static const size_t MIN_SEGMENTS_PER_SLAB = 1024;
+
+    // the map of each slab, from left to right
+    std::vector<TrapezoidalMap*> slabs;
+
+    // the x-values separating the slabs (one less than the slabs)
+    std::vector<double> boundaries;
+
+    // returns the index of the slab containing a given x-value
+    size_t slabContaining(const double x) const;
+};
+
+#endif // SLABTRAPEZOIDALMAP_H
@@ -0,0 +1,170 @@
+#include "sweeptrapezoidalmap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+
+#include "algorithms/OrientationUtility.h"
+
+const size_t SweepTrapezoidalMap::BOUNDINGBOX_TOP;
+const size_t SweepTrapezoidalMap::BOUNDINGBOX_BOTTOM;
+
+/// CONSTRUCTORS ///
+SweepTrapezoidalMap::SweepTrapezoidalMap() {}
+
+SweepTrapezoidalMap::~SweepTrapezoidalMap() {
+    clear();
+}
+///////////////////////////////////////
+
+
+void SweepTrapezoidalMap::build(const cg3::BoundingBox2& B, const std::vector<cg3::Segment2d>& segments) {
+    clear();
+    this->B = B;
+
+    // The edges of the bounding box, as in TrapezoidalMap::initialize, then the input segments
+    this->segments.reserve(segments.size() + 2);
+    this->segments.push_back(new OrderedSegment(cg3::Point2d(B.min().x(), B.max().y()), B.max()));
+    this->segments.push_back(new OrderedSegment(B.min(), cg3::Point2d(B.max().x(), B.min().y())));
+    for(size_t id = 0; id < segments.size(); id++)
+        this->segments.push_back(new OrderedSegment(segments[id], id));
+
+    sweep();
+    locator.build(T);
+}
+
+DrawableTrapezoid* SweepTrapezoidalMap::pointLocation(const cg3::Point2d& pointToQuery) const {
+    assert(!T.empty());
+    return locator.pointLocation(pointToQuery);
+}
+
+size_t SweepTrapezoidalMap::rayShootUp(const cg3::Point2d& q) const {
+    return pointLocation(q)->getTop().getId();
+}
+
+size_t SweepTrapezoidalMap::rayShootDown(const cg3::Point2d& q) const {
+    return pointLocation(q)->getBottom().getId();
+}
+
+const std::vector<DrawableTrapezoid*>& SweepTrapezoidalMap::getTrapezoids() const {
+    return T;
+}
+
+size_t SweepTrapezoidalMap::segmentNumber() const {
+    return segments.size() < 2 ? 0 : segments.size() - 2;
+}
+
+const cg3::BoundingBox2& SweepTrapezoidalMap::getBoundingBox() const {
+    return B;
+}
+
+void SweepTrapezoidalMap::clear() {
+    locator.clear();
+    for(DrawableTrapezoid* t : T)
+        delete t;
+    T.clear();
+    for(OrderedSegment* s : segments)
+        delete s;
+    segments.clear();
+}
+
+
+void SweepTrapezoidalMap::sweep() {
+    // The trapezoid still open in a gap of the status: the gap is identified by the segment below it
+    struct OpenTrapezoid {
+        const OrderedSegment* top;
+        const cg3::Point2d* leftp;
+        DrawableTrapezoid* upperLeftNeighbor;
+        DrawableTrapezoid* lowerLeftNeighbor;
+    };
+    std::vector<OpenTrapezoid> open(segments.size());
+
+    // The endpoints sorted from left to right (a shared endpoint is visited once with all its segments)
+    struct Event {
+        const cg3::Point2d* point;
+        size_t segment;
+        bool isLeft;
+    };
+    std::vector<Event> events;
+    events.reserve(2 * segmentNumber());
+    for(size_t s = BOUNDINGBOX_BOTTOM + 1; s < segments.size(); s++) {
+        events.push_back({&segments[s]->getLeftmost(), s, true});
+        events.push_back({&segments[s]->getRightmost(), s, false});
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return *a.point < *b.point;
+    });
+
+    // The status: the segments cut by the sweep line, from the bottom to the top (the edges of the bounding box are always there)
+    auto order = [this](size_t a, size_t b) { return OrientationUtility::isSegmentBelow(*segments[a], *segments[b]); };
+    std::set<size_t, decltype(order)> status(order);
+    std::vector<std::set<size_t, decltype(order)>::iterator> position(segments.size());
+    position[BOUNDINGBOX_BOTTOM] = status.insert(BOUNDINGBOX_BOTTOM).first;
+    position[BOUNDINGBOX_TOP] = status.insert(BOUNDINGBOX_TOP).first;
+    open[BOUNDINGBOX_BOTTOM] = {segments[BOUNDINGBOX_TOP], &segments[BOUNDINGBOX_BOTTOM]->getLeftmost(), nullptr, nullptr};
+
+    // closes the trapezoid open above a segment: its left neighbors already exist, so the links are set in both directions
+    auto close = [this, &open](size_t bottom, const cg3::Point2d* rightp) {
+        const OpenTrapezoid& o = open[bottom];
+        DrawableTrapezoid* face = new DrawableTrapezoid(*o.top, *segments[bottom], *o.leftp, *rightp);
+        if(o.upperLeftNeighbor != nullptr) {
+            face->setUpperLeftNeighbor(o.upperLeftNeighbor);
+            o.upperLeftNeighbor->setUpperRightNeighbor(face);
+        }
+        if(o.lowerLeftNeighbor != nullptr) {
+            face->setLowerLeftNeighbor(o.lowerLeftNeighbor);
+            o.lowerLeftNeighbor->setLowerRightNeighbor(face);
+        }
+        T.push_back(face);
+        return face;
+    };
+
+    std::vector<size_t> ending, starting;
+    for(size_t e = 0; e < events.size(); ) {
+        // the segments ending and starting at the endpoint p, from the bottom to the top
+        const cg3::Point2d* p = events[e].point;
+        ending.clear();
+        starting.clear();
+        for(; e < events.size() && *events[e].point == *p; e++)
+            (events[e].isLeft ? starting : ending).push_back(events[e].segment);
+        std::sort(ending.begin(), ending.end(), order);
+        std::sort(starting.begin(), starting.end(), order);
+
+        // the segments below and above p: the vertical extension of p goes from one to the other
+        size_t lower, upper;
+        if(!ending.empty()) {
+            lower = *std::prev(position[ending.front()]);
+            upper = *std::next(position[ending.back()]);
+        }
+        else {
+            for(size_t s : starting)
+                position[s] = status.insert(s).first;
+            lower = *std::prev(position[starting.front()]);
+            upper = *std::next(position[starting.back()]);
+        }
+
+        // 1. Close the trapezoids cut by the extension (the gaps above lower and above the ending segments)
+        DrawableTrapezoid* lowerLeftFace = close(lower, p);
+        DrawableTrapezoid* upperLeftFace = lowerLeftFace;
+        for(size_t s : ending)
+            upperLeftFace = close(s, p);
+
+        // 2. Update the status
+        if(!ending.empty()) {
+            for(size_t s : ending)
+                status.erase(position[s]);
+            for(size_t s : starting)
+                position[s] = status.insert(s).first;
+        }
+
+        /* 3. Open the new trapezoids (the gaps above lower and above the starting segments).
+         * Through the extension of p, the topmost trapezoids on its sides are neighbors, and so are the bottommost ones. */
+        open[lower] = {starting.empty() ? segments[upper] : segments[starting.front()], p, nullptr, lowerLeftFace};
+        for(size_t i = 0; i < starting.size(); i++)
+            open[starting[i]] = {i + 1 < starting.size() ? segments[starting[i+1]] : segments[upper], p, nullptr, nullptr};
+        open[starting.empty() ? lower : starting.back()].upperLeftNeighbor = upperLeftFace;
+    }
+
+    // The last trapezoid is closed by the right edge of the bounding box
+    close(BOUNDINGBOX_BOTTOM, &segments[BOUNDINGBOX_TOP]->getRightmost());
+}
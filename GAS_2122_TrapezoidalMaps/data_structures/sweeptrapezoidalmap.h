@@ -0,0 +1,94 @@
+#ifndef SWEEPTRAPEZOIDALMAP_H
+#define SWEEPTRAPEZOIDALMAP_H
+
+#include <vector>
+
+#include "cg3/geometry/point2.h"
+#include "cg3/geometry/segment2.h"
+#include "cg3/geometry/bounding_box2.h"
+#include "orderedsegment.h"
+#include "drawables/drawabletrapezoid.h"
+#include "persistentslablocator.h"
+#include "pointlocator.h"
+
+/**
+ * @brief The SweepTrapezoidalMap class builds the trapezoidal map of a static set of segments with a plane sweep: the result
+ * doesn't depend on the order of the segments nor on any random choice.
+ * The trapezoids (with their top, bottom, leftp, rightp and the 4 neighbors) are the same built by TrapezoidalMap,
+ * since the trapezoidal map of a set of segments is unique.
+ *
+ * There is no DAG: the queries are answered by a PersistentSlabLocator built on the trapezoids of the sweep, in O(log n) with O(n) memory.
+ * The sweep and the locator take O(n log n) time each, so the whole build is deterministic O(n log n).
+ *
+ * The segments cannot be inserted after the construction: build has to be called again.
+ */
+class SweepTrapezoidalMap : public PointLocator
+{
+public:
+    // Constructor: it creates an empty map
+    SweepTrapezoidalMap();
+    // Destructor: it'll deallocate the trapezoids and the segments
+    ~SweepTrapezoidalMap();
+
+    // the trapezoids and the segments are owned by this object, so it cannot be copied
+    SweepTrapezoidalMap(const SweepTrapezoidalMap&) = delete;
+    SweepTrapezoidalMap& operator=(const SweepTrapezoidalMap&) = delete;
+
+    /**
+     * @brief build         builds the trapezoidal map with a sweep from left to right, then the locator on its trapezoids. The previous content is discarded.
+     * @param B             the bounding box that encloses all the segments.
+     * @param segments      the segments (they must not cross each other). The id of each segment is its position in the list.
+     */
+    void build(const cg3::BoundingBox2& B, const std::vector<cg3::Segment2d>& segments);
+
+    /**
+     * @brief pointLocation     query a point in the trapezoidal map.
+     * @param pointToQuery      the query point.
+     * @return                  the (drawable) trapezoid containing the query point.
+     */
+    DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery) const;
+
+    /**
+     * @brief rayShootUp/rayShootDown   find the input segment directly above/below a point (see TrapezoidalMap::rayShootUp).
+     * @param q                         the query point.
+     * @return                          the id of the segment, OrderedSegment::NO_ID if the ray hits the bounding box.
+     */
+    size_t rayShootUp(const cg3::Point2d& q) const;
+    size_t rayShootDown(const cg3::Point2d& q) const;
+
+    // get the trapezoids of the map
+    const std::vector<DrawableTrapezoid*>& getTrapezoids() const;
+
+    // get the number of segments of the map (the bounding box is not counted)
+    size_t segmentNumber() const;
+
+    // get the bounding box
+    const cg3::BoundingBox2& getBoundingBox() const;
+
+    // deletes the trapezoids, the segments and the search structure
+    void clear();
+
+private:
+    // positions of the edges of the bounding box in the list of the segments (the input segments follow them)
+    static const size_t BOUNDINGBOX_TOP = 0;
+    static const size_t BOUNDINGBOX_BOTTOM = 1;
+
+    // the bounding box, its edges and the input segments
+    cg3::BoundingBox2 B;
+    std::vector<OrderedSegment*> segments;
+
+    // list of trapezoids in the map
+    std::vector<DrawableTrapezoid*> T;
+
+    // the search structure, built on the trapezoids
+    PersistentSlabLocator locator;
+
+    /**
+     * @brief sweep     computes the trapezoids and their neighbors, visiting the endpoints from left to right.
+     *                  The status is the list of the segments cut by the sweep line: every gap between two consecutive segments
+     *                  is a trapezoid still open on the right, closed by the next endpoint whose vertical extension cuts the gap.
+     */
+    void sweep();
+};
+
+#endif // SWEEPTRAPEZOIDALMAP_H
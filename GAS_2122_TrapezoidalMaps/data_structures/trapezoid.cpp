@@ -1,7 +1,12 @@
 #include "trapezoid.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "cg3/geometry/utils2.h"
+
 // Constructor
-Trapezoid::Trapezoid(const OrderedSegment& t, const OrderedSegment& b, const cg3::Point2d& lp, const cg3::Point2d& rp) : top(t), bottom(b), leftp(lp), rightp(rp)
+Trapezoid::Trapezoid(const OrderedSegment& t, const OrderedSegment& b, const cg3::Point2d& lp, const cg3::Point2d& rp) : top(&t), bottom(&b), leftp(&lp), rightp(&rp)
 {
 
 }
@@ -9,19 +14,19 @@ Trapezoid::Trapezoid(const OrderedSegment& t, const OrderedSegment& b, const cg3
 //////////////////////// GETTER ////////////////////////
 const OrderedSegment &Trapezoid::getTop() const
 {
-    return top;
+    return *top;
 }
 const OrderedSegment &Trapezoid::getBottom() const
 {
-    return bottom;
+    return *bottom;
 }
 const cg3::Point2d &Trapezoid::getLeftp() const
 {
-    return leftp;
+    return *leftp;
 }
 const cg3::Point2d &Trapezoid::getRightp() const
 {
-    return this->rightp;
+    return *(this->rightp);
 }
 
 Trapezoid* Trapezoid::getUpperLeftNeighbor() const {
@@ -46,6 +51,16 @@ bool Trapezoid::getIsBeingSplitted() const
     return isBeingSplitted;
 }
 
+size_t Trapezoid::getPolygonId() const
+{
+    return polygonId;
+}
+
+size_t Trapezoid::getClaim() const
+{
+    return claimOwner.load();
+}
+
 ////////////////////////////////////////////////////////
 
 
@@ -72,6 +87,24 @@ void Trapezoid::setIsBeingSplitted(const bool newIsBeingSplitted)
 {
     isBeingSplitted = newIsBeingSplitted;
 }
+
+void Trapezoid::setPolygonId(const size_t newPolygonId)
+{
+    polygonId = newPolygonId;
+}
+
+bool Trapezoid::claim(const size_t owner)
+{
+    // lower the owner until it's the smallest one (compare_exchange_weak reloads the current owner when it fails)
+    size_t current = claimOwner.load();
+    while(owner < current && !claimOwner.compare_exchange_weak(current, owner));
+    return owner <= current;
+}
+
+void Trapezoid::releaseClaim()
+{
+    claimOwner.store(NO_CLAIM);
+}
 ////////////////////////////////////////////////////////
 
 
@@ -90,8 +123,12 @@ bool Trapezoid::replaceNeighbor(Trapezoid* const oldNeighbor, Trapezoid* const n
     return hasReplaced;
 }
 
-void Trapezoid::replaceNeighborsFromTrapezoid(Trapezoid* const trapezoidToReplace, std::vector<neighborsCode> neighborsToReplace) {
-    for(auto code : neighborsToReplace) {
+void Trapezoid::replaceNeighborsFromTrapezoid(Trapezoid* const trapezoidToReplace, const unsigned int neighborsToReplace) {
+    for (neighborsCode code = TOPLEFT; code <= BOTTOMRIGHT; code = neighborsCode(code + 1)) {
+        // skip the neighbors not in the mask
+        if(!(neighborsToReplace & (1u << code)))
+            continue;
+
         this->neighbors[code] = trapezoidToReplace->neighbors[code];
         if(trapezoidToReplace->neighbors[code] != nullptr) {
             trapezoidToReplace->neighbors[code]->replaceNeighbor(trapezoidToReplace, this);
@@ -103,9 +140,126 @@ void Trapezoid::replaceNeighborsFromTrapezoid(Trapezoid* const trapezoidToReplac
 
 
 bool Trapezoid::canMerge(const Trapezoid& t1, const Trapezoid& t2) {
-    return  t1.getTop() == t2.getTop()
-            && t1.getBottom() == t2.getBottom();
+    return  t1.top == t2.top
+            && t1.bottom == t2.bottom;
+}
+
+bool Trapezoid::containsPoint(const cg3::Point2d& q) const {
+    /* q must be between the two vertical walls. The points are compared lexicographically (symbolic shear):
+     * a point on the vertical line of a wall is on its right if it's above the point of the wall. */
+    if(q < *leftp || *rightp < q)
+        return false;
+
+    // q must not be above the top segment nor below the bottom segment
+    return !cg3::isPointAtLeft(top->getLeftmost(), top->getRightmost(), q)
+            && !cg3::isPointAtRight(bottom->getLeftmost(), bottom->getRightmost(), q);
 }
 
+bool Trapezoid::intersectsBox(const cg3::BoundingBox2& box) const {
+    const double lx = leftp->x();
+    const double rx = rightp->x();
 
+    // x axis
+    if(rx < box.min().x() || lx > box.max().x())
+        return false;
 
+    // vertices of the trapezoid: the vertical walls cut the top and the bottom segments
+    const cg3::Point2d vertices[4] = {
+        cg3::Point2d(lx, yOnSegment(*top, lx)),    cg3::Point2d(rx, yOnSegment(*top, rx)),
+        cg3::Point2d(rx, yOnSegment(*bottom, rx)), cg3::Point2d(lx, yOnSegment(*bottom, lx))
+    };
+    const cg3::Point2d corners[4] = {
+        box.min(), cg3::Point2d(box.max().x(), box.min().y()),
+        box.max(), cg3::Point2d(box.min().x(), box.max().y())
+    };
+
+    // y axis
+    const double minY = std::min(vertices[2].y(), vertices[3].y());
+    const double maxY = std::max(vertices[0].y(), vertices[1].y());
+    if(maxY < box.min().y() || minY > box.max().y())
+        return false;
+
+    // normals of the top and bottom segments
+    const OrderedSegment* edges[2] = {top, bottom};
+    for(const OrderedSegment* edge : edges) {
+        const double nx = -(edge->getRightmost().y() - edge->getLeftmost().y());
+        const double ny = edge->getRightmost().x() - edge->getLeftmost().x();
+
+        double minT = std::numeric_limits<double>::max(), maxT = std::numeric_limits<double>::lowest();
+        double minB = std::numeric_limits<double>::max(), maxB = std::numeric_limits<double>::lowest();
+        for(size_t i = 0; i < 4; i++) {
+            const double projectionT = nx * vertices[i].x() + ny * vertices[i].y();
+            const double projectionB = nx * corners[i].x() + ny * corners[i].y();
+            minT = std::min(minT, projectionT);
+            maxT = std::max(maxT, projectionT);
+            minB = std::min(minB, projectionB);
+            maxB = std::max(maxB, projectionB);
+        }
+        if(maxT < minB || maxB < minT)
+            return false;
+    }
+
+    return true;
+}
+
+bool Trapezoid::intersectsSegment(const OrderedSegment& s) const {
+    cg3::Point2d entry, exit;
+    return clipSegment(s, entry, exit);
+}
+
+bool Trapezoid::clipSegment(const OrderedSegment& s, cg3::Point2d& entry, cg3::Point2d& exit) const {
+    // x-range shared by the trapezoid and the segment
+    double a = std::max(leftp->x(), s.getLeftmost().x());
+    double b = std::min(rightp->x(), s.getRightmost().x());
+    if(a > b)
+        return false;
+
+    // A vertical segment intersects the trapezoid if its y-range overlaps the vertical section of the trapezoid
+    if(s.getLeftmost().x() == s.getRightmost().x()) {
+        const double from = std::max(s.getLeftmost().y(), yOnSegment(*bottom, a));
+        const double to = std::min(s.getRightmost().y(), yOnSegment(*top, a));
+        if(from > to)
+            return false;
+        entry = cg3::Point2d(a, from);
+        exit = cg3::Point2d(a, to);
+        return true;
+    }
+
+    /* In [a,b] the distances of the segment from the top (f = top - s) and from the bottom (g = s - bottom) are linear:
+     * the segment is inside the trapezoid where both are non-negative. Each condition restricts [a,b] to a sub-interval. */
+    const double f[2] = {yOnSegment(*top, a) - yOnSegment(s, a), yOnSegment(*top, b) - yOnSegment(s, b)};
+    const double g[2] = {yOnSegment(s, a) - yOnSegment(*bottom, a), yOnSegment(s, b) - yOnSegment(*bottom, b)};
+    const double* distances[2] = {f, g};
+
+    double from = 0, to = 1;
+    for(const double* d : distances) {
+        // negative at both ends: never inside
+        if(d[0] < 0 && d[1] < 0)
+            return false;
+        // it changes sign: cut the parameter interval where the distance is zero
+        if(d[0] < 0 || d[1] < 0) {
+            const double zero = d[0] / (d[0] - d[1]);
+            if(d[0] < 0)
+                from = std::max(from, zero);
+            else
+                to = std::min(to, zero);
+        }
+    }
+    if(from > to)
+        return false;
+
+    // the endpoints of the parameter interval, on the segment (the endpoints of the segment are kept exact)
+    const double entryX = from == 0 ? a : a + (b - a) * from;
+    const double exitX = to == 1 ? b : a + (b - a) * to;
+    entry = entryX == s.getLeftmost().x() ? s.getLeftmost() : cg3::Point2d(entryX, yOnSegment(s, entryX));
+    exit = exitX == s.getRightmost().x() ? s.getRightmost() : cg3::Point2d(exitX, yOnSegment(s, exitX));
+    return true;
+}
+
+double Trapezoid::yOnSegment(const OrderedSegment& s, const double x) {
+    const cg3::Point2d& p1 = s.getLeftmost();
+    const cg3::Point2d& p2 = s.getRightmost();
+    if(p2.x() == p1.x())
+        return p1.y();
+    return p1.y() + (p2.y() - p1.y()) * (x - p1.x()) / (p2.x() - p1.x());
+}
@@ -2,22 +2,38 @@
 #define TRAPEZOID_H
 
 #include "orderedsegment.h"
+#include <atomic>
+#include <limits>
 #include <cg3/geometry/point2.h>
-#include <cg3/utilities/color.h>
 #include "cg3/geometry/bounding_box2.h"
 
 class DAGNode;
 class Trapezoid
 {
 public:
-    // A trapezoid is built using segments in general position, so it has at most 4 neighbors
+    // A trapezoid is built using segments in general position (the shared x-values are handled by the lexicographic order), so it has at most 4 neighbors
     static const size_t N_NEIGHBORS = 4;
 
+    // Owner of a trapezoid not claimed by any insertion
+    static const size_t NO_CLAIM = std::numeric_limits<size_t>::max();
+
     // The neighborsCode enum represents the 4 types of neighbors: topright, topleft, bottomleft, bottomright
     enum neighborsCode {TOPLEFT, TOPRIGHT, BOTTOMLEFT, BOTTOMRIGHT};
 
+    // The neighborsMask enum represents a set of neighbors: a bit for each neighborsCode. The masks can be combined with the | operator.
+    enum neighborsMask : unsigned int {
+        TOPLEFT_MASK     = 1u << TOPLEFT,
+        TOPRIGHT_MASK    = 1u << TOPRIGHT,
+        BOTTOMLEFT_MASK  = 1u << BOTTOMLEFT,
+        BOTTOMRIGHT_MASK = 1u << BOTTOMRIGHT,
+        LEFT_MASK        = TOPLEFT_MASK | BOTTOMLEFT_MASK,
+        RIGHT_MASK       = TOPRIGHT_MASK | BOTTOMRIGHT_MASK
+    };
+
     /**
-     * @brief Trapezoid Constructor of a trapezoid
+     * @brief Trapezoid Constructor of a trapezoid.
+     * The trapezoid does NOT copy the segments and the points: it refers to the objects given in input,
+     * which are owned by the trapezoidal map and must outlive the trapezoid.
      * @param t         the segment above
      * @param b         the segment below
      * @param lp        the left point
@@ -48,6 +64,12 @@ public:
 
     // returns true if the trapezoid is being split by a new segment, false otherwise.
     bool getIsBeingSplitted() const;
+
+    // returns the id of the polygon containing the trapezoid (OrderedSegment::NO_ID if it's outside every polygon or if the faces have not been labelled)
+    size_t getPolygonId() const;
+
+    // returns the owner of the claim on the trapezoid (NO_CLAIM if it's not claimed)
+    size_t getClaim() const;
     ////////////////////////////////////////////////////////
 
 
@@ -65,6 +87,19 @@ public:
 
     // Set the flag isBeingSplitted with the boolean given in input
     void setIsBeingSplitted(const bool newIsBeingSplitted);
+
+    // Set the id of the polygon containing the trapezoid
+    void setPolygonId(const size_t newPolygonId);
+
+    /**
+     * @brief claim     atomically claims the trapezoid for a concurrent insertion: the claim with the smallest owner wins.
+     * @param owner     the owner of the claim (e.g. the position of the segment in the insertion order).
+     * @return          true if the trapezoid is claimed by this owner (so far), false if a smaller owner has already claimed it.
+     */
+    bool claim(const size_t owner);
+
+    // Remove the claim on the trapezoid
+    void releaseClaim();
     ////////////////////////////////////////////////////////
 
 
@@ -79,37 +114,79 @@ public:
     bool replaceNeighbor(Trapezoid* const oldNeighbor, Trapezoid* const newNeighbor);
 
     /**
-     * @brief replaceNeighborsFromTrapezoid     "Steal" all the neighbors, specified in a list, from a given trapezoid. For each neighbor stolen, if it's not null, replace its old neighbor with this.
+     * @brief replaceNeighborsFromTrapezoid     "Steal" all the neighbors, specified in a mask, from a given trapezoid. For each neighbor stolen, if it's not null, replace its old neighbor with this.
      * @param trapezoidToReplace                The trapezoid from which the neighbors will be "stolen".
-     * @param neighborsToReplace                The list of neighbors to steal (UPPER_LEFT, LOWER_LEFT, ...)
+     * @param neighborsToReplace                The mask of neighbors to steal (TOPLEFT_MASK | BOTTOMLEFT_MASK, RIGHT_MASK, ...)
      */
-    void replaceNeighborsFromTrapezoid(Trapezoid* const trapezoidToReplace, std::vector<neighborsCode> neighborsToReplace);
+    void replaceNeighborsFromTrapezoid(Trapezoid* const trapezoidToReplace, const unsigned int neighborsToReplace);
     //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     /**
-     * @brief canMerge      Check if two trapezoids can be merged (i.e. they have the same top and bottom segments)
+     * @brief canMerge      Check if two trapezoids can be merged (i.e. they have the same top and bottom segments).
+     *                      Since every segment is stored only once in the trapezoidal map, it's enough to compare the references.
      * @param t1            A reference to the first trapezoid.
      * @param t2            A reference to the second trapezoid.
      * @return              true if the two trapezoids can be merged, false otherwise.
      */
     static bool canMerge(const Trapezoid& t1, const Trapezoid& t2);
 
+    /**
+     * @brief containsPoint     Check if a point lies inside the trapezoid (boundary included).
+     * @param q                 The point to check.
+     * @return                  true if q is between the vertical walls, not above the top segment and not below the bottom segment.
+     */
+    bool containsPoint(const cg3::Point2d& q) const;
+
+    /**
+     * @brief intersectsBox     Check if the trapezoid intersects an axis-aligned box (touching counts as intersecting).
+     *                          The two convex polygons are tested with the separating axis theorem: the axes are x, y and the normals of top and bottom.
+     * @param box               The box to check.
+     * @return                  true if the trapezoid and the box share at least a point.
+     */
+    bool intersectsBox(const cg3::BoundingBox2& box) const;
+
+    /**
+     * @brief intersectsSegment     Check if the trapezoid intersects a segment (touching counts as intersecting).
+     * @param s                     The segment to check.
+     * @return                      true if the trapezoid and the segment share at least a point.
+     */
+    bool intersectsSegment(const OrderedSegment& s) const;
+
+    /**
+     * @brief clipSegment           Finds the part of a segment inside the trapezoid (boundary included).
+     * @param s                     The segment to clip.
+     * @param [out] entry           The leftmost (lexicographically) point of the part: where the segment enters the trapezoid.
+     * @param [out] exit            The rightmost point of the part: where the segment leaves the trapezoid.
+     * @return                      true if the trapezoid and the segment share at least a point (the two points are set only in this case).
+     */
+    bool clipSegment(const OrderedSegment& s, cg3::Point2d& entry, cg3::Point2d& exit) const;
+
 protected:
     // array containing the 4 adjacent trapezoids.
     std::array<Trapezoid*, N_NEIGHBORS> neighbors = {nullptr, nullptr, nullptr, nullptr};
 
 private:
-    // Objects representing a trapezoid: top segment, bottom segment, left point, right point.
-    OrderedSegment top;
-    OrderedSegment bottom;
-    cg3::Point2d leftp;
-    cg3::Point2d rightp;
+    // References to the objects representing a trapezoid: top segment, bottom segment, left point, right point.
+    // They point to the segments stored in the trapezoidal map (the points are endpoints of those segments).
+    const OrderedSegment* top;
+    const OrderedSegment* bottom;
+    const cg3::Point2d* leftp;
+    const cg3::Point2d* rightp;
 
     // Pointer to the leaf pointing this trapezoid
     DAGNode* nodeContainer = nullptr;
 
     // flag that checks if this trapezoids is being split by a new segment
     bool isBeingSplitted = false;
+
+    // owner of the claim of a concurrent insertion: the trapezoid (or a neighbor) is going to be modified by it
+    std::atomic<size_t> claimOwner{NO_CLAIM};
+
+    // id of the polygon containing the trapezoid
+    size_t polygonId = OrderedSegment::NO_ID;
+
+    // returns the y-value of the line passing through a segment at a given x
+    static double yOnSegment(const OrderedSegment& s, const double x);
 };
 
 #endif // TRAPEZOID_H
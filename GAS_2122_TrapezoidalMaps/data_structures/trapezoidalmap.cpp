@@ -1,6 +1,18 @@
 #include "trapezoidalmap.h"
 
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
 #include "cg3/geometry/utils2.h"
+#include "algorithms/SpatialSort.h"
+#include "utils/allocationcounter.h"
+const size_t TrapezoidalMap::MAX_WALK_STEPS;
+const size_t TrapezoidalMap::WINDOW_PER_THREAD;
+
 // ----------------------- PUBLIC SECTION -----------------------
 TrapezoidalMap::~TrapezoidalMap() {
     // deleting the dag
@@ -19,6 +31,14 @@ TrapezoidalMap::~TrapezoidalMap() {
             delete *iterable_segment;
     segments.clear();
     segments.shrink_to_fit();
+
+    // release the scratch buffers used by the insertion
+    buffers.facesIntersected.clear();
+    buffers.facesIntersected.shrink_to_fit();
+    buffers.aboveSegmentNewFaces.clear();
+    buffers.aboveSegmentNewFaces.shrink_to_fit();
+    buffers.belowSegmentNewFaces.clear();
+    buffers.belowSegmentNewFaces.shrink_to_fit();
 }
 
 TrapezoidalMap::TrapezoidalMap() {}
@@ -35,7 +55,8 @@ void TrapezoidalMap::initialize(const cg3::BoundingBox2& B)
     auto bottomright = cg3::Point2d(B.max().x(), B.min().y());
     OrderedSegment* top = new OrderedSegment(topleft, topright);
     OrderedSegment* bottom = new OrderedSegment(bottomleft, bottomright);
-    DrawableTrapezoid*  boundingbox_trapezoid = new DrawableTrapezoid(*top, *bottom, bottomleft, topright);
+    // N.B. the trapezoid refers to the endpoints stored inside the segments, not to the local points
+    DrawableTrapezoid*  boundingbox_trapezoid = new DrawableTrapezoid(*top, *bottom, bottom->getLeftmost(), top->getRightmost());
     // Push the trapezoid inside the map
     this->addTrapezoidToMap(boundingbox_trapezoid);
 
@@ -49,23 +70,383 @@ void TrapezoidalMap::initialize(const cg3::BoundingBox2& B)
 
 
 void TrapezoidalMap::addSegment(const cg3::Segment2d& segment) {
+    // The id of the segment is its position in the insertion order
+    addSegment(segment, segmentNumber());
+}
+
+void TrapezoidalMap::addSegment(const cg3::Segment2d& segment, const size_t id) {
+    COUNT_ALLOCATIONS(ADD_SEGMENT);
+
     // The segment we receive is a stack object, so its memory will be freed at the end of the insertion: I need to save it dinamically
     // N.B. the new segment is ordered.
-    OrderedSegment* orderedSegment = new OrderedSegment(segment);
+    insertSegment(new OrderedSegment(segment, id));
+}
+
+void TrapezoidalMap::addSegments(const std::vector<cg3::Segment2d>& newSegments, size_t nThreads) {
+    if(nThreads == 0)
+        nThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    // A single thread doesn't need to claim the faces
+    if(nThreads == 1) {
+        for(const cg3::Segment2d& segment : newSegments)
+            addSegment(segment);
+        return;
+    }
+
+    /* The map takes the ownership of all the segments now, so the ids follow the order of the list.
+     * The position of a segment in the list "segments" is also its priority when it claims the faces. */
+    size_t insertedSegments = segmentNumber();
+    size_t next = segments.size();
+    for(const cg3::Segment2d& segment : newSegments)
+        segments.push_back(new OrderedSegment(segment, segmentNumber()));
+
+    // runs body(i, thread) for each i in [0, n): the i-th item goes to the thread i % nThreads (the calling thread is the thread 0)
+    auto parallelFor = [nThreads](const size_t n, const std::function<void(size_t, size_t)>& body) {
+        std::vector<std::thread> threads;
+        for(size_t thread = 1; thread < nThreads; thread++)
+            threads.push_back(std::thread([n, nThreads, thread, &body]() {
+                for(size_t i = thread; i < n; i += nThreads)
+                    body(i, thread);
+            }));
+        for(size_t i = 0; i < n; i += nThreads)
+            body(i, 0);
+        for(std::thread& thread : threads)
+            thread.join();
+    };
+
+    // The pending segments (their positions in "segments"), the faces they intersect and the faces they claim
+    std::vector<size_t> window;
+    std::vector<std::vector<DrawableTrapezoid*>> paths;
+    std::vector<std::vector<Trapezoid*>> claims;
+    std::vector<char> inserted;
+    std::vector<InsertionBuffers> threadBuffers(nThreads);
+
+    while(next < segments.size() || !window.empty()) {
+        /* Fill the window. A small map has few faces and almost every pair of segments would conflict,
+         * so the window grows with the number of segments already inserted. */
+        const size_t windowSize = std::min(nThreads * WINDOW_PER_THREAD, std::max(nThreads, insertedSegments / 16));
+        while(window.size() < windowSize && next < segments.size())
+            window.push_back(next++);
+        paths.resize(window.size());
+        claims.resize(window.size());
+        inserted.assign(window.size(), false);
+
+        // 1. Walk the faces intersected by each segment and claim them with their neighbors (the map is only read)
+        parallelFor(window.size(), [&](size_t i, size_t) {
+            const size_t owner = window[i];
+            paths[i].clear();
+            claims[i].clear();
+            walkSegment(*segments[owner], paths[i], false);
+
+            for(DrawableTrapezoid* face : paths[i]) {
+                claims[i].push_back(face);
+                Trapezoid* neighbors[Trapezoid::N_NEIGHBORS] = {
+                    face->getUpperLeftNeighbor(), face->getUpperRightNeighbor(),
+                    face->getLowerLeftNeighbor(), face->getLowerRightNeighbor()
+                };
+                for(Trapezoid* neighbor : neighbors)
+                    if(neighbor != nullptr)
+                        claims[i].push_back(neighbor);
+            }
+
+            // once a claim is lost the segment has to wait for the next round: the other faces are left to the next segments
+            for(Trapezoid* face : claims[i])
+                if(!face->claim(owner))
+                    break;
+        });
+
+        // 2. The segments owning all their claims touch disjoint faces: split them at the same time
+        parallelFor(window.size(), [&](size_t i, size_t thread) {
+            const size_t owner = window[i];
+            for(const Trapezoid* face : claims[i])
+                if(face->getClaim() != owner)
+                    return;
+
+            COUNT_ALLOCATIONS(ADD_SEGMENT);
+            InsertionBuffers& threadBuffer = threadBuffers[thread];
+            threadBuffer.facesIntersected.swap(paths[i]);
+            for(DrawableTrapezoid* face : threadBuffer.facesIntersected)
+                face->setIsBeingSplitted(true);
+            split(*segments[owner], threadBuffer);
+            inserted[i] = true;
+        });
+
+        // 3. Release the claims and keep the segments not inserted in the window
+        size_t kept = 0;
+        for(size_t i = 0; i < window.size(); i++) {
+            for(Trapezoid* face : claims[i])
+                face->releaseClaim();
+            if(inserted[i])
+                insertedSegments++;
+            else
+                window[kept++] = window[i];
+        }
+        window.resize(kept);
+    }
+}
+
+void TrapezoidalMap::addPolygon(const std::vector<cg3::Point2d>& ring, const size_t polygonId) {
+    assert(ring.size() >= 3);
+
+    // The orientation of the ring (shoelace formula): positive area => counterclockwise
+    double doubleArea = 0;
+    for(size_t i = 0; i < ring.size(); i++) {
+        const cg3::Point2d& a = ring[i];
+        const cg3::Point2d& b = ring[(i+1) % ring.size()];
+        doubleArea += a.x() * b.y() - b.x() * a.y();
+    }
+    const bool counterclockwise = doubleArea > 0;
+
+    for(size_t i = 0; i < ring.size(); i++) {
+        COUNT_ALLOCATIONS(ADD_SEGMENT);
+        const cg3::Point2d& a = ring[i];
+        const cg3::Point2d& b = ring[(i+1) % ring.size()];
+
+        /* The interior is on the left of the edges of a counterclockwise ring (on the right for a clockwise one):
+         * walking the edge from left to right, the left side is above. */
+        const bool goingRight = a < b;
+        OrderedSegment* edge = new OrderedSegment(cg3::Segment2d(a, b), segmentNumber());
+        edge->setPolygon(polygonId, goingRight == counterclockwise);
+        insertSegment(edge);
+    }
+}
+
+void TrapezoidalMap::labelPolygonFaces() {
+    // Index the trapezoids of the map (the split ones are not part of the map anymore)
+    std::unordered_map<const Trapezoid*, size_t> index;
+    std::vector<DrawableTrapezoid*> faces;
+    for(DrawableTrapezoid* t : T) {
+        if(!t->getIsBeingSplitted()) {
+            index.insert(std::make_pair(t, faces.size()));
+            faces.push_back(t);
+        }
+    }
+
+    // Union-find: the neighbors share a vertical wall, so they are in the same face
+    std::vector<size_t> parent(faces.size());
+    for(size_t i = 0; i < parent.size(); i++)
+        parent[i] = i;
+    auto find = [&parent](size_t i) {
+        while(parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    for(size_t i = 0; i < faces.size(); i++) {
+        const Trapezoid* neighbors[Trapezoid::N_NEIGHBORS] = {
+            faces[i]->getUpperLeftNeighbor(), faces[i]->getUpperRightNeighbor(),
+            faces[i]->getLowerLeftNeighbor(), faces[i]->getLowerRightNeighbor()
+        };
+        for(const Trapezoid* neighbor : neighbors) {
+            if(neighbor == nullptr)
+                continue;
+            auto neighborIndex = index.find(neighbor);
+            assert(neighborIndex != index.end());
+            parent[find(i)] = find(neighborIndex->second);
+        }
+    }
+
+    // The label of a face comes from the polygon edges having the interior of the polygon on the side of the face
+    std::vector<size_t> label(faces.size(), OrderedSegment::NO_ID);
+    for(size_t i = 0; i < faces.size(); i++) {
+        const OrderedSegment& top = faces[i]->getTop();
+        const OrderedSegment& bottom = faces[i]->getBottom();
+        if(top.getPolygonId() != OrderedSegment::NO_ID && !top.isPolygonInteriorAbove())
+            label[find(i)] = top.getPolygonId();
+        else if(bottom.getPolygonId() != OrderedSegment::NO_ID && bottom.isPolygonInteriorAbove())
+            label[find(i)] = bottom.getPolygonId();
+    }
+
+    for(size_t i = 0; i < faces.size(); i++)
+        faces[i]->setPolygonId(label[find(i)]);
+}
+
+size_t TrapezoidalMap::pointInPolygon(const cg3::Point2d& q) const {
+    return pointLocation(q)->getPolygonId();
+}
+
+void TrapezoidalMap::insertSegment(OrderedSegment* orderedSegment) {
     // Save the segment into the segment list
     segments.push_back(orderedSegment);
 
     // Find the faces in the trapezoidal map T that intersect the segment, sorted from left to right
-    auto facesIntersected = std::vector<DrawableTrapezoid*>();
-    followSegment(*orderedSegment , facesIntersected);
+    // N.B. the list is a scratch buffer of the map: its capacity is reused by the next insertions
+    assert(buffers.facesIntersected.empty());
+    followSegment(*orderedSegment , buffers.facesIntersected);
     // Split those faces and update the map/dag with the new faces
-    split(*orderedSegment , facesIntersected);
+    split(*orderedSegment , buffers);
 }
 
 DrawableTrapezoid* TrapezoidalMap::pointLocation(const cg3::Point2d& pointToQuery) const {
+    COUNT_ALLOCATIONS(POINT_LOCATION);
+
     return D.queryFaceContaininingPoint(pointToQuery);
 }
 
+DrawableTrapezoid* TrapezoidalMap::pointLocation(const cg3::Point2d& pointToQuery, const DrawableTrapezoid* hint) const {
+    COUNT_ALLOCATIONS(POINT_LOCATION);
+
+    // A split trapezoid is not in the map anymore: its neighbors are not valid
+    const Trapezoid* currentFace = (hint != nullptr && !hint->getIsBeingSplitted()) ? hint : nullptr;
+
+    for(size_t step = 0; currentFace != nullptr && step < MAX_WALK_STEPS; step++) {
+        const cg3::Point2d& leftp = currentFace->getLeftp();
+        const cg3::Point2d& rightp = currentFace->getRightp();
+
+        // q is on the left of the trapezoid (lexicographically, as in the DAG) => go through the left wall, above or below leftp
+        if(pointToQuery < leftp) {
+            Trapezoid* upper = currentFace->getUpperLeftNeighbor();
+            Trapezoid* lower = currentFace->getLowerLeftNeighbor();
+            currentFace = (upper != nullptr && (lower == nullptr || pointToQuery.y() >= leftp.y())) ? upper : lower;
+        }
+        // q is on the right of the trapezoid => go through the right wall, above or below rightp
+        else if(rightp < pointToQuery) {
+            Trapezoid* upper = currentFace->getUpperRightNeighbor();
+            Trapezoid* lower = currentFace->getLowerRightNeighbor();
+            currentFace = (upper != nullptr && (lower == nullptr || pointToQuery.y() >= rightp.y())) ? upper : lower;
+        }
+        // q is between the walls: either it's inside, or it's above/below (the walk can't go on)
+        else if(currentFace->containsPoint(pointToQuery)) {
+            return (DrawableTrapezoid*)currentFace;
+        }
+        else {
+            break;
+        }
+    }
+
+    // The walk failed: query the DAG
+    return D.queryFaceContaininingPoint(pointToQuery);
+}
+
+void TrapezoidalMap::pointLocation(const std::vector<cg3::Point2d>& pointsToQuery, std::vector<DrawableTrapezoid*>& result) const {
+    // Sort the points along the Morton curve (the list given in input is not modified)
+    std::vector<size_t> order;
+    SpatialSort::sortByMortonKey(pointsToQuery, this->getBoundingBox(), order);
+
+    // Locate them in that order, starting each walk from the previous result, and save the results in the original positions
+    result.resize(pointsToQuery.size());
+    DrawableTrapezoid* previousFace = nullptr;
+    for(size_t position : order) {
+        previousFace = pointLocation(pointsToQuery[position], previousFace);
+        result[position] = previousFace;
+    }
+}
+
+size_t TrapezoidalMap::rayShootUp(const cg3::Point2d& q) const {
+    // the first segment above q is the top of the trapezoid containing it
+    return pointLocation(q)->getTop().getId();
+}
+
+size_t TrapezoidalMap::rayShootDown(const cg3::Point2d& q) const {
+    // the first segment below q is the bottom of the trapezoid containing it
+    return pointLocation(q)->getBottom().getId();
+}
+
+void TrapezoidalMap::rayShootUp(const std::vector<cg3::Point2d>& points, std::vector<size_t>& ids) const {
+    std::vector<DrawableTrapezoid*> faces;
+    pointLocation(points, faces);
+
+    ids.resize(faces.size());
+    for(size_t i = 0; i < faces.size(); i++)
+        ids[i] = faces[i]->getTop().getId();
+}
+
+void TrapezoidalMap::rayShootDown(const std::vector<cg3::Point2d>& points, std::vector<size_t>& ids) const {
+    std::vector<DrawableTrapezoid*> faces;
+    pointLocation(points, faces);
+
+    ids.resize(faces.size());
+    for(size_t i = 0; i < faces.size(); i++)
+        ids[i] = faces[i]->getBottom().getId();
+}
+
+void TrapezoidalMap::facesCrossedBy(const cg3::Segment2d& segment, std::vector<DrawableTrapezoid*>& faces, std::vector<size_t>& segmentIds) const {
+    faces.clear();
+    segmentIds.clear();
+    const OrderedSegment s(segment);
+
+    // If the segment doesn't cross the segments of the map, the walk (as in the insertion) finds the faces
+    if(!walkSegment(s, faces, true)) {
+        // Otherwise search them through the DAG and keep only the ones really intersecting the segment, with the part of the segment inside them
+        faces.clear();
+        std::vector<DrawableTrapezoid*> candidates;
+        D.queryFacesIntersectingSegment(s, candidates);
+        // (entry point, exit point), face
+        typedef std::pair<std::pair<cg3::Point2d, cg3::Point2d>, DrawableTrapezoid*> CrossedFace;
+        std::vector<CrossedFace> crossed;
+        cg3::Point2d entry, exit;
+        for(DrawableTrapezoid* t : candidates)
+            if(t->clipSegment(s, entry, exit))
+                crossed.push_back(std::make_pair(std::make_pair(entry, exit), t));
+
+        // sort them along the segment (lexicographically): by the point where the segment enters them, then by the point where it leaves them.
+        // The segment can enter a face through its top or its bottom, where it crosses a segment of the map: the walls aren't enough
+        std::sort(crossed.begin(), crossed.end(), [](const CrossedFace& c1, const CrossedFace& c2) {
+            return c1.first < c2.first;
+        });
+        for(const CrossedFace& c : crossed)
+            faces.push_back(c.second);
+    }
+
+    // the distinct segments bounding the faces
+    std::unordered_set<size_t> segmentsFound;
+    for(const DrawableTrapezoid* t : faces) {
+        const size_t bounds[2] = {t->getTop().getId(), t->getBottom().getId()};
+        for(size_t id : bounds) {
+            if(id != OrderedSegment::NO_ID && segmentsFound.insert(id).second)
+                segmentIds.push_back(id);
+        }
+    }
+}
+
+void TrapezoidalMap::windowQuery(const cg3::BoundingBox2& box, std::vector<DrawableTrapezoid*>& trapezoids, std::vector<size_t>& segmentIds) const {
+    trapezoids.clear();
+    segmentIds.clear();
+
+    // Candidates: the trapezoids whose region in the DAG can intersect the box
+    std::vector<DrawableTrapezoid*> candidates;
+    D.queryFacesIntersectingBox(box, candidates);
+
+    std::unordered_set<size_t> segmentsFound;
+    for(DrawableTrapezoid* t : candidates) {
+        if(!t->intersectsBox(box))
+            continue;
+        trapezoids.push_back(t);
+
+        /* Every segment intersecting the box bounds a trapezoid intersecting the box (the one below it, at a point inside the box),
+         * so the segments are searched among the top and bottom of the trapezoids found. */
+        const OrderedSegment* bounds[2] = {&t->getTop(), &t->getBottom()};
+        for(const OrderedSegment* s : bounds) {
+            if(s->getId() == OrderedSegment::NO_ID || segmentsFound.count(s->getId()) > 0)
+                continue;
+            if(segmentIntersectsBox(*s, box)) {
+                segmentsFound.insert(s->getId());
+                segmentIds.push_back(s->getId());
+            }
+        }
+    }
+}
+
+size_t TrapezoidalMap::segmentNumber() const {
+    // the top and bottom segments of the bounding box are stored in the list too
+    return segments.size() >= 2 ? segments.size() - 2 : 0;
+}
+
+const DAG& TrapezoidalMap::getDAG() const {
+    return D;
+}
+
+const std::vector<DrawableTrapezoid*>& TrapezoidalMap::getTrapezoids() const {
+    return T;
+}
+
+const cg3::BoundingBox2 &TrapezoidalMap::getBoundingBox() const
+{
+    return B;
+}
+
 void TrapezoidalMap::clear() {
     // Cleaning the data dynamically instantiated
     this->~TrapezoidalMap();
@@ -82,66 +463,111 @@ void TrapezoidalMap::reset() {
 
 
 
-// ------------------------- PROTECTED SECTION -------------------------
-const cg3::BoundingBox2 &TrapezoidalMap::getBoundingBox() const
-{
-    return B;
+// ----------------------- PRIVATE SECTION -----------------------
+cg3::Point2d TrapezoidalMap::wallCrossing(const OrderedSegment& s, const cg3::Point2d& w) {
+    const cg3::Point2d& p = s.getLeftmost();
+    const cg3::Point2d& q = s.getRightmost();
+    if(p.x() == q.x())
+        return cg3::Point2d(p.x(), w.y());
+    if(w.x() == p.x())
+        return p;
+    if(w.x() == q.x())
+        return q;
+    return cg3::Point2d(w.x(), p.y() + (q.y() - p.y()) * (w.x() - p.x()) / (q.x() - p.x()));
 }
-// ----------------------- END PROTECTED SECTION -----------------------
-
-
 
+bool TrapezoidalMap::segmentIntersectsBox(const OrderedSegment& s, const cg3::BoundingBox2& box) {
+    // Liang-Barsky clipping: the segment is p + t*d with t in [0,1], it's clipped against the 4 sides of the box
+    const cg3::Point2d& p = s.getLeftmost();
+    const double d[2] = {s.getRightmost().x() - p.x(), s.getRightmost().y() - p.y()};
+    const double start[2] = {p.x(), p.y()};
+    const double min[2] = {box.min().x(), box.min().y()};
+    const double max[2] = {box.max().x(), box.max().y()};
+
+    double tEnter = 0, tExit = 1;
+    for(size_t axis = 0; axis < 2; axis++) {
+        if(d[axis] == 0) {
+            // parallel to the sides: it must be between them
+            if(start[axis] < min[axis] || start[axis] > max[axis])
+                return false;
+        }
+        else {
+            double t0 = (min[axis] - start[axis]) / d[axis];
+            double t1 = (max[axis] - start[axis]) / d[axis];
+            if(t0 > t1)
+                std::swap(t0, t1);
+            tEnter = std::max(tEnter, t0);
+            tExit = std::min(tExit, t1);
+            if(tEnter > tExit)
+                return false;
+        }
+    }
+    return true;
+}
 
-// ----------------------- PRIVATE SECTION -----------------------
 void TrapezoidalMap::setBoundingBox(const cg3::BoundingBox2 &newB)
 {
     B = newB;
 }
 
 void TrapezoidalMap::followSegment(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& facesIntersectingSegment) const {
+    // The segment to insert doesn't cross the other segments, so the walk is enough
+    walkSegment(s, facesIntersectingSegment, false);
+
+    // The faces found are going to be split
+    for(DrawableTrapezoid* face : facesIntersectingSegment)
+        face->setIsBeingSplitted(true);
+}
+
+bool TrapezoidalMap::walkSegment(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& facesIntersectingSegment, const bool checkCrossings) const {
     // 1. Let p and q be the left and right endpoint of the segment.
-    auto p = s.getLeftmost();
-    auto q = s.getRightmost();
+    const cg3::Point2d& p = s.getLeftmost();
+    const cg3::Point2d& q = s.getRightmost();
 
     // 2. Search with p in the search structure D to find d0.
     DrawableTrapezoid*  currentFace = D.queryLeftmostFaceIntersectingSegment(s);
-    facesIntersectingSegment.push_back(currentFace);
-    currentFace->setIsBeingSplitted(true);
 
-    //  while q lies to the right of rightp(dj)
-    while(currentFace != nullptr && q.x() > currentFace->getRightp().x()) {
+    while(currentFace != nullptr) {
+        facesIntersectingSegment.push_back(currentFace);
+
+        // the part of the segment in the x-range of the face must be inside the face: it's enough to check its endpoints (the face is convex)
+        if(checkCrossings) {
+            const cg3::Point2d entry = p < currentFace->getLeftp() ? wallCrossing(s, currentFace->getLeftp()) : p;
+            const cg3::Point2d exit  = currentFace->getRightp() < q ? wallCrossing(s, currentFace->getRightp()) : q;
+            if(!currentFace->containsPoint(entry) || !currentFace->containsPoint(exit))
+                return false;
+        }
+
+        //  while q lies to the right of rightp(dj) (lexicographically)
+        if(!(currentFace->getRightp() < q))
+            break;
 
         // if rightp(dj) lies above the segment => go on the LowerRight neighbor
-        if(cg3::isPointAtLeft(s.getLeftmost(), s.getRightmost(), currentFace->getRightp())) {
+        if(cg3::isPointAtLeft(p, q, currentFace->getRightp())) {
             currentFace = (DrawableTrapezoid*)currentFace->getLowerRightNeighbor();
         }
         // else if rightp(dj) lies below the segment => go on the UpperRight neighbor
-        /// else if(cg3::isPointAtRight(s.getLeftmost(), s.getRightmost(), currentFace->getRightp())) can be deleted safely
+        /* else rightp(dj) is on the segment.
+         * This can happen only if q = rightp, but this condition is impossible since we already checked that q > rightp,
+         * so this case should be impossible (for a query segment crossing the map, either neighbor touches the segment) */
         else  {
             currentFace = (DrawableTrapezoid*)currentFace->getUpperRightNeighbor();
         }
-        /* else rightp(dj) is on the segment.
-         * This can happen only if q.x = rightp.x, but this condition is impossible since we already checked that q.x > rightp.x,
-         * so this case should be impossible */
-//        else {
-//            assert(false);
-//        }
-
-
-        if(currentFace != nullptr) {
-            facesIntersectingSegment.push_back(currentFace);
-            currentFace->setIsBeingSplitted(true);
-        }
     }
+
+    // the walk went out of the map
+    return currentFace != nullptr || !checkCrossings;
 }
 
 
-void TrapezoidalMap::split(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& intersectingFaces) {
+void TrapezoidalMap::split(const OrderedSegment& s, InsertionBuffers& buffers) {
+    std::vector<DrawableTrapezoid*>& intersectingFaces = buffers.facesIntersected;
+
     /* Split the faces, insert the new ones into the trapezoidal map and update the DAG. */
     if(intersectingFaces.size()== 1) {
         splitSingularTrapezoid(s, intersectingFaces.front());
     } else {
-        splitMultipleTrapezoid(s, intersectingFaces);
+        splitMultipleTrapezoid(s, buffers);
     }
 
 
@@ -174,7 +600,7 @@ void TrapezoidalMap::splitSingularTrapezoid(const OrderedSegment& s, DrawableTra
     /* SETTING THE ADJACENCIES FOR THE NEW FACES */
     // left
     if(leftFaceExists) {
-        leftNewFace->replaceNeighborsFromTrapezoid(faceToSplit, {Trapezoid::TOPLEFT, Trapezoid::BOTTOMLEFT});
+        leftNewFace->replaceNeighborsFromTrapezoid(faceToSplit, Trapezoid::LEFT_MASK);
         leftNewFace->setUpperRightNeighbor(topNewFace);
         leftNewFace->setLowerRightNeighbor(bottomNewFace);
     }
@@ -183,30 +609,30 @@ void TrapezoidalMap::splitSingularTrapezoid(const OrderedSegment& s, DrawableTra
     if(leftFaceExists)
         topNewFace->setUpperLeftNeighbor(leftNewFace);
     else
-        topNewFace->replaceNeighborsFromTrapezoid(faceToSplit, {Trapezoid::TOPLEFT});
+        topNewFace->replaceNeighborsFromTrapezoid(faceToSplit, Trapezoid::TOPLEFT_MASK);
 
     if(rightFaceExists)
         topNewFace->setUpperRightNeighbor(rightNewFace);
     else
-        topNewFace->replaceNeighborsFromTrapezoid(faceToSplit, {Trapezoid::TOPRIGHT});
+        topNewFace->replaceNeighborsFromTrapezoid(faceToSplit, Trapezoid::TOPRIGHT_MASK);
 
     // right
     if(rightFaceExists) {
         rightNewFace->setUpperLeftNeighbor(topNewFace);
         rightNewFace->setLowerLeftNeighbor(bottomNewFace);
-        rightNewFace->replaceNeighborsFromTrapezoid(faceToSplit, {Trapezoid::TOPRIGHT, Trapezoid::BOTTOMRIGHT});
+        rightNewFace->replaceNeighborsFromTrapezoid(faceToSplit, Trapezoid::RIGHT_MASK);
     }
 
     // bottom
     if(leftFaceExists)
         bottomNewFace->setLowerLeftNeighbor(leftNewFace);
     else
-        bottomNewFace->replaceNeighborsFromTrapezoid(faceToSplit, {Trapezoid::BOTTOMLEFT});
+        bottomNewFace->replaceNeighborsFromTrapezoid(faceToSplit, Trapezoid::BOTTOMLEFT_MASK);
 
     if(rightFaceExists)
         bottomNewFace->setLowerRightNeighbor(rightNewFace);
     else
-        bottomNewFace->replaceNeighborsFromTrapezoid(faceToSplit, {Trapezoid::BOTTOMRIGHT});
+        bottomNewFace->replaceNeighborsFromTrapezoid(faceToSplit, Trapezoid::BOTTOMRIGHT_MASK);
 
 
     // Add the new faces into the trapezoidal map
@@ -221,12 +647,16 @@ void TrapezoidalMap::splitSingularTrapezoid(const OrderedSegment& s, DrawableTra
     D.replaceNodeWithSubtree(faceToSplit->getPointerToDAG(), s, leftNewFace, topNewFace, bottomNewFace, rightNewFace);
 }
 
-void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& intersectingFaces) {
+void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, InsertionBuffers& buffers) {
+    std::vector<DrawableTrapezoid*>& intersectingFaces = buffers.facesIntersected;
     DrawableTrapezoid *firstFace = nullptr, *lastFace = nullptr, *topNewFace, *bottomNewFace;
     const size_t N_FACES = intersectingFaces.size();
     // the faces above the segment are managed differently from the faces below the segment, so I save them in two sepated lists
-    std::vector<DrawableTrapezoid*> aboveSegmentNewFaces(N_FACES);
-    std::vector<DrawableTrapezoid*> belowSegmentNewFaces(N_FACES);
+    // (scratch buffers of the insertion: no allocation happens if their capacity is already enough)
+    std::vector<DrawableTrapezoid*>& aboveSegmentNewFaces = buffers.aboveSegmentNewFaces;
+    std::vector<DrawableTrapezoid*>& belowSegmentNewFaces = buffers.belowSegmentNewFaces;
+    aboveSegmentNewFaces.assign(N_FACES, nullptr);
+    belowSegmentNewFaces.assign(N_FACES, nullptr);
 
     // if the leftmost endpoint of the segment is equal to the left point of the first trapezoid to split, do NOT create the left face
     bool firstFaceExists = s.getLeftmost() != intersectingFaces.front()->getLeftp();
@@ -248,7 +678,7 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
             if(firstFaceExists) {
                 // Create the first face and set its 4 neighbors
                 firstFace = new DrawableTrapezoid(oldFace->getTop(), oldFace->getBottom(), oldFace->getLeftp(), s.getLeftmost());
-                firstFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::TOPLEFT, Trapezoid::BOTTOMLEFT});
+                firstFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::LEFT_MASK);
                 firstFace->setUpperRightNeighbor(topNewFace);
                 firstFace->setLowerRightNeighbor(bottomNewFace);
             }
@@ -268,7 +698,7 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
 
                 lastFace->setUpperLeftNeighbor(topNewFace);
                 lastFace->setLowerLeftNeighbor(bottomNewFace);
-                lastFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::TOPRIGHT, Trapezoid::BOTTOMRIGHT});
+                lastFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::RIGHT_MASK);
             }
         }
 
@@ -293,7 +723,7 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
         if(i==0) {
             // if the old face has an upper right neighbor that's not a split face, link the top face to it
             if(intersectingFaces.at(i)->getUpperRightNeighbor()!=nullptr && !intersectingFaces.at(i)->getUpperRightNeighbor()->getIsBeingSplitted()) {
-                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::TOPRIGHT});
+                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::TOPRIGHT_MASK);
             }
 
             // the lower right neighbor is the next top face
@@ -303,7 +733,7 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
             if(firstFaceExists)
                 tmpTopFace->setUpperLeftNeighbor(firstFace);
             else {
-                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::TOPLEFT});
+                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::TOPLEFT_MASK);
             }
 
         }
@@ -314,7 +744,7 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
                 tmpTopFace->setUpperRightNeighbor(lastFace);
             }
             else {
-                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::TOPRIGHT});
+                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::TOPRIGHT_MASK);
             }
 
             // the lower left neighbor is the previous top face
@@ -322,14 +752,14 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
 
             // if the old face has an upper left neighbor that's not a split face, link the top face to it
             if(intersectingFaces.at(i)->getUpperLeftNeighbor()!=nullptr && !intersectingFaces.at(i)->getUpperLeftNeighbor()->getIsBeingSplitted()) {
-                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::TOPLEFT});
+                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::TOPLEFT_MASK);
             }
         }
         // 1...k-1 top faces
         else {
             // if the old face has an upper right neighbor that's not a split face, link the top face to it
             if(intersectingFaces.at(i)->getUpperRightNeighbor()!=nullptr && !intersectingFaces.at(i)->getUpperRightNeighbor()->getIsBeingSplitted()) {
-                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::TOPRIGHT});
+                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::TOPRIGHT_MASK);
             }
 
             // the lower right neighbor is the next top face
@@ -340,7 +770,7 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
 
             // if the old face has an upper left neighbor that's not a split face, link the top face to it
             if(intersectingFaces.at(i)->getUpperLeftNeighbor()!=nullptr && !intersectingFaces.at(i)->getUpperLeftNeighbor()->getIsBeingSplitted()) {
-                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::TOPLEFT});
+                tmpTopFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::TOPLEFT_MASK);
             }
         }
     }
@@ -355,14 +785,14 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
 
             // if the old face has a lower right neighbor that's not a split face, link the bottom face to it
             if(intersectingFaces.at(i)->getLowerRightNeighbor()!=nullptr && !intersectingFaces.at(i)->getLowerRightNeighbor()->getIsBeingSplitted()) {
-                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::BOTTOMRIGHT});
+                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::BOTTOMRIGHT_MASK);
             }
 
             // if the first face exists, link the bottom face to it, otherwise link it to the bottom left neighbor of the old face
             if(firstFaceExists)
                 tmpBottomFace->setLowerLeftNeighbor(firstFace);
             else {
-                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::BOTTOMLEFT});
+                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::BOTTOMLEFT_MASK);
             }
 
         }
@@ -372,12 +802,12 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
             if(lastFaceExists)
                 tmpBottomFace->setLowerRightNeighbor(lastFace);
             else {
-                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::BOTTOMRIGHT});
+                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::BOTTOMRIGHT_MASK);
             }
 
             // if the old face has a lower left neighbor that's not a split face, link the bottom face to it
             if(intersectingFaces.at(i)->getLowerLeftNeighbor()!=nullptr && !intersectingFaces.at(i)->getLowerLeftNeighbor()->getIsBeingSplitted()) {
-                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::BOTTOMLEFT});
+                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::BOTTOMLEFT_MASK);
             }
 
             // the upper left neighbor is the previous bottom face
@@ -390,12 +820,12 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
 
             // if the old face has a lower right neighbor that's not a split face, link the bottom face to it
             if(intersectingFaces.at(i)->getLowerRightNeighbor()!=nullptr && !intersectingFaces.at(i)->getLowerRightNeighbor()->getIsBeingSplitted()) {
-                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::BOTTOMRIGHT});
+                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::BOTTOMRIGHT_MASK);
             }
 
             // if the old face has a lower left neighbor that's not a split face, link the bottom face to it
             if(intersectingFaces.at(i)->getLowerLeftNeighbor()!=nullptr && !intersectingFaces.at(i)->getLowerLeftNeighbor()->getIsBeingSplitted()) {
-                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), {Trapezoid::BOTTOMLEFT});
+                tmpBottomFace->replaceNeighborsFromTrapezoid(intersectingFaces.at(i), Trapezoid::BOTTOMLEFT_MASK);
             }
 
             // the upper left neighbor is the previous bottom face
@@ -421,7 +851,7 @@ void TrapezoidalMap::splitMultipleTrapezoid(const OrderedSegment& s, std::vector
         D.replaceNodeWithSubtree(intersectingFaces.at(i)->getPointerToDAG(), s, tmpLeft, aboveSegmentNewFaces.at(i), belowSegmentNewFaces.at(i), tmpRight);
     }
 
-    // Empty the two lists used in this function.
+    // Empty the two lists used in this function (their capacity is kept for the next insertion).
     aboveSegmentNewFaces.clear();
     belowSegmentNewFaces.clear();
 }
@@ -448,8 +878,8 @@ void TrapezoidalMap::stepMerging(size_t start, size_t end, std::vector<DrawableT
              *          the left neighbors from the leftmost trapezoid
              *          the right neighbors from the rightmost trapezoid
             */
-            mergedFace->replaceNeighborsFromTrapezoid(list.at(i), {Trapezoid::TOPLEFT, Trapezoid::BOTTOMLEFT});
-            mergedFace->replaceNeighborsFromTrapezoid(list.at(j), {Trapezoid::TOPRIGHT, Trapezoid::BOTTOMRIGHT});
+            mergedFace->replaceNeighborsFromTrapezoid(list.at(i), Trapezoid::LEFT_MASK);
+            mergedFace->replaceNeighborsFromTrapezoid(list.at(j), Trapezoid::RIGHT_MASK);
 
             // Replace the old merged trapezoids with the new one.
             // Deallocate the old merged trapezoids (from i to j).
@@ -478,13 +908,10 @@ void TrapezoidalMap::stepMerging(size_t start, size_t end, std::vector<DrawableT
 void TrapezoidalMap::addTrapezoidToMap(DrawableTrapezoid* trapezoidToAdd) {
     assert(trapezoidToAdd != nullptr);
 
-    // if the graphics has not been calculated yet, do it now
-    if(!trapezoidToAdd->isGraphicsCalculated())
-        trapezoidToAdd->calculateGraphics();
-
-    assert(trapezoidToAdd->isGraphicsCalculated());
+    // The graphics (color and verteces) are computed only when the trapezoid is drawn (see DrawableTrapezoidalMap::draw)
 
     // Push the trapezoid into the list
+    std::lock_guard<std::mutex> lock(TMutex);
     T.push_back(trapezoidToAdd);
 }
 
@@ -1,11 +1,14 @@
 #ifndef TRAPEZOIDALMAP_H
 #define TRAPEZOIDALMAP_H
 
+#include <mutex>
+
 #include "dag.h"
 #include "drawables/drawabletrapezoid.h"
 #include "cg3/geometry/bounding_box2.h"
+#include "pointlocator.h"
 
-class TrapezoidalMap
+class TrapezoidalMap : public PointLocator
 {
 public:
     // Constructor
@@ -30,6 +33,51 @@ public:
      */
     void addSegment(const cg3::Segment2d& segment);
 
+    /**
+     * @brief addSegment        inserts a new segment in the trapezoidal map, labelling it with a given id (see addSegment(segment)).
+     * @param segment           the new segment.
+     * @param id                the id returned by the ray-shooting queries for this segment (e.g. its index in the dataset).
+     *                          addSegment(segment) uses the number of segments inserted before it.
+     */
+    void addSegment(const cg3::Segment2d& segment, const size_t id);
+
+    /**
+     * @brief addSegments       inserts a batch of segments with several threads. The result is the same trapezoidal map built by addSegment,
+     *                          and each segment gets the id it would get by addSegment(segment) (the next one of the insertion order).
+     * The insertion goes by rounds over a window of pending segments:
+     *      1. the threads walk the faces intersected by the segments (the map is only read) and claim them, together with their neighbors
+     *         (they are modified by the split too). Each face is claimed atomically by the segment coming first in the insertion order;
+     *      2. the segments owning all their claims don't share any face, so the threads split their faces and update the DAG at the same time;
+     *      3. the claims are released, the other segments (conflicting with a previous one) are walked again in the next round.
+     * @param segments          the new segments (they must not cross each other nor the segments of the map).
+     * @param nThreads          the number of threads (0 means one for each core). With 1 thread the segments are simply inserted one by one.
+     */
+    void addSegments(const std::vector<cg3::Segment2d>& segments, size_t nThreads = 0);
+
+    /**
+     * @brief addPolygon        inserts the edges of a closed polygon in the trapezoidal map (the last vertex is connected to the first one).
+     * The edges must not cross the other segments. Each edge gets the next id of the insertion order, as in addSegment(segment).
+     * Once all the polygons are inserted, labelPolygonFaces() computes the polygon containing each trapezoid.
+     * @param ring              the vertices of the polygon (at least 3), either clockwise or counterclockwise.
+     * @param polygonId         the id of the polygon, returned by pointInPolygon for the points inside it.
+     */
+    void addPolygon(const std::vector<cg3::Point2d>& ring, const size_t polygonId);
+
+    /**
+     * @brief labelPolygonFaces     sets the polygon id of every trapezoid of the map.
+     * The trapezoids sharing a vertical wall (i.e. neighbors) lie in the same face: the faces are found with a union-find over the neighbor links.
+     * A face is inside a polygon if one of its trapezoids has an edge of that polygon as top or bottom, with the interior of the polygon on its side.
+     * It must be called again after inserting new segments.
+     */
+    void labelPolygonFaces();
+
+    /**
+     * @brief pointInPolygon    finds the polygon containing a point. The faces must have been labelled by labelPolygonFaces().
+     * @param q                 the query point.
+     * @return                  the id of the polygon (the innermost one if they are nested), OrderedSegment::NO_ID if it's outside every polygon.
+     */
+    size_t pointInPolygon(const cg3::Point2d& q) const;
+
     /**
      * @brief pointLocation     query a point in the trapezoidal map.
      * @param pointToQuery      the query point.
@@ -37,6 +85,81 @@ public:
      */
     DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery) const;
 
+    /**
+     * @brief pointLocation     query a point starting from a trapezoid near to it (e.g. the result of the previous query).
+     * The walk moves from the hint through the left/right neighbors toward the point. The vertical adjacencies are not stored,
+     * so if the point lies above or below the current trapezoid, or if the walk is longer than MAX_WALK_STEPS, the DAG is queried.
+     * @param pointToQuery      the query point.
+     * @param hint              the trapezoid from which the walk starts. If it's null or it has been split, the DAG is queried.
+     * @return                  a (drawable) trapezoid containing the query point.
+     *                          If the point is on the boundary of several trapezoids, it could differ from the one returned by the DAG.
+     */
+    DrawableTrapezoid* pointLocation(const cg3::Point2d& pointToQuery, const DrawableTrapezoid* hint) const;
+
+    /**
+     * @brief pointLocation     query a batch of points. The points are located in the order of the Morton curve,
+     *                          so consecutive queries are close to each other and each one starts its walk from the previous result.
+     * @param pointsToQuery     the query points.
+     * @param [out] result      the (drawable) trapezoids containing the query points, in the same order of the points.
+     */
+    void pointLocation(const std::vector<cg3::Point2d>& pointsToQuery, std::vector<DrawableTrapezoid*>& result) const;
+
+    /**
+     * @brief rayShootUp        finds the input segment directly above a point (i.e. the first hit by a vertical ray going up).
+     * @param q                 the query point.
+     * @return                  the id of the segment, OrderedSegment::NO_ID if the ray hits the bounding box.
+     *                          If q lies on a segment, that segment can be returned.
+     */
+    size_t rayShootUp(const cg3::Point2d& q) const;
+
+    /**
+     * @brief rayShootDown      finds the input segment directly below a point (i.e. the first hit by a vertical ray going down).
+     * @param q                 the query point.
+     * @return                  the id of the segment, OrderedSegment::NO_ID if the ray hits the bounding box.
+     *                          If q lies on a segment, that segment can be returned.
+     */
+    size_t rayShootDown(const cg3::Point2d& q) const;
+
+    /**
+     * @brief rayShootUp/rayShootDown   batch versions of the ray-shooting queries (the points are located as in the batch pointLocation).
+     * @param points                    the query points.
+     * @param [out] ids                 the ids of the segments hit, in the same order of the points.
+     */
+    void rayShootUp(const std::vector<cg3::Point2d>& points, std::vector<size_t>& ids) const;
+    void rayShootDown(const std::vector<cg3::Point2d>& points, std::vector<size_t>& ids) const;
+
+    /**
+     * @brief facesCrossedBy        finds the trapezoids crossed by a segment, without inserting it (the map is not modified, so it's thread-safe).
+     * The segment can cross the segments of the map: in that case the trapezoids are searched through the DAG.
+     * @param segment               the query segment.
+     * @param [out] faces           the trapezoids crossed by the segment, in the order the segment crosses them from its leftmost endpoint
+     *                              (lexicographically) to the rightmost one. It's not the order of their leftp: a face stacked above
+     *                              or below another one can start before it and still be crossed after it.
+     * @param [out] segmentIds      the ids of the (distinct) input segments bounding those trapezoids (top or bottom).
+     */
+    void facesCrossedBy(const cg3::Segment2d& segment, std::vector<DrawableTrapezoid*>& faces, std::vector<size_t>& segmentIds) const;
+
+    /**
+     * @brief windowQuery           reports the trapezoids and the input segments intersecting a box (e.g. a viewport or a tile).
+     * The DAG is visited only in the nodes whose region can intersect the box, then the trapezoids found are checked exactly.
+     * @param box                   the query box.
+     * @param [out] trapezoids      the trapezoids intersecting the box.
+     * @param [out] segmentIds      the ids of the (distinct) input segments intersecting the box.
+     */
+    void windowQuery(const cg3::BoundingBox2& box, std::vector<DrawableTrapezoid*>& trapezoids, std::vector<size_t>& segmentIds) const;
+
+    // get the number of segments inserted into the map (the bounding box is not counted)
+    size_t segmentNumber() const;
+
+    // get the DAG used as search structure (read-only)
+    const DAG& getDAG() const;
+
+    // get the list of trapezoids (read-only). The faces split by an insertion are kept, flagged by getIsBeingSplitted()
+    const std::vector<DrawableTrapezoid*>& getTrapezoids() const;
+
+    // get the bounding box
+    const cg3::BoundingBox2 &getBoundingBox() const;
+
 
     // the trapezoidal map and the DAG inside it. All the memory dynamically allocated will be freed.
     void clear();
@@ -48,10 +171,13 @@ protected:
     // list of trapezoids in the map
     std::vector<DrawableTrapezoid*> T;
 
-    // get the bounding box
-    const cg3::BoundingBox2 &getBoundingBox() const;
-
 private:
+    // maximum number of trapezoids visited by the walk of pointLocation before falling back to the DAG
+    static const size_t MAX_WALK_STEPS = 32;
+
+    // maximum number of pending segments of each thread in a round of addSegments
+    static const size_t WINDOW_PER_THREAD = 64;
+
     // list of the segments inserted into the map
     std::vector<OrderedSegment*> segments;
 
@@ -61,9 +187,38 @@ private:
     // The bounding box used to initialize the trapezoidal map.
     cg3::BoundingBox2 B;
 
+    /* Scratch buffers used by an insertion: the faces intersected by the new segment and the new faces above/below it.
+     * They are emptied at the end of every insertion but their capacity is kept, so a warmed-up map doesn't allocate them again. */
+    struct InsertionBuffers {
+        std::vector<DrawableTrapezoid*> facesIntersected;
+        std::vector<DrawableTrapezoid*> aboveSegmentNewFaces;
+        std::vector<DrawableTrapezoid*> belowSegmentNewFaces;
+    };
+    // buffers of addSegment (each thread of addSegments uses its own ones)
+    InsertionBuffers buffers;
+
+    // protects T: the concurrent insertion (addSegments) adds the new faces from several threads
+    std::mutex TMutex;
+
     // set the bounding box containing the trapezoidal map
     void setBoundingBox(const cg3::BoundingBox2 &newB);
 
+    // returns true if a segment intersects a box (touching counts as intersecting)
+    static bool segmentIntersectsBox(const OrderedSegment& s, const cg3::BoundingBox2& box);
+
+    /**
+     * @brief wallCrossing  returns the point where a segment crosses the vertical wall through a point w, with leftmost < w < rightmost.
+     *                      With the symbolic shear, a wall through a point with the same x of an endpoint is crossed at that endpoint,
+     *                      and a vertical segment crosses every wall at the height of w.
+     */
+    static cg3::Point2d wallCrossing(const OrderedSegment& s, const cg3::Point2d& w);
+
+    /**
+     * @brief insertSegment     inserts a segment in the trapezoidal map (see addSegment): the map takes the ownership of it.
+     * @param orderedSegment    the new segment, dynamically allocated.
+     */
+    void insertSegment(OrderedSegment* orderedSegment);
+
     /**
      * @brief followSegment                     searches for all the trapezoid intersecting a given segment.
      * @param s                                 the query segment.
@@ -71,13 +226,24 @@ private:
      */
     void followSegment(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& facesIntersectingSegment) const;
 
+    /**
+     * @brief walkSegment                       walks the trapezoids intersecting a segment from left to right through the right neighbors, without modifying them.
+     *                                          The walk is correct only if the segment doesn't cross the segments of the map.
+     * @param s                                 the query segment.
+     * @param [out] facesIntersectingSegment    the faces intersecting the segment will be appended to this list
+     * @param checkCrossings                    if true, every face is checked to contain the part of the segment in its x-range
+     *                                          (i.e. the segment doesn't leave it through the top or the bottom).
+     * @return                                  false if a check failed (the list is incomplete), true otherwise.
+     */
+    bool walkSegment(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& facesIntersectingSegment, const bool checkCrossings) const;
+
     ///////////////////////////////////////// Split ////////////////////////////////////////////
     /**
      * @brief split                 split all the trapezoids intersected by a segment. The new faces will be added into the data structures, while the old ones will be deleted.
      * @param s                     the segment splitting the trapezoids
-     * @param intersectingFaces     the list of trapezoids intersecting the segment
+     * @param buffers               the buffers of the insertion: facesIntersected contains the list of trapezoids intersecting the segment (emptied at the end)
      */
-    void split(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& intersectingFaces);
+    void split(const OrderedSegment& s, InsertionBuffers& buffers);
 
     /**
      * @brief splitSingularTrapezoid        contains the logic for splitting a trapezoid containing a segment.
@@ -91,9 +257,9 @@ private:
      * @brief splitMultipleTrapezoid        contains the logic for splitting a list of trapezoids intersecting a segment.
      *                                      The new faces will be added into the data structures, while the old one will NOT be deleted here.
      * @param s                             the (ordered) segment.
-     * @param intersectingFaces             the list of trapezoids to split.
+     * @param buffers                       the buffers of the insertion: facesIntersected contains the list of trapezoids to split.
      */
-    void splitMultipleTrapezoid(const OrderedSegment& s, std::vector<DrawableTrapezoid*>& intersectingFaces);
+    void splitMultipleTrapezoid(const OrderedSegment& s, InsertionBuffers& buffers);
 
     /**
      * @brief stepMerging       contains the logic for checking and merging (if possible) the trapezoids contained in a list. The new trapezoids will be added into the trapezoidal map (but not into the DAG yet).
@@ -107,7 +273,7 @@ private:
     /////////////////////////////////////////////////////////////////////////////////////
 
     /**
-     * @brief addTrapezoidToMap     adds a (drawable) trapezoid to the trapezoidal map (but not into the DAG). Before doing this, the trapezoid graphics is calculated.
+     * @brief addTrapezoidToMap     adds a (drawable) trapezoid to the trapezoidal map (but not into the DAG). Its graphics are calculated only when it is drawn.
      * @param trapezoidToAdd        the trapezoid to insert
      */
     void addTrapezoidToMap(DrawableTrapezoid* trapezoidToAdd);
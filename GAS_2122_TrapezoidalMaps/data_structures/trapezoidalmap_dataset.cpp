@@ -1,5 +1,10 @@
 #include "trapezoidalmap_dataset.h"
 
+#include <algorithm>
+
+#include "algorithms/SegmentIntersections.h"
+#include "utils/allocationcounter.h"
+
 TrapezoidalMapDataset::TrapezoidalMapDataset() :
     boundingBox(cg3::Point2d(0,0),cg3::Point2d(0,0))
 {
@@ -13,13 +18,8 @@ size_t TrapezoidalMapDataset::addPoint(const cg3::Point2d& point, bool& pointIns
 
     pointInserted = false;
 
-    bool generalPosition = true;
-    if (xCoordSet.find(point.x()) != xCoordSet.end()) {
-        generalPosition = false;
-    }
-
     //Point will be inserted
-    if (!found && generalPosition) {
+    if (!found) {
         pointInserted = true;
 
         id = points.size();
@@ -28,7 +28,6 @@ size_t TrapezoidalMapDataset::addPoint(const cg3::Point2d& point, bool& pointIns
         points.push_back(point);
 
         pointMap.insert(std::make_pair(point, id));
-        xCoordSet.insert(point.x());
 
         //Update bounding box
         boundingBox.setMax(cg3::Point2d(
@@ -44,6 +43,8 @@ size_t TrapezoidalMapDataset::addPoint(const cg3::Point2d& point, bool& pointIns
 
 size_t TrapezoidalMapDataset::addSegment(const cg3::Segment2d& segment, bool& segmentInserted)
 {
+    COUNT_ALLOCATIONS(DATASET_ADD_SEGMENT);
+
     size_t id;
 
     cg3::Segment2d orderedSegment = segment;
@@ -61,56 +62,102 @@ size_t TrapezoidalMapDataset::addSegment(const cg3::Segment2d& segment, bool& se
     id = std::numeric_limits<size_t>::max();
 
     if (!degenerate && !found) {
-        bool generalPosition = true;
-
-        bool foundPoint1;
-        size_t id1 = findPoint(orderedSegment.p1(), foundPoint1);
-        bool foundPoint2;
-        size_t id2 = findPoint(orderedSegment.p2(), foundPoint2);
+        updateIntersectionChecker();
+        bool intersecting = intersectionChecker.checkIntersections(orderedSegment);
 
-        if (!foundPoint1 && xCoordSet.find(orderedSegment.p1().x()) != xCoordSet.end()) {
-            generalPosition = false;
-        }
-        if (!foundPoint2 && xCoordSet.find(orderedSegment.p2().x()) != xCoordSet.end()) {
-            generalPosition = false;
-        }
+        if (!intersecting) {
+            segmentInserted = true;
 
-        if (generalPosition) {
-            bool intersecting = intersectionChecker.checkIntersections(orderedSegment);
+            id = insertValidSegment(orderedSegment);
 
-            if (!intersecting) {
-                segmentInserted = true;
+            updateIntersectionChecker();
+        }
+    }
 
-                id = indexedSegments.size();
+    return id;
+}
 
-                if (!foundPoint1) {
-                    bool insertedPoint1;
-                    id1 = addPoint(orderedSegment.p1(), insertedPoint1);
-                    assert(insertedPoint1);
-                }
+size_t TrapezoidalMapDataset::addSegments(
+        const std::vector<cg3::Segment2d>& segments,
+        std::vector<bool>& segmentsInserted,
+        std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>>& intersectingSegments)
+{
+    COUNT_ALLOCATIONS(DATASET_ADD_SEGMENTS);
+
+    segmentsInserted.assign(segments.size(), false);
+    intersectingSegments.clear();
+
+    //The segments already in the dataset come first: they don't intersect each other, so the sweep keeps them
+    std::vector<cg3::Segment2d> sweepSegments = getSegments();
+    const size_t firstNew = sweepSegments.size();
+
+    //Order the endpoints, skip the degenerate segments and the duplicates (of the dataset or of the list)
+    std::vector<cg3::Segment2d> orderedSegments(segments.size());
+    std::vector<std::pair<std::pair<cg3::Point2d, cg3::Point2d>, size_t>> sorted;
+    for (size_t i = 0; i < segments.size(); i++) {
+        orderedSegments[i] = segments[i];
+        if (segments[i].p2() < segments[i].p1()) {
+            orderedSegments[i].setP1(segments[i].p2());
+            orderedSegments[i].setP2(segments[i].p1());
+        }
 
-                if (!foundPoint2) {
-                    bool insertedPoint2;
-                    id2 = addPoint(orderedSegment.p2(), insertedPoint2);
-                    assert(insertedPoint2);
-                }
-                assert(id1 != id2 && id1 < points.size() && id2 < points.size());
+        bool found;
+        findSegment(orderedSegments[i], found);
+        if (!found && orderedSegments[i].p1() != orderedSegments[i].p2()) {
+            sorted.push_back(std::make_pair(std::make_pair(orderedSegments[i].p1(), orderedSegments[i].p2()), i));
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
 
-                IndexedSegment2d indexedSegment(id1, id2);
-                if (indexedSegment.second < indexedSegment.first) {
-                    std::swap(indexedSegment.first, indexedSegment.second);
-                }
+    //The candidates (the first occurrence of each segment), in the order of the list
+    std::vector<size_t> candidates;
+    for (size_t j = 0; j < sorted.size(); j++) {
+        if (j == 0 || sorted[j].first != sorted[j-1].first) {
+            candidates.push_back(sorted[j].second);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
 
-                indexedSegments.push_back(indexedSegment);
+    for (size_t i : candidates) {
+        sweepSegments.push_back(orderedSegments[i]);
+    }
 
-                segmentMap.insert(std::make_pair(indexedSegment, id));
+    //A single sweep discards the segments intersecting the others
+    std::vector<bool> discarded;
+    std::vector<SegmentIntersections::IntersectingPair> pairs;
+    SegmentIntersections::discardIntersecting(sweepSegments, discarded, pairs);
+    for (const SegmentIntersections::IntersectingPair& pair : pairs) {
+        intersectingSegments.push_back(std::make_pair(sweepSegments[pair.first], sweepSegments[pair.second]));
+    }
 
-                intersectionChecker.insert(orderedSegment);
-            }
+    //Insert the segments kept, in the order of the list. They're added to the intersection checker only when it's needed
+    //again (by addSegment), so loading a file doesn't pay for its tree
+    size_t inserted = 0;
+    for (size_t j = 0; j < candidates.size(); j++) {
+        if (!discarded[firstNew + j]) {
+            insertValidSegment(sweepSegments[firstNew + j]);
+            segmentsInserted[candidates[j]] = true;
+            inserted++;
         }
     }
 
-    return id;
+    return inserted;
+}
+
+size_t TrapezoidalMapDataset::addNodedSegments(
+        const std::vector<cg3::Segment2d>& segments,
+        std::vector<cg3::Point2d>& intersectionPoints,
+        std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>>& intersectingSegments)
+{
+    COUNT_ALLOCATIONS(DATASET_ADD_NODED_SEGMENTS);
+
+    //Split the segments of the list: the pieces don't cross each other
+    std::vector<cg3::Segment2d> pieces;
+    std::vector<size_t> origins;
+    SegmentIntersections::nodeSegments(segments, pieces, origins, intersectionPoints);
+
+    std::vector<bool> piecesInserted;
+    return addSegments(pieces, piecesInserted, intersectingSegments);
 }
 
 size_t TrapezoidalMapDataset::addIndexedSegment(const IndexedSegment2d& indexedSegment, bool& segmentInserted)
@@ -132,6 +179,7 @@ size_t TrapezoidalMapDataset::addIndexedSegment(const IndexedSegment2d& indexedS
     bool degenerate = orderedIndexedSegment.first == orderedIndexedSegment.second;
 
     if (!degenerate && !found) {
+        updateIntersectionChecker();
         bool intersecting = intersectionChecker.checkIntersections(cg3::Segment2d(points[orderedIndexedSegment.first], points[orderedIndexedSegment.second]));
 
         if (!intersecting) {
@@ -143,13 +191,46 @@ size_t TrapezoidalMapDataset::addIndexedSegment(const IndexedSegment2d& indexedS
 
             segmentMap.insert(std::make_pair(orderedIndexedSegment, id));
 
-            intersectionChecker.insert(cg3::Segment2d(points[orderedIndexedSegment.first], points[orderedIndexedSegment.second]));
+            updateIntersectionChecker();
         }
     }
 
     return id;
 }
 
+size_t TrapezoidalMapDataset::insertValidSegment(const cg3::Segment2d& orderedSegment)
+{
+    size_t id = indexedSegments.size();
+
+    bool insertedPoint1;
+    size_t id1 = addPoint(orderedSegment.p1(), insertedPoint1);
+    bool insertedPoint2;
+    size_t id2 = addPoint(orderedSegment.p2(), insertedPoint2);
+    assert(id1 != id2 && id1 < points.size() && id2 < points.size());
+
+    IndexedSegment2d indexedSegment(id1, id2);
+    if (indexedSegment.second < indexedSegment.first) {
+        std::swap(indexedSegment.first, indexedSegment.second);
+    }
+
+    indexedSegments.push_back(indexedSegment);
+
+    segmentMap.insert(std::make_pair(indexedSegment, id));
+
+    return id;
+}
+
+void TrapezoidalMapDataset::updateIntersectionChecker()
+{
+    //Many new segments (e.g. a file loaded) are bulk-loaded in a single tree
+    std::vector<cg3::Segment2d> newSegments;
+    newSegments.reserve(indexedSegments.size() - checkedSegments);
+    for (; checkedSegments < indexedSegments.size(); checkedSegments++) {
+        newSegments.push_back(getSegment(checkedSegments));
+    }
+    intersectionChecker.insert(newSegments);
+}
+
 size_t TrapezoidalMapDataset::findPoint(const cg3::Point2d &point, bool &found)
 {
     std::unordered_map<cg3::Point2d, size_t>::iterator it = pointMap.find(point);
@@ -276,8 +357,8 @@ void TrapezoidalMapDataset::clear()
     indexedSegments.clear();
     pointMap.clear();
     segmentMap.clear();
-    xCoordSet.clear();
     boundingBox.setMin(cg3::Point2d(0,0));
     boundingBox.setMax(cg3::Point2d(0,0));
     intersectionChecker.clear();
+    checkedSegments = 0;
 }
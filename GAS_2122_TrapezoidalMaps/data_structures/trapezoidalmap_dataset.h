@@ -13,8 +13,9 @@
 
 /**
  * @brief This class allows to store segments, with indexed non-duplicates point.
- * Every segment is unique, non-degenerate, with points in general position, and
- * it does not have any intersections with the other segments.
+ * Every segment is unique, non-degenerate, and it does not have any intersections
+ * with the other segments. The points may share their x-coordinates (vertical
+ * segments included): the trapezoidal map handles them with a symbolic shear.
  */
 class TrapezoidalMapDataset {
 
@@ -28,6 +29,27 @@ public:
     size_t addSegment(const cg3::Segment2d& segment, bool& segmentInserted);
     size_t addIndexedSegment(const IndexedSegment2d& segment, bool& segmentInserted);
 
+    //Adds a list of segments: the degenerate ones, the duplicates and the ones intersecting the others are ignored.
+    //The intersections are found with a single sweep (see SegmentIntersections::discardIntersecting), so loading
+    //n segments takes O(n log n) time when few of them intersect. When many of them do (see MAX_SWEPT_DISCARDED_FRACTION)
+    //the sweep gives up and the segments are checked one at a time, as addSegment does: the loading then costs about as much as
+    //calling addSegment on each one, plus the sorting of the endpoints. The segments inserted are the same of calling addSegment
+    //on each one in order. Each pair of intersecting segments found is reported, the ignored one second.
+    //Returns the number of segments inserted.
+    size_t addSegments(
+            const std::vector<cg3::Segment2d>& segments,
+            std::vector<bool>& segmentsInserted,
+            std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>>& intersectingSegments);
+
+    //Adds a list of segments in noding mode: the segments intersecting each other are split at their intersection points
+    //(see SegmentIntersections::nodeSegments) instead of being ignored. The pieces are added with addSegments, so the ones
+    //intersecting the segments already in the dataset are still ignored, and reported. The intersection points of the list
+    //are reported too. Returns the number of pieces inserted.
+    size_t addNodedSegments(
+            const std::vector<cg3::Segment2d>& segments,
+            std::vector<cg3::Point2d>& intersectionPoints,
+            std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>>& intersectingSegments);
+
     size_t findPoint(const cg3::Point2d& point, bool& found);
     size_t findSegment(const cg3::Segment2d& segment, bool& found);
     size_t findIndexedSegment(const IndexedSegment2d& indexedSegment, bool& found);
@@ -52,16 +74,23 @@ public:
 
 private:
 
+    //Inserts a segment (with ordered endpoints) already validated, with its new points
+    size_t insertValidSegment(const cg3::Segment2d& orderedSegment);
+
+    //Inserts in the intersection checker the segments added after its last update
+    void updateIntersectionChecker();
+
     std::vector<cg3::Point2d> points;
     std::vector<IndexedSegment2d> indexedSegments;
 
     std::unordered_map<cg3::Point2d, size_t> pointMap;
     std::unordered_map<IndexedSegment2d, size_t> segmentMap;
-    std::unordered_set<double> xCoordSet;
 
     cg3::BoundingBox2 boundingBox;
 
     SegmentIntersectionChecker intersectionChecker;
+    //Number of segments (the first ones) already inserted in the intersection checker
+    size_t checkedSegments = 0;
 
 };
 
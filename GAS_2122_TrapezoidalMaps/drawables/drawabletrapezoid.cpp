@@ -1,11 +1,17 @@
 #include "drawabletrapezoid.h"
 #include <cg3/geometry/intersections2.h>
+#include <algorithm>
+#include <cassert>
 #include <random>
-#include <cg3/viewer/opengl_objects/opengl_objects2.h>
+
+// The opengl drawing code is in drawabletrapezoid_gl.cpp: this file only needs the core of cg3
 
 double DrawableTrapezoid::yMin = -1;
 double DrawableTrapezoid::yMax = -1;
 
+const double DrawableTrapezoid::MIN_RANDOM_VALUE = 0.0;
+const double DrawableTrapezoid::MAX_RANDOM_VALUE = 0.8;
+
 DrawableTrapezoid::DrawableTrapezoid(const OrderedSegment& t, const OrderedSegment& b, const cg3::Point2d& lp, const cg3::Point2d& rp, bool doCalculateGraphics) : Trapezoid(t,b, lp, rp), hasGraphics(doCalculateGraphics)
 {
     if (!doCalculateGraphics) return;
@@ -27,52 +33,28 @@ bool DrawableTrapezoid::isGraphicsCalculated() const {
     return hasGraphics;
 }
 
-void DrawableTrapezoid::drawPolygon() const {
-    assert(this->isGraphicsCalculated());
-
-    /*source: https://www3.ntu.edu.sg/home/ehchua/programming/opengl/cg_introduction.html*/
-    glBegin(GL_POLYGON);            // These vertices form a closed polygon
-        if(this->isHighlighted) {
-            glColor3f(POLYGON_COLOR_WHEN_HIGHLIGHTED.redF(), POLYGON_COLOR_WHEN_HIGHLIGHTED.greenF(), POLYGON_COLOR_WHEN_HIGHLIGHTED.blueF());
-        } else {
-            glColor3f(this->polygonColor.redF(), this->polygonColor.greenF(), this->polygonColor.blueF());
-        }
-        glVertex2f(this->topLeftVertex.x(),     this->topLeftVertex.y());
-        glVertex2f(this->topRightVertex.x(),    this->topRightVertex.y());
-        glVertex2f(this->bottomRightVertex.x(), this->bottomRightVertex.y());
-        glVertex2f(this->bottomLeftVertex.x(),  this->bottomLeftVertex.y());
-     glEnd();
-}
-
-void DrawableTrapezoid::drawVerticalLines() const {
-    assert(this->isGraphicsCalculated() == true);
-    cg3::opengl::drawLine2(this->topLeftVertex,  this->bottomLeftVertex, this->segmentColor, this->segmentSize);
-    cg3::opengl::drawLine2(this->topRightVertex, this->bottomRightVertex, this->segmentColor, this->segmentSize);
-}
-
-
 void DrawableTrapezoid::setRandomColor() {
-    assert(this->polygonColor!=nullptr);
-
     /* COMMENT THE BELOW CODE AND USE THE OTHER FOR MORE PERFORMANCE */
     // source: https: https://en.cppreference.com/w/cpp/numeric/random/uniform_real_distribution
     std::random_device rd;  // Will be used to obtain a seed for the random number engine
     std::mt19937 gen(rd()); // Standard mersenne_twister_engine seeded with rd()
-    std::uniform_real_distribution<double> dis(min_random_value, max_random_value);
-    this->polygonColor.setRedF(dis(gen));
-    this->polygonColor.setBlueF(dis(gen));
-    this->polygonColor.setGreenF(dis(gen));
+    std::uniform_real_distribution<double> dis(MIN_RANDOM_VALUE, MAX_RANDOM_VALUE);
+    this->polygonRed = static_cast<float>(dis(gen));
+    this->polygonBlue = static_cast<float>(dis(gen));
+    this->polygonGreen = static_cast<float>(dis(gen));
 
 
     /* QUICKER VERSION */
-//    this->polygonColor.setRed(0);
-//    this->polygonColor.setBlue(0);
-//    this->polygonColor.setGreen(0);
+//    this->polygonRed = 0;
+//    this->polygonBlue = 0;
+//    this->polygonGreen = 0;
 }
 
 void DrawableTrapezoid::setVerteces() {
     char code;
     const double thres = cg3::CG3_EPSILON;
+    // The 4 verteces of the trapezoid: only their y-coordinate will be saved
+    cg3::Point2d topLeftVertex, topRightVertex, bottomLeftVertex, bottomRightVertex;
 
     /* Create two vertical line as height as the bounding box
      * The first  has the x of the leftpoint of the trapezoid
@@ -94,26 +76,42 @@ void DrawableTrapezoid::setVerteces() {
     // flag: is the right point on the top segment?
     bool leftpOnBottom= getLeftp() == getBottom().getLeftmost();
 
+    /* The vertex on a top/bottom segment: the intersection with the vertical line. A vertical segment (symbolic shear)
+     * is crossed by the wall at the height of the point defining it, clamped to the segment. A wall through an endpoint
+     * (other endpoints with the same x-coordinate) meets the segment there: the intersection test may miss it */
+    auto intersectWall = [&code, thres](const cg3::Point2d& wallPoint, const cg3::Segment2d& wallLine, const OrderedSegment& s, cg3::Point2d& vertex) {
+        if(s.getLeftmost().x() == s.getRightmost().x()) {
+            vertex = cg3::Point2d(s.getLeftmost().x(), std::min(std::max(wallPoint.y(), s.getLeftmost().y()), s.getRightmost().y()));
+            code = 'v';
+        }
+        else if(wallPoint.x() == s.getLeftmost().x() || wallPoint.x() == s.getRightmost().x()) {
+            vertex = wallPoint.x() == s.getLeftmost().x() ? s.getLeftmost() : s.getRightmost();
+            code = 'v';
+        }
+        else
+            cg3::checkSegmentIntersection2(wallLine, s, code, thres, vertex);
+    };
+
     /// LEFT VERTECES
     /* DEGENERATIVE CASE */
     if(leftpOnBottom && leftpOnTop) {
-        this->topLeftVertex = getLeftp();
-        this->bottomLeftVertex = getLeftp();
+        topLeftVertex = getLeftp();
+        bottomLeftVertex = getLeftp();
     }
     /* NORMAL CASE */
     else if(leftpOnBottom) {
-        this->bottomLeftVertex = getLeftp();
-        cg3::checkSegmentIntersection2(leftVerticalLine,  getTop(), code, thres, topLeftVertex);
+        bottomLeftVertex = getLeftp();
+        intersectWall(getLeftp(), leftVerticalLine, getTop(), topLeftVertex);
         assert(code == 'v' || code == '1'); // assert an intersection has been found
     }
     else if (leftpOnTop) {
-        this->topLeftVertex = getLeftp();
-        cg3::checkSegmentIntersection2(leftVerticalLine,  getBottom(), code, thres, bottomLeftVertex);
+        topLeftVertex = getLeftp();
+        intersectWall(getLeftp(), leftVerticalLine, getBottom(), bottomLeftVertex);
         assert(code == 'v' || code == '1');
     } else {
-        cg3::checkSegmentIntersection2(leftVerticalLine,  getTop(), code, thres, topLeftVertex);
+        intersectWall(getLeftp(), leftVerticalLine, getTop(), topLeftVertex);
         assert(code == 'v' || code == '1');
-        cg3::checkSegmentIntersection2(leftVerticalLine,  getBottom(), code, thres, bottomLeftVertex);
+        intersectWall(getLeftp(), leftVerticalLine, getBottom(), bottomLeftVertex);
         assert(code == 'v' || code == '1');
     }
 
@@ -125,26 +123,31 @@ void DrawableTrapezoid::setVerteces() {
 
     /* DEGENERATIVE CASE */
     if(rightpOnBottom && rightpOnTop) {
-        this->bottomRightVertex = getRightp();
-        this->topRightVertex = getRightp();
+        bottomRightVertex = getRightp();
+        topRightVertex = getRightp();
     }
     /* NORMAL CASE */
     else if(rightpOnBottom) {
-        this->bottomRightVertex = getRightp();
-        cg3::checkSegmentIntersection2(rightVerticalLine,  getTop(), code, thres, topRightVertex);
+        bottomRightVertex = getRightp();
+        intersectWall(getRightp(), rightVerticalLine, getTop(), topRightVertex);
     }
     else if (rightpOnTop) {
-        this->topRightVertex = getRightp();
-        cg3::checkSegmentIntersection2(rightVerticalLine,  getBottom(), code, thres, bottomRightVertex);
+        topRightVertex = getRightp();
+        intersectWall(getRightp(), rightVerticalLine, getBottom(), bottomRightVertex);
         assert(code == 'v' || code == '1');
 
     } else {
-        cg3::checkSegmentIntersection2(rightVerticalLine, getTop(), code, thres, topRightVertex);
+        intersectWall(getRightp(), rightVerticalLine, getTop(), topRightVertex);
         assert(code == 'v' || code == '1');
 
-        cg3::checkSegmentIntersection2(rightVerticalLine, getBottom(), code, thres, bottomRightVertex);
+        intersectWall(getRightp(), rightVerticalLine, getBottom(), bottomRightVertex);
         assert(code == 'v' || code== '1');
     }
+
+    this->topLeftY     = topLeftVertex.y();
+    this->topRightY    = topRightVertex.y();
+    this->bottomLeftY  = bottomLeftVertex.y();
+    this->bottomRightY = bottomRightVertex.y();
 }
 
 bool DrawableTrapezoid::getIsHighlighted() const
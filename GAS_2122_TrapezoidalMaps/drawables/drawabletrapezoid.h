@@ -17,6 +17,7 @@ public:
 
 
     ////////////////// DRAW METHODS //////////////////
+    // (defined in drawabletrapezoid_gl.cpp, which is compiled only in the application)
     // draw the trapezoid through opengl calls
     void drawPolygon() const;
     // draw the vertical lines of the trapezoid through cg3 calls (which use opengl methods)
@@ -60,23 +61,17 @@ private:
     bool hasGraphics = false;   // if the graphics stuff has already been calculated or not
     bool isHighlighted = false; // if the face is highlighted or not (it will change the color)
 
-    // The 4 verteces of the trapezoid
-    cg3::Point2d topLeftVertex, topRightVertex, bottomLeftVertex, bottomRightVertex;
+    // The y-coordinates of the 4 verteces of the trapezoid (the x-coordinates are the ones of the left point and of the right point)
+    double topLeftY = 0, topRightY = 0, bottomLeftY = 0, bottomRightY = 0;
 
     /// COLORS & WIDTH
     // min and max value for the uniform distribution used to choose a random color
-    const double min_random_value = 0.0;
-    const double max_random_value = 0.8;
-
-    // polygon highlighted color (equal for all trapezoids)
-    const cg3::Color POLYGON_COLOR_WHEN_HIGHLIGHTED = cg3::Color(255,255,255);
-    // polygon default color
-    cg3::Color polygonColor = cg3::Color(0, 0, 0);
-
-    // vertical lines colors
-    cg3::Color segmentColor = cg3::Color(80, 80, 180); // value seen in drawableboundingbox, but it has not getter, so I set this field "manually"
-    // size of the lines
-    int segmentSize = 3; // value seen in drawableboundingbox, but it has not getter, so I set this field "manually"
+    static const double MIN_RANDOM_VALUE;
+    static const double MAX_RANDOM_VALUE;
+
+    // polygon default color (red, green and blue from 0 to 1). They're not a cg3::Color, which is a QColor when Qt is
+    // available: the class must have the same layout in the application and in the core library, built without Qt
+    float polygonRed = 0, polygonGreen = 0, polygonBlue = 0;
 };
 
 #endif // DRAWABLETRAPEZOID_H
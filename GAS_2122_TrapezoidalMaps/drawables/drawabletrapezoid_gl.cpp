@@ -0,0 +1,40 @@
+#include "drawabletrapezoid.h"
+#include <cassert>
+#include <cg3/viewer/opengl_objects/opengl_objects2.h>
+
+// The drawing code of the trapezoids: it's compiled only in the application, the rest of the class is in the core (see trapezoidalmap_core.pri)
+
+namespace {
+
+// polygon highlighted color (equal for all trapezoids)
+const cg3::Color POLYGON_COLOR_WHEN_HIGHLIGHTED = cg3::Color(255,255,255);
+
+// vertical lines colors (equal for all trapezoids)
+const cg3::Color SEGMENT_COLOR = cg3::Color(80, 80, 180); // value seen in drawableboundingbox, but it has not getter, so I set this field "manually"
+// size of the lines (equal for all trapezoids)
+const int SEGMENT_SIZE = 3; // value seen in drawableboundingbox, but it has not getter, so I set this field "manually"
+
+}
+
+void DrawableTrapezoid::drawPolygon() const {
+    assert(this->isGraphicsCalculated());
+
+    /*source: https://www3.ntu.edu.sg/home/ehchua/programming/opengl/cg_introduction.html*/
+    glBegin(GL_POLYGON);            // These vertices form a closed polygon
+        if(this->isHighlighted) {
+            glColor3f(POLYGON_COLOR_WHEN_HIGHLIGHTED.redF(), POLYGON_COLOR_WHEN_HIGHLIGHTED.greenF(), POLYGON_COLOR_WHEN_HIGHLIGHTED.blueF());
+        } else {
+            glColor3f(this->polygonRed, this->polygonGreen, this->polygonBlue);
+        }
+        glVertex2f(getLeftp().x(),  this->topLeftY);
+        glVertex2f(getRightp().x(), this->topRightY);
+        glVertex2f(getRightp().x(), this->bottomRightY);
+        glVertex2f(getLeftp().x(),  this->bottomLeftY);
+     glEnd();
+}
+
+void DrawableTrapezoid::drawVerticalLines() const {
+    assert(this->isGraphicsCalculated() == true);
+    cg3::opengl::drawLine2(cg3::Point2d(getLeftp().x(), this->topLeftY),   cg3::Point2d(getLeftp().x(), this->bottomLeftY),   SEGMENT_COLOR, SEGMENT_SIZE);
+    cg3::opengl::drawLine2(cg3::Point2d(getRightp().x(), this->topRightY), cg3::Point2d(getRightp().x(), this->bottomRightY), SEGMENT_COLOR, SEGMENT_SIZE);
+}
@@ -1,5 +1,6 @@
 #include "drawabletrapezoidalmap.h"
 #include <cg3/viewer/opengl_objects/opengl_objects2.h>
+#include "utils/allocationcounter.h"
 
 DrawableTrapezoidalMap::DrawableTrapezoidalMap() {}
 
@@ -7,11 +8,17 @@ DrawableTrapezoidalMap::DrawableTrapezoidalMap() {}
 // Draw the objects through opengl calls
 void DrawableTrapezoidalMap::draw() const
 {
+    COUNT_ALLOCATIONS(DRAW);
+
     // For each trapezoid in the map
     for(auto t : T) {
         // If the trapezoid has been split, skip it
         if(t->getIsBeingSplitted()) continue;
 
+        // The map doesn't compute the graphics of its trapezoids: it's done once, the first time they're drawn
+        if(!t->isGraphicsCalculated())
+            t->calculateGraphics();
+
         /* DRAW ITS VERTICAL LINES*/
         t->drawVerticalLines();
 
@@ -42,6 +49,9 @@ void DrawableTrapezoidalMap::initialize(const cg3::BoundingBox2 &B) {
     DrawableTrapezoid::setYMax(yMax);
     DrawableTrapezoid::setYMin(yMin);
 
+    // the trapezoids of the previous map (if any) have been deleted
+    lastTrapezoidHighlighted = nullptr;
+
     // parent call
     TrapezoidalMap::initialize(B);
 }
@@ -60,3 +70,7 @@ void DrawableTrapezoidalMap::resetLastTrapezoidHighlighted() {
 
     lastTrapezoidHighlighted->setIsHighlighted(false);
 }
+
+DrawableTrapezoid* DrawableTrapezoidalMap::getLastTrapezoidHighlighted() const {
+    return lastTrapezoidHighlighted;
+}
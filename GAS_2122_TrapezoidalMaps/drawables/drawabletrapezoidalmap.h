@@ -24,6 +24,8 @@ public:
     void highlightTrapezoid(DrawableTrapezoid* newLastTrapezoidHighlighted);
     // set the last trapezoid as "not highlighted"
     void resetLastTrapezoidHighlighted();
+    // returns the last trapezoid highlighted (nullptr if there's none), it can be used as hint for the next query
+    DrawableTrapezoid* getLastTrapezoidHighlighted() const;
 
 private:
     // the pointer to the last trapezoid highlighted
@@ -10,6 +10,7 @@
 #include <cg3/utilities/timer.h>
 
 #include "utils/fileutils.h"
+#include "utils/segmentgenerator.h"
 
 //Limits for the bounding box
 //It defines where points can be added
@@ -230,7 +231,8 @@ void TrapezoidalMapManager::queryTrapezoidalMap(const cg3::Point2d& queryPoint)
     //in the structure). This is a bit more complicated, but a better structure, because, in this case
     //TrapezoidalMap and DAG are two separate general purpose data structures that an algorithm uses.
     //THINK ABOUT YOUR STRUCTURE BEFORE WRITING CODE!
-    auto faceToHighlight = drawableTrapezoidalMap.pointLocation(queryPoint);
+    // the last trapezoid highlighted is used as starting point: consecutive clicks are usually close to each other
+    auto faceToHighlight = drawableTrapezoidalMap.pointLocation(queryPoint, drawableTrapezoidalMap.getLastTrapezoidHighlighted());
     //#####################################################################
 
 
@@ -367,35 +369,10 @@ void TrapezoidalMapManager::queryTrapezoidalMapAndMeasureTime(const cg3::Point2d
  */
 std::vector<cg3::Segment2d> TrapezoidalMapManager::generateRandomNonIntersectingSegments(size_t n, double radius) //Do not write code here
 {
-    double lower_bound = -radius + 1;
-    double upper_bound = radius - 1;
+    //Each segment is drawn inside its own cell of a grid, so none of them is rejected
+    cg3::BoundingBox2 box(cg3::Point2d(-radius + 1, -radius + 1), cg3::Point2d(radius - 1, radius - 1));
 
-    std::mt19937 rng;
-    rng.seed(std::random_device()());
-
-    std::vector<cg3::Point2d> randomPoints;
-    for (size_t i = 0; i < n * 10; i++) {
-        cg3::Point2d p;
-
-        std::uniform_real_distribution<double> dist(lower_bound,upper_bound);
-        p.setXCoord(dist(rng));
-        p.setYCoord(dist(rng));
-
-        randomPoints.push_back(p);
-    }
-
-    TrapezoidalMapDataset dataset;
-    while (dataset.segmentNumber() < n) {
-        std::uniform_int_distribution<int> dist(0, randomPoints.size() - 1);
-
-        cg3::Point2d p1 = randomPoints[static_cast<size_t>(dist(rng))];
-        cg3::Point2d p2 = randomPoints[static_cast<size_t>(dist(rng))];
-
-        bool insertedSegment;
-        dataset.addSegment(cg3::Segment2d(p1, p2), insertedSegment);
-    }
-
-    return dataset.getSegments();
+    return SegmentGenerator::randomNonIntersectingSegments(n, box, std::random_device()());
 }
 
 /**
@@ -465,7 +442,7 @@ void TrapezoidalMapManager::point2DClicked(cg3::Point2d point) //Do not write co
                     //Error message cannot add an intersecting segment
                     QMessageBox::warning(this, "Cannot insert segment",
                         "The segment will be ignored because it has intersections with other segments, "
-                        "it is degenerate, or a point has the same x-coordinate of another point.");
+                        "or it is degenerate.");
                 }
 
                 isFirstPointSelected = false;
@@ -495,7 +472,7 @@ void TrapezoidalMapManager::on_loadSegmentsButton_clicked() //Do not write code
     QString filename = QFileDialog::getOpenFileName(nullptr,
                        "Open segment file",
                        ".",
-                       "*.txt");
+                       "*.txt *.bin");
 
     if (!filename.isEmpty()) {
         //Cancel first point selected
@@ -511,29 +488,49 @@ void TrapezoidalMapManager::on_loadSegmentsButton_clicked() //Do not write code
         //Load input segments in the vector (deleting the previous ones)
         std::vector<cg3::Segment2d> segments = FileUtils::getSegmentsFromFile(filename.toStdString());
 
-        //Add to the dataset
-        bool allSegmentInserted = true;
-        for (const cg3::Segment2d& segment : segments) {
-            bool insertedSegment;
-            drawableTrapezoidalMapDataset.addSegment(segment, insertedSegment);
-
-            allSegmentInserted &= insertedSegment;
-            if (!insertedSegment) {
-                std::cout << "The segment " << segment <<
-                    " will be ignored because it has intersections with other segments, "
-                    "it is degenerate, or a point has the same x-coordinate of another point." << std::endl;
-            }
+        //Add to the dataset, validating all the segments with a single sweep. In noding mode the
+        //intersecting segments are split at their intersection points instead of being ignored
+        std::vector<cg3::Segment2d> insertedSegments;
+        if (ui->splitIntersectingCheckBox->isChecked()) {
+            std::vector<cg3::Point2d> intersectionPoints;
+            std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>> intersectingSegments;
+            drawableTrapezoidalMapDataset.addNodedSegments(segments, intersectionPoints, intersectingSegments);
+
+            //The dataset was empty: it holds just the pieces
+            insertedSegments = drawableTrapezoidalMapDataset.getSegments();
+            std::cout << segments.size() << " segments have been split at " << intersectionPoints.size() <<
+                " intersection points into " << insertedSegments.size() << " segments." << std::endl;
         }
-        if (!allSegmentInserted) {
-            //Error message cannot add an intersecting segment
-            QMessageBox::warning(this, "Cannot insert all segments",
-                "Some segment have be ignored because they have intersections with other segments, "
-                "they are degenerate, or a point has the same x-coordinate of another point.");
+        else {
+            std::vector<bool> segmentsInserted;
+            std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>> intersectingSegments;
+            const size_t nInserted = drawableTrapezoidalMapDataset.addSegments(segments, segmentsInserted, intersectingSegments);
+
+            for (const std::pair<cg3::Segment2d, cg3::Segment2d>& pair : intersectingSegments) {
+                std::cout << "The segment " << pair.second <<
+                    " will be ignored because it intersects the segment " << pair.first << "." << std::endl;
+            }
+            insertedSegments.reserve(nInserted);
+            for (size_t i = 0; i < segments.size(); i++) {
+                if (segmentsInserted[i]) {
+                    insertedSegments.push_back(segments[i]);
+                }
+            }
+            if (nInserted < segments.size()) {
+                std::cout << segments.size() - nInserted << " segments have been ignored (" <<
+                    intersectingSegments.size() << " of them because of an intersection, " <<
+                    "the others are degenerate or duplicates)." << std::endl;
+
+                //Error message cannot add an intersecting segment
+                QMessageBox::warning(this, "Cannot insert all segments",
+                    "Some segment have be ignored because they have intersections with other segments, "
+                    "or they are degenerate.");
+            }
         }
 
-        //Launch the algorithm on the current vector of segments and measure
+        //Launch the algorithm on the segments inserted in the dataset and measure
         //its efficiency with a timer
-        loadSegmentsTrapezoidalMapAndMeasureTime(segments);
+        loadSegmentsTrapezoidalMapAndMeasureTime(insertedSegments);
 
         //The trapezoidal map has been changed, so we update the canvas for drawing.
         updateCanvas();
@@ -562,11 +559,12 @@ void TrapezoidalMapManager::on_randomSegmentsButton_clicked() //Do not write cod
     clearTrapezoidalMap();
     drawableTrapezoidalMapDataset.clear();
 
-    for (const cg3::Segment2d& segment : segments) {
-        bool insertedSegment;
-        drawableTrapezoidalMapDataset.addSegment(segment, insertedSegment);
-        assert(insertedSegment);
-    }
+    //The segments don't intersect each other: they're validated with a single sweep
+    std::vector<bool> segmentsInserted;
+    std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>> intersectingSegments;
+    const size_t nInserted = drawableTrapezoidalMapDataset.addSegments(segments, segmentsInserted, intersectingSegments);
+    assert(nInserted == segments.size());
+    CG3_SUPPRESS_WARNING(nInserted);
 
     //Launch the algorithm on the current vector of segments and measure
     //its efficiency with a timer
@@ -47,7 +47,7 @@ private:
     const cg3::DrawableBoundingBox2 drawableBoundingBox;
 
     //Drawable dataset for the trapezoidal map. Each segment is consistent:
-    //points in general position, no segment duplicates, non-intersecting segments
+    //no segment duplicates, non-intersecting segments
     DrawableTrapezoidalMapDataset drawableTrapezoidalMapDataset;
 
     //Variables to allow to select a segment clicking on the canvas
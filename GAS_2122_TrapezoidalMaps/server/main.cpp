@@ -0,0 +1,129 @@
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "data_structures/trapezoidalmap.h"
+#include "data_structures/trapezoidalmap_dataset.h"
+#include "utils/fileutils.h"
+#include "utils/workloadgenerator.h"
+
+#include "queryserver.h"
+
+// Same bounding box used by the manager of the application
+#define BOUNDINGBOX 1e+6
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// returns the milliseconds elapsed since the given instant
+double elapsedMilliseconds(const Clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " (<segment file> | -g <shape> <number of segments>) [-u <socket path>] [-t <threads>] [-S <seed>]" << std::endl
+              << "    -g    serve a generated workload (see WorkloadGenerator): uniform, clustered, thin, vertical, grid or roads" << std::endl
+              << "    -u    listen on a unix domain socket instead of reading the requests from stdin (the responses go to stdout)" << std::endl
+              << "    -t    number of threads building the map and answering the requests (default one for each core)" << std::endl
+              << "    -S    seed of the generated workload (default 1, the same files of the workload tool)" << std::endl
+              << "The protocol is described in server/queryserver.h. The messages of the server go to stderr." << std::endl;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 2) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parsing the arguments
+    std::string filename;
+    bool generate = false;
+    WorkloadGenerator::SegmentShape shape = WorkloadGenerator::UNIFORM;
+    size_t nSegments = 0;
+    std::string socketPath;
+    size_t nThreads = 0;
+    unsigned long long seed = 1;
+    for(int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        if(argument == "-g" && i + 2 < argc) {
+            if(!WorkloadGenerator::parseShape(argv[++i], shape)) {
+                std::cerr << "Unknown shape: " << argv[i] << std::endl;
+                return EXIT_FAILURE;
+            }
+            nSegments = std::strtoul(argv[++i], nullptr, 10);
+            generate = true;
+        }
+        else if(argument == "-u" && i + 1 < argc)
+            socketPath = argv[++i];
+        else if(argument == "-t" && i + 1 < argc)
+            nThreads = std::strtoul(argv[++i], nullptr, 10);
+        else if(argument == "-S" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if(filename.empty() && argument[0] != '-')
+            filename = argument;
+        else {
+            std::cerr << "Unknown argument: " << argument << std::endl;
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if(filename.empty() == !generate) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The segments
+    Clock::time_point start = Clock::now();
+    const cg3::BoundingBox2 box(cg3::Point2d(-BOUNDINGBOX + 1, -BOUNDINGBOX + 1), cg3::Point2d(BOUNDINGBOX - 1, BOUNDINGBOX - 1));
+    bool isComplete = true;
+    const std::vector<cg3::Segment2d> segments = generate ?
+                WorkloadGenerator::generateSegments(shape, nSegments, box, seed) : FileUtils::getSegmentsFromFile(filename, isComplete);
+    if(!isComplete) {
+        std::cerr << "Can't read the segments of " << filename << ": the file is missing, unreadable or truncated" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Validation, as the application does when loading a file: the ids of the responses are the positions of the segments
+    // in the file (or in the generated workload), the ignored ones are never returned
+    TrapezoidalMapDataset dataset;
+    std::vector<bool> inserted;
+    std::vector<std::pair<cg3::Segment2d, cg3::Segment2d>> intersectingSegments;
+    dataset.addSegments(segments, inserted, intersectingSegments);
+    std::vector<cg3::Segment2d> validSegments;
+    std::vector<uint32_t> segmentIds;
+    for(size_t i = 0; i < segments.size(); i++) {
+        if(inserted[i]) {
+            validSegments.push_back(segments[i]);
+            segmentIds.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    std::cerr << segments.size() << " segments loaded, " << segments.size() - validSegments.size() << " ignored (" << elapsedMilliseconds(start) << " ms)" << std::endl;
+
+    // The map: the segments get the ids of their position in validSegments
+    start = Clock::now();
+    TrapezoidalMap map;
+    map.initialize(cg3::BoundingBox2(cg3::Point2d(-BOUNDINGBOX, -BOUNDINGBOX), cg3::Point2d(BOUNDINGBOX, BOUNDINGBOX)));
+    map.addSegments(validSegments, nThreads);
+    std::cerr << "Map built in " << elapsedMilliseconds(start) << " ms" << std::endl;
+
+    // A client going away must not kill the server: the failed writes are handled by the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    QueryServer server(map, segmentIds, nThreads);
+    std::cerr << server.trapezoidNumber() << " trapezoids" << std::endl;
+    if(socketPath.empty()) {
+        server.serve(0, 1);
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << "Listening on " << socketPath << std::endl;
+    server.listen(socketPath);
+    return EXIT_FAILURE;
+}
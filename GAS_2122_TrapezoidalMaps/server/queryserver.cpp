@@ -0,0 +1,295 @@
+#include "queryserver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Reads exactly n bytes (false at the end of the stream or after an error)
+bool readFully(int fd, void* buffer, size_t n) {
+    unsigned char* bytes = static_cast<unsigned char*>(buffer);
+    while(n > 0) {
+        const ssize_t r = ::read(fd, bytes, n);
+        if(r < 0 && errno == EINTR)
+            continue;
+        if(r <= 0)
+            return false;
+        bytes += r;
+        n -= static_cast<size_t>(r);
+    }
+    return true;
+}
+
+// Writes exactly n bytes (false after an error, e.g. the client closed the connection)
+bool writeFully(int fd, const void* buffer, size_t n) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(buffer);
+    while(n > 0) {
+        const ssize_t w = ::write(fd, bytes, n);
+        if(w < 0 && errno == EINTR)
+            continue;
+        if(w <= 0)
+            return false;
+        bytes += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+// Little-endian encoding of the numbers of the protocol (the same byte order of the binary files, see FileUtils)
+uint64_t getUnsigned(const unsigned char* bytes, int size) {
+    uint64_t value = 0;
+    for(int i = 0; i < size; i++)
+        value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    return value;
+}
+
+void putUnsigned(unsigned char* bytes, uint64_t value, int size) {
+    for(int i = 0; i < size; i++)
+        bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+}
+
+double getDouble(const unsigned char* bytes) {
+    const uint64_t bits = getUnsigned(bytes, 8);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}
+
+QueryServer::Connection::Connection(int inputFd, int outputFd, bool ownsFd) : inputFd(inputFd), outputFd(outputFd), ownsFd(ownsFd)
+{
+}
+
+QueryServer::Connection::~Connection()
+{
+    if(!ownsFd)
+        return;
+    ::close(inputFd);
+    if(outputFd != inputFd)
+        ::close(outputFd);
+}
+
+QueryServer::QueryServer(const TrapezoidalMap& map, const std::vector<uint32_t>& segmentIds, size_t nThreads) : map(map), segmentIds(segmentIds)
+{
+    // The faces split by an insertion are kept in the list of the map, but they are never found by a query
+    for(const DrawableTrapezoid* trapezoid : map.getTrapezoids()) {
+        if(!trapezoid->getIsBeingSplitted())
+            trapezoidIds.emplace(trapezoid, static_cast<uint32_t>(trapezoidIds.size()));
+    }
+
+    if(nThreads == 0)
+        nThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for(size_t i = 0; i < nThreads; i++)
+        workers.push_back(std::thread(&QueryServer::work, this));
+}
+
+QueryServer::~QueryServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        stopping = true;
+    }
+    jobsChanged.notify_all();
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+void QueryServer::serve(int inputFd, int outputFd)
+{
+    readRequests(std::make_shared<Connection>(inputFd, outputFd, false));
+}
+
+bool QueryServer::listen(const std::string& socketPath)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    const int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listenFd < 0) {
+        std::cerr << "Can't create the socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    ::unlink(socketPath.c_str());
+    if(::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(listenFd, SOMAXCONN) < 0) {
+        std::cerr << "Can't listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd);
+        return false;
+    }
+
+    while(true) {
+        const int fd = ::accept(listenFd, nullptr, nullptr);
+        if(fd < 0) {
+            if(errno != EINTR && errno != ECONNABORTED)
+                std::cerr << "Can't accept a connection: " << std::strerror(errno) << std::endl;
+            continue;
+        }
+        // The connection is closed when its thread and the requests queued by it are done
+        const std::shared_ptr<Connection> connection = std::make_shared<Connection>(fd, fd, true);
+        std::thread([this, connection]() {
+            readRequests(connection);
+        }).detach();
+    }
+}
+
+size_t QueryServer::trapezoidNumber() const
+{
+    return trapezoidIds.size();
+}
+
+void QueryServer::work()
+{
+    while(true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsChanged.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if(jobs.empty())
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void QueryServer::readRequests(const std::shared_ptr<Connection>& connection)
+{
+    unsigned char header[HEADER_SIZE];
+    std::vector<unsigned char> payload;
+    while(readFully(connection->inputFd, header, HEADER_SIZE)) {
+        const uint32_t requestId = static_cast<uint32_t>(getUnsigned(header, 4));
+        const uint16_t type = static_cast<uint16_t>(getUnsigned(header + 4, 2));
+        const uint32_t n = static_cast<uint32_t>(getUnsigned(header + 8, 4));
+
+        // A malformed request: the stream can't be trusted anymore
+        if(type != POINT_LOCATION && type != RAY_SHOOT_UP && type != RAY_SHOOT_DOWN) {
+            std::vector<unsigned char> buffer;
+            writeResponse(*connection, requestId, type, UNKNOWN_QUERY_TYPE, 0, buffer);
+            break;
+        }
+        if(n > MAX_BATCH_SIZE) {
+            std::vector<unsigned char> buffer;
+            writeResponse(*connection, requestId, type, BATCH_TOO_LARGE, 0, buffer);
+            break;
+        }
+
+        payload.resize(static_cast<size_t>(n) * 16);
+        if(!readFully(connection->inputFd, payload.data(), payload.size()))
+            break;
+        // The points are shared with the job, not copied
+        const std::shared_ptr<std::vector<cg3::Point2d>> points = std::make_shared<std::vector<cg3::Point2d>>(n);
+        for(size_t i = 0; i < n; i++)
+            (*points)[i] = cg3::Point2d(getDouble(&payload[16 * i]), getDouble(&payload[16 * i + 8]));
+
+        // Wait for a free slot of the connection, then queue the request
+        {
+            std::unique_lock<std::mutex> lock(connection->inFlightMutex);
+            connection->inFlightChanged.wait(lock, [&connection, n]() {
+                return connection->inFlight < MAX_IN_FLIGHT && connection->inFlightPoints + n <= MAX_IN_FLIGHT_POINTS;
+            });
+            connection->inFlight++;
+            connection->inFlightPoints += n;
+        }
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            const QueryType queryType = static_cast<QueryType>(type);
+            jobs.push_back([this, connection, requestId, queryType, points]() {
+                answer(connection, requestId, queryType, *points);
+
+                std::lock_guard<std::mutex> lock(connection->inFlightMutex);
+                connection->inFlight--;
+                connection->inFlightPoints -= points->size();
+                connection->inFlightChanged.notify_all();
+            });
+        }
+        jobsChanged.notify_one();
+    }
+
+    // All the responses have to be written before returning (the caller may close the streams)
+    std::unique_lock<std::mutex> lock(connection->inFlightMutex);
+    connection->inFlightChanged.wait(lock, [&connection]() { return connection->inFlight == 0; });
+}
+
+void QueryServer::answer(const std::shared_ptr<Connection>& connection, uint32_t requestId, QueryType type, const std::vector<cg3::Point2d>& points)
+{
+    // The points outside the map are not located: the others are copied only if there are some of them
+    std::vector<cg3::Point2d> insidePoints;
+    std::vector<bool> inside(points.size());
+    for(size_t i = 0; i < points.size(); i++)
+        inside[i] = isInside(points[i]);
+    const bool allInside = std::find(inside.begin(), inside.end(), false) == inside.end();
+    if(!allInside) {
+        for(size_t i = 0; i < points.size(); i++) {
+            if(inside[i])
+                insidePoints.push_back(points[i]);
+        }
+    }
+
+    // The batch query locates the points along the Morton curve, each one starting from the previous face
+    std::vector<DrawableTrapezoid*> faces;
+    map.pointLocation(allInside ? points : insidePoints, faces);
+
+    const size_t resultSize = type == POINT_LOCATION ? 12 : 4;
+    std::vector<unsigned char> buffer(HEADER_SIZE + resultSize * points.size());
+    unsigned char* result = buffer.data() + HEADER_SIZE;
+    std::vector<DrawableTrapezoid*>::const_iterator nextFace = faces.begin();
+    for(size_t i = 0; i < points.size(); i++, result += resultSize) {
+        if(!inside[i]) {
+            for(size_t j = 0; j < resultSize; j += 4)
+                putUnsigned(result + j, OUTSIDE, 4);
+            continue;
+        }
+
+        const DrawableTrapezoid* face = *nextFace++;
+        if(type == POINT_LOCATION) {
+            const std::unordered_map<const DrawableTrapezoid*, uint32_t>::const_iterator it = trapezoidIds.find(face);
+            putUnsigned(result, it == trapezoidIds.end() ? NO_ID : it->second, 4);
+            putUnsigned(result + 4, translateSegmentId(face->getTop().getId()), 4);
+            putUnsigned(result + 8, translateSegmentId(face->getBottom().getId()), 4);
+        }
+        else
+            putUnsigned(result, translateSegmentId(type == RAY_SHOOT_UP ? face->getTop().getId() : face->getBottom().getId()), 4);
+    }
+
+    writeResponse(*connection, requestId, type, OK, static_cast<uint32_t>(points.size()), buffer);
+}
+
+bool QueryServer::isInside(const cg3::Point2d& point) const
+{
+    // The comparisons with a NaN are false
+    const cg3::BoundingBox2& box = map.getBoundingBox();
+    return point.x() >= box.min().x() && point.x() <= box.max().x() && point.y() >= box.min().y() && point.y() <= box.max().y();
+}
+
+void QueryServer::writeResponse(Connection& connection, uint32_t requestId, uint16_t type, Status status, uint32_t n, std::vector<unsigned char>& buffer)
+{
+    if(buffer.size() < HEADER_SIZE)
+        buffer.resize(HEADER_SIZE);
+    putUnsigned(buffer.data(), requestId, 4);
+    putUnsigned(buffer.data() + 4, type, 2);
+    putUnsigned(buffer.data() + 6, status, 2);
+    putUnsigned(buffer.data() + 8, n, 4);
+
+    // After a failed write (the client went away) the other responses are dropped
+    std::lock_guard<std::mutex> lock(connection.writeMutex);
+    if(!connection.failed)
+        connection.failed = !writeFully(connection.outputFd, buffer.data(), buffer.size());
+}
+
+uint32_t QueryServer::translateSegmentId(size_t id) const
+{
+    return id < segmentIds.size() ? segmentIds[id] : NO_ID;
+}
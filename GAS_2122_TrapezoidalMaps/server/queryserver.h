@@ -0,0 +1,150 @@
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "data_structures/trapezoidalmap.h"
+
+/**
+ * @brief The QueryServer class answers batches of point-location and ray-shooting queries on a trapezoidal map built once,
+ * reading them from a stream (stdin/stdout or the connections of a unix domain socket).
+ *
+ * The protocol is binary, every number is little-endian. A client sends requests:
+ *      uint32 request id (chosen by the client, copied in the response)
+ *      uint16 query type (POINT_LOCATION, RAY_SHOOT_UP or RAY_SHOOT_DOWN)
+ *      uint16 reserved (0)
+ *      uint32 number of points n (at most MAX_BATCH_SIZE)
+ *      n points, each one as two doubles (x, y)
+ * and receives, for each request, a response:
+ *      uint32 request id
+ *      uint16 query type
+ *      uint16 status (OK or an error)
+ *      uint32 number of results n (0 if the status is an error)
+ *      n results, in the order of the points:
+ *          POINT_LOCATION:             uint32 trapezoid id, uint32 id of its top segment, uint32 id of its bottom segment
+ *          RAY_SHOOT_UP/RAY_SHOOT_DOWN: uint32 id of the segment hit
+ *
+ * The segment ids are the ones given to the constructor (e.g. the position of each segment in the input file), NO_ID stands for
+ * the bounding box. The trapezoid ids number the faces of the map from 0: they identify a face only inside this server process.
+ * A point outside the bounding box of the map (or with a NaN coordinate) is not located: all the ids of its result are OUTSIDE.
+ *
+ * A client can send many requests without waiting for the responses: the requests are answered by a pool of worker threads,
+ * so the responses can arrive in a different order (they are matched by their request id). After an error the connection is closed.
+ */
+class QueryServer
+{
+public:
+    // The query types
+    enum QueryType : uint16_t {POINT_LOCATION = 1, RAY_SHOOT_UP = 2, RAY_SHOOT_DOWN = 3};
+
+    // The status of a response
+    enum Status : uint16_t {OK = 0, UNKNOWN_QUERY_TYPE = 1, BATCH_TOO_LARGE = 2};
+
+    // The id of the bounding box (ray shooting) and of an unknown trapezoid
+    static const uint32_t NO_ID = 0xFFFFFFFF;
+
+    // The ids of the result of a point outside the bounding box of the map
+    static const uint32_t OUTSIDE = 0xFFFFFFFE;
+
+    // Maximum number of points of a request (16 MB)
+    static const uint32_t MAX_BATCH_SIZE = 1 << 20;
+
+    // Size in bytes of the header of a request and of a response
+    static const size_t HEADER_SIZE = 12;
+
+    /**
+     * @brief QueryServer   starts the worker threads. The map is only read, so it must not be modified while the server exists.
+     * @param map           the trapezoidal map.
+     * @param segmentIds    the id returned for each segment of the map, by its id in the map (i.e. its insertion order).
+     * @param nThreads      the number of worker threads (0 means one for each core).
+     */
+    QueryServer(const TrapezoidalMap& map, const std::vector<uint32_t>& segmentIds, size_t nThreads = 0);
+
+    // Destructor: it waits for the worker threads, which finish the requests already received
+    ~QueryServer();
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    /**
+     * @brief serve         answers the requests read from a file descriptor, until the end of the stream (or an error).
+     *                      It returns once all the responses are written: the file descriptors are not closed.
+     * @param inputFd       the file descriptor of the requests (e.g. 0 for stdin).
+     * @param outputFd      the file descriptor of the responses (e.g. 1 for stdout).
+     */
+    void serve(int inputFd, int outputFd);
+
+    /**
+     * @brief listen        accepts the connections on a unix domain socket: each of them is served by its own thread, the
+     *                      requests of all of them share the worker threads. A file already existing at the path is replaced.
+     * @param socketPath    the path of the socket.
+     * @return              false if the socket can't be created, otherwise it doesn't return.
+     */
+    bool listen(const std::string& socketPath);
+
+    // returns the number of trapezoids of the map (the trapezoid ids go from 0 to this number - 1)
+    size_t trapezoidNumber() const;
+
+private:
+    // A client: its streams, the lock serialising its responses and the number of its requests being answered
+    struct Connection {
+        int inputFd;
+        int outputFd;
+        bool ownsFd;
+        bool failed = false;
+        std::mutex writeMutex;
+        size_t inFlight = 0;
+        size_t inFlightPoints = 0;
+        std::mutex inFlightMutex;
+        std::condition_variable inFlightChanged;
+
+        Connection(int inputFd, int outputFd, bool ownsFd);
+        ~Connection();
+    };
+
+    // Maximum number of requests of a connection queued or being answered, and of their points (64 MB, so even the largest requests
+    // are answered 4 at a time): the reading stops until one of them is answered
+    static const size_t MAX_IN_FLIGHT = 64;
+    static const size_t MAX_IN_FLIGHT_POINTS = 4 * MAX_BATCH_SIZE;
+
+    const TrapezoidalMap& map;
+    std::vector<uint32_t> segmentIds;
+    // the id of each face of the map (the ones split by an insertion are not counted)
+    std::unordered_map<const DrawableTrapezoid*, uint32_t> trapezoidIds;
+
+    // the worker threads and the requests waiting for them
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobsChanged;
+    bool stopping = false;
+
+    // the loop of a worker thread
+    void work();
+
+    // reads the requests of a connection and queues them, until the end of the stream
+    void readRequests(const std::shared_ptr<Connection>& connection);
+
+    // answers a request and writes the response
+    void answer(const std::shared_ptr<Connection>& connection, uint32_t requestId, QueryType type, const std::vector<cg3::Point2d>& points);
+
+    // true if a point is inside the bounding box of the map (false if a coordinate is NaN)
+    bool isInside(const cg3::Point2d& point) const;
+
+    // writes a response: the header is filled with the request id, the type, the status and the number of results
+    void writeResponse(Connection& connection, uint32_t requestId, uint16_t type, Status status, uint32_t n, std::vector<unsigned char>& buffer);
+
+    // the id returned for a segment id of the map
+    uint32_t translateSegmentId(size_t id) const;
+};
+
+#endif // QUERYSERVER_H
@@ -0,0 +1,29 @@
+# Headless query server of the trapezoidal map: it builds the map once and answers batches of point-location and ray-shooting
+# queries from stdin or from the clients of a unix domain socket (see queryserver.h). It uses POSIX calls: unix only.
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= qt app_bundle
+
+!unix {
+    error("The query server needs the POSIX sockets")
+}
+
+# Release configuration
+CONFIG(release, debug|release){
+    QMAKE_CXXFLAGS_RELEASE -= -O2
+    QMAKE_CXXFLAGS += -O3 -DNDEBUG
+}
+
+# Only the core of cg3lib is needed
+CONFIG += CG3_CORE
+include (../cg3lib/cg3.pri)
+
+# The core of the trapezoidal map (no Qt, no OpenGL)
+include (../trapezoidalmap_core.pri)
+
+SOURCES += \
+    main.cpp \
+    queryserver.cpp
+
+HEADERS += \
+    queryserver.h
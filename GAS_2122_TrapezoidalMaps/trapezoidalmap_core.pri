@@ -0,0 +1,62 @@
+# Core of the trapezoidal map: the maps and their point locators, the DAG, the trapezoids, the dataset, the file utilities
+# and the generators. It depends only on the core of cg3lib (CONFIG += CG3_CORE, included before this file): no Qt, no OpenGL.
+# It's compiled in the application, in the headless tools and in the library of core/core.pro.
+#
+# The trapezoids of the maps are DrawableTrapezoid objects: their graphics (color and verteces) are computed only when the
+# application draws them, and their opengl drawing code is in drawables/drawabletrapezoid_gl.cpp, compiled only there.
+
+# Count the heap allocations of each operation (see utils/allocationcounter.h)
+COUNT_ALLOCATIONS {
+    DEFINES += TRAPEZOIDALMAP_COUNT_ALLOCATIONS
+}
+
+# The sources are included relatively to the root folder of the project
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/algorithms/OrientationUtility.cpp \
+    $$PWD/algorithms/SegmentIntersections.cpp \
+    $$PWD/algorithms/SpatialSort.cpp \
+    $$PWD/data_structures/compactlocator.cpp \
+    $$PWD/data_structures/dag.cpp \
+    $$PWD/data_structures/dagnode.cpp \
+    $$PWD/data_structures/gridindex.cpp \
+    $$PWD/data_structures/orderedsegment.cpp \
+    $$PWD/data_structures/packedaabbtree.cpp \
+    $$PWD/data_structures/persistentslablocator.cpp \
+    $$PWD/data_structures/pointlocator.cpp \
+    $$PWD/data_structures/segment_intersection_checker.cpp \
+    $$PWD/data_structures/slabtrapezoidalmap.cpp \
+    $$PWD/data_structures/sweeptrapezoidalmap.cpp \
+    $$PWD/data_structures/trapezoid.cpp \
+    $$PWD/data_structures/trapezoidalmap.cpp \
+    $$PWD/data_structures/trapezoidalmap_dataset.cpp \
+    $$PWD/drawables/drawabletrapezoid.cpp \
+    $$PWD/utils/allocationcounter.cpp \
+    $$PWD/utils/fileutils.cpp \
+    $$PWD/utils/segmentgenerator.cpp \
+    $$PWD/utils/workloadgenerator.cpp
+
+HEADERS += \
+    $$PWD/algorithms/OrientationUtility.h \
+    $$PWD/algorithms/SegmentIntersections.h \
+    $$PWD/algorithms/SpatialSort.h \
+    $$PWD/data_structures/compactlocator.h \
+    $$PWD/data_structures/dag.h \
+    $$PWD/data_structures/dagnode.h \
+    $$PWD/data_structures/gridindex.h \
+    $$PWD/data_structures/orderedsegment.h \
+    $$PWD/data_structures/packedaabbtree.h \
+    $$PWD/data_structures/persistentslablocator.h \
+    $$PWD/data_structures/pointlocator.h \
+    $$PWD/data_structures/segment_intersection_checker.h \
+    $$PWD/data_structures/slabtrapezoidalmap.h \
+    $$PWD/data_structures/sweeptrapezoidalmap.h \
+    $$PWD/data_structures/trapezoid.h \
+    $$PWD/data_structures/trapezoidalmap.h \
+    $$PWD/data_structures/trapezoidalmap_dataset.h \
+    $$PWD/drawables/drawabletrapezoid.h \
+    $$PWD/utils/allocationcounter.h \
+    $$PWD/utils/fileutils.h \
+    $$PWD/utils/segmentgenerator.h \
+    $$PWD/utils/workloadgenerator.h
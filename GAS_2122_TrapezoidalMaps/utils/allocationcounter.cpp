@@ -0,0 +1,185 @@
+#include "allocationcounter.h"
+
+#include <array>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace AllocationCounter {
+
+namespace {
+
+// statistics of every operation, protected by a mutex since the scopes can be closed by several threads
+std::array<Stats, N_OPERATIONS> statistics;
+std::mutex statisticsMutex;
+
+// the expected sizes of every operation (0 is not a size): they're only read while the operations are counted
+std::array<std::array<size_t, MAX_EXPECTED_SIZES>, N_OPERATIONS> expectedSizes = {};
+
+#ifdef TRAPEZOIDALMAP_COUNT_ALLOCATIONS
+// the innermost scope open in the current thread (nullptr if no operation is being counted)
+thread_local Scope* currentScope = nullptr;
+#endif
+
+}
+
+
+/// SCOPE ///
+Scope::Scope(Operation operation) : operation(operation), previous(nullptr) {
+#ifdef TRAPEZOIDALMAP_COUNT_ALLOCATIONS
+    previous = currentScope;
+    currentScope = this;
+#endif
+}
+
+Scope::~Scope() {
+#ifdef TRAPEZOIDALMAP_COUNT_ALLOCATIONS
+    currentScope = previous;
+#endif
+
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    Stats& stats = statistics[operation];
+    stats.calls++;
+    stats.allocations += allocations;
+    stats.bytes += bytes;
+    stats.expectedAllocations += expectedAllocations;
+    if(allocations > stats.maxAllocationsPerCall)
+        stats.maxAllocationsPerCall = allocations;
+    if(size_t(highWaterBytes) > stats.highWaterBytes)
+        stats.highWaterBytes = size_t(highWaterBytes);
+}
+
+void Scope::recordAllocation(size_t size) {
+    allocations++;
+    bytes += size;
+    for(size_t expectedSize : expectedSizes[operation]) {
+        if(expectedSize == size) {
+            expectedAllocations++;
+            break;
+        }
+    }
+    liveBytes += static_cast<long long>(size);
+    if(liveBytes > highWaterBytes)
+        highWaterBytes = liveBytes;
+}
+
+void Scope::recordDeallocation(size_t size) {
+    // the memory could have been allocated outside the scope, so the live bytes can become negative
+    liveBytes -= static_cast<long long>(size);
+}
+///////////////////////////////////////
+
+
+bool isEnabled() {
+#ifdef TRAPEZOIDALMAP_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void setExpectedSizes(Operation operation, const std::vector<size_t>& sizes) {
+    expectedSizes[operation].fill(0);
+    for(size_t i = 0; i < sizes.size() && i < MAX_EXPECTED_SIZES; i++)
+        expectedSizes[operation][i] = sizes[i];
+}
+
+Stats getStats(Operation operation) {
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    return statistics[operation];
+}
+
+void reset() {
+    std::lock_guard<std::mutex> lock(statisticsMutex);
+    statistics.fill(Stats());
+}
+
+void report(std::ostream& stream) {
+    if(!isEnabled()) {
+        stream << "Allocation counting disabled (build with CONFIG += COUNT_ALLOCATIONS)" << std::endl;
+        return;
+    }
+
+    stream << "operation            calls     allocs    expected  allocs/call  max/call   bytes        high-water" << std::endl;
+    for(size_t i = 0; i < N_OPERATIONS; i++) {
+        const Operation operation = Operation(i);
+        const Stats stats = getStats(operation);
+        const double allocationsPerCall = stats.calls > 0 ? double(stats.allocations) / stats.calls : 0.0;
+
+        stream.width(20); stream << std::left << getOperationName(operation) << " ";
+        stream.width(9);  stream << stats.calls << " ";
+        stream.width(9);  stream << stats.allocations << " ";
+        stream.width(9);  stream << stats.expectedAllocations << " ";
+        stream.width(12); stream << allocationsPerCall << " ";
+        stream.width(10); stream << stats.maxAllocationsPerCall << " ";
+        stream.width(12); stream << stats.bytes << " ";
+        stream << stats.highWaterBytes << std::right << std::endl;
+    }
+}
+
+const char* getOperationName(Operation operation) {
+    switch(operation) {
+        case ADD_SEGMENT:                return "addSegment";
+        case POINT_LOCATION:             return "pointLocation";
+        case DATASET_ADD_SEGMENT:        return "dataset addSegment";
+        case DATASET_ADD_SEGMENTS:       return "dataset addSegments";
+        case DATASET_ADD_NODED_SEGMENTS: return "dataset addNodedSegments";
+        case DRAW:                       return "draw";
+        default:                         return "unknown";
+    }
+}
+
+}
+
+
+
+#ifdef TRAPEZOIDALMAP_COUNT_ALLOCATIONS
+/* Replacement of the global allocation functions.
+ * Every block is preceded by a header storing its size, so that the deallocation can be charged too.
+ * The header is as large as the maximum alignment, so the memory returned keeps the alignment guaranteed by malloc. */
+namespace {
+
+const size_t HEADER_SIZE = alignof(std::max_align_t);
+
+void* countedAllocation(size_t size) {
+    char* block = static_cast<char*>(std::malloc(size + HEADER_SIZE));
+    if(block == nullptr)
+        return nullptr;
+
+    *reinterpret_cast<size_t*>(block) = size;
+    if(AllocationCounter::currentScope != nullptr)
+        AllocationCounter::currentScope->recordAllocation(size);
+
+    return block + HEADER_SIZE;
+}
+
+void countedDeallocation(void* pointer) {
+    if(pointer == nullptr)
+        return;
+
+    char* block = static_cast<char*>(pointer) - HEADER_SIZE;
+    if(AllocationCounter::currentScope != nullptr)
+        AllocationCounter::currentScope->recordDeallocation(*reinterpret_cast<size_t*>(block));
+
+    std::free(block);
+}
+
+void* countedAllocationOrThrow(size_t size) {
+    void* pointer = countedAllocation(size);
+    if(pointer == nullptr)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+}
+
+void* operator new(size_t size) { return countedAllocationOrThrow(size); }
+void* operator new[](size_t size) { return countedAllocationOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAllocation(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAllocation(size); }
+
+void operator delete(void* pointer) noexcept { countedDeallocation(pointer); }
+void operator delete[](void* pointer) noexcept { countedDeallocation(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { countedDeallocation(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { countedDeallocation(pointer); }
+#endif
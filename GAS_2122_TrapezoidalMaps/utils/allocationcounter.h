@@ -0,0 +1,99 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/* Opt-in accounting of the heap allocations done by the operations of the trapezoidal map.
+ * It is enabled by the build flag TRAPEZOIDALMAP_COUNT_ALLOCATIONS (CONFIG += COUNT_ALLOCATIONS in the .pro files):
+ * in that case the global operator new/delete are replaced by counting versions.
+ * Without the flag the macro COUNT_ALLOCATIONS expands to nothing and the operations pay no cost. */
+namespace AllocationCounter {
+
+// The operations whose allocations are counted
+enum Operation {ADD_SEGMENT, POINT_LOCATION, DATASET_ADD_SEGMENT, DATASET_ADD_SEGMENTS, DATASET_ADD_NODED_SEGMENTS, DRAW, N_OPERATIONS};
+
+/**
+ * @brief The Stats struct collects the allocations done by all the calls of an operation.
+ */
+struct Stats {
+    // number of calls of the operation
+    size_t calls = 0;
+    // total number of allocations and of bytes allocated
+    size_t allocations = 0;
+    size_t bytes = 0;
+    // number of allocations of the expected sizes (see setExpectedSizes), included in allocations
+    size_t expectedAllocations = 0;
+    // maximum number of allocations done by a single call
+    size_t maxAllocationsPerCall = 0;
+    // high-water mark: maximum number of bytes alive at the same time during a single call (allocated and not freed yet)
+    size_t highWaterBytes = 0;
+};
+
+/**
+ * @brief The Scope class counts the allocations done by the current thread during its lifetime and charges them to an operation.
+ * The scopes can be nested: the allocations are charged only to the innermost one.
+ */
+class Scope
+{
+public:
+    Scope(Operation operation);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    // called by the replaced operator new/delete
+    void recordAllocation(size_t size);
+    void recordDeallocation(size_t size);
+
+private:
+    Operation operation;
+    // the scope active before this one (restored at the end)
+    Scope* previous;
+
+    size_t allocations = 0;
+    size_t bytes = 0;
+    size_t expectedAllocations = 0;
+    // bytes alive (allocated in this scope and not freed yet) and their maximum
+    long long liveBytes = 0;
+    long long highWaterBytes = 0;
+};
+
+// returns true if the program has been built with the allocation counting
+bool isEnabled();
+
+// Maximum number of expected sizes of an operation
+const size_t MAX_EXPECTED_SIZES = 4;
+
+/**
+ * @brief setExpectedSizes  sets the sizes of the blocks an operation is expected to allocate (e.g. the objects it creates): their
+ *                          allocations are counted apart too, so the other ones (scratch buffers, lists growing) stand out.
+ *                          It must be called when no operation is being counted.
+ * @param operation         the operation.
+ * @param sizes             the sizes (at most MAX_EXPECTED_SIZES, the others are ignored). An empty list clears them.
+ */
+void setExpectedSizes(Operation operation, const std::vector<size_t>& sizes);
+
+// returns the statistics collected for an operation
+Stats getStats(Operation operation);
+
+// resets the statistics of all the operations
+void reset();
+
+// prints the statistics of all the operations
+void report(std::ostream& stream);
+
+// returns the name of an operation
+const char* getOperationName(Operation operation);
+
+}
+
+#ifdef TRAPEZOIDALMAP_COUNT_ALLOCATIONS
+    #define COUNT_ALLOCATIONS(operation) AllocationCounter::Scope allocationScope(AllocationCounter::operation)
+#else
+    #define COUNT_ALLOCATIONS(operation)
+#endif
+
+#endif // ALLOCATIONCOUNTER_H
@@ -1,5 +1,7 @@
 #include "fileutils.h"
 
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <random>
 #include <iomanip>
@@ -10,14 +12,99 @@
 
 namespace FileUtils {
 
+namespace {
+
+const size_t TAG_SIZE = sizeof(SEGMENTS_TAG) - 1;
+
+// Writes a 64-bit unsigned in little-endian byte order
+void writeUnsigned(std::ofstream& outfile, uint64_t value) {
+    char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+    outfile.write(bytes, 8);
+}
+
+// Reads a 64-bit unsigned in little-endian byte order (false at the end of the file)
+bool readUnsigned(std::ifstream& infile, uint64_t& value) {
+    unsigned char bytes[8];
+    if (!infile.read(reinterpret_cast<char*>(bytes), 8)) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    return true;
+}
+
+// The doubles are written through their bits, so the files don't depend on the byte order of the machine
+void writeDouble(std::ofstream& outfile, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeUnsigned(outfile, bits);
+}
+
+bool readDouble(std::ifstream& infile, double& value) {
+    uint64_t bits;
+    if (!readUnsigned(infile, bits)) {
+        return false;
+    }
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+// Opens a file and tells if it starts with the given tag: in that case the file is positioned after it,
+// otherwise it's reopened as a text file
+bool openFile(const std::string& filename, const char* tag, std::ifstream& infile) {
+    infile.open(filename, std::ios::binary);
+    char bytes[TAG_SIZE];
+    if (infile.read(bytes, TAG_SIZE) && std::memcmp(bytes, tag, TAG_SIZE) == 0) {
+        return true;
+    }
+    infile.close();
+    infile.clear();
+    infile.open(filename);
+    return false;
+}
+
+// Opens a binary file and writes its tag and the number of elements
+void createBinaryFile(const std::string& filename, const char* tag, size_t n, std::ofstream& outfile) {
+    outfile.open(filename, std::ios::binary);
+    outfile.write(tag, TAG_SIZE);
+    writeUnsigned(outfile, n);
+}
+
+}
+
 std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename) {
+    bool isComplete;
+    return getSegmentsFromFile(filename, isComplete);
+}
+
+std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename, bool& isComplete) {
     std::vector<cg3::Segment2d> segments;
 	
 	std::ifstream infile;
-    infile.open(filename);
+    if (openFile(filename, SEGMENTS_TAG, infile)) {
+        uint64_t n = 0;
+        isComplete = readUnsigned(infile, n);
+
+        double x1, y1, x2, y2;
+        for (uint64_t i = 0; i < n; i++) {
+            if (!readDouble(infile, x1) || !readDouble(infile, y1) || !readDouble(infile, x2) || !readDouble(infile, y2)) {
+                isComplete = false;
+                break;
+            }
+            segments.push_back(cg3::Segment2d(cg3::Point2d(x1, y1), cg3::Point2d(x2, y2)));
+        }
 
-    int n;
+        return segments;
+    }
+
+    int n = 0;
     infile >> n;
+    isComplete = infile && n >= 0;
 
     for (int i = 0; i < n; i++) {
         double x = 0.0;
@@ -28,6 +115,11 @@ std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename) {
 		
         infile >> x >> y;
         cg3::Point2d p2(x,y);
+
+        if (!infile) {
+            isComplete = false;
+            break;
+        }
 		
         segments.push_back(cg3::Segment2d(p1, p2));
     }
@@ -56,5 +148,96 @@ std::vector<cg3::Segment2d> saveSegmentsInFile(const std::string& filename, cons
     return segments;
 }
 
+std::vector<cg3::Segment2d> saveSegmentsInBinaryFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments) {
+    std::ofstream outfile;
+    createBinaryFile(filename, SEGMENTS_TAG, segments.size(), outfile);
+
+    for (const cg3::Segment2d& segment : segments) {
+        writeDouble(outfile, segment.p1().x());
+        writeDouble(outfile, segment.p1().y());
+        writeDouble(outfile, segment.p2().x());
+        writeDouble(outfile, segment.p2().y());
+    }
+
+    outfile.close();
+
+    return segments;
+}
+
+std::vector<cg3::Point2d> getPointsFromFile(const std::string& filename) {
+    bool isComplete;
+    return getPointsFromFile(filename, isComplete);
+}
+
+std::vector<cg3::Point2d> getPointsFromFile(const std::string& filename, bool& isComplete) {
+    std::vector<cg3::Point2d> points;
+
+    std::ifstream infile;
+    if (openFile(filename, POINTS_TAG, infile)) {
+        uint64_t n = 0;
+        isComplete = readUnsigned(infile, n);
+
+        double x, y;
+        for (uint64_t i = 0; i < n; i++) {
+            if (!readDouble(infile, x) || !readDouble(infile, y)) {
+                isComplete = false;
+                break;
+            }
+            points.push_back(cg3::Point2d(x, y));
+        }
+
+        return points;
+    }
+
+    int n = 0;
+    infile >> n;
+    isComplete = infile && n >= 0;
+
+    for (int i = 0; i < n; i++) {
+        double x = 0.0;
+        double y = 0.0;
+
+        infile >> x >> y;
+
+        if (!infile) {
+            isComplete = false;
+            break;
+        }
+
+        points.push_back(cg3::Point2d(x, y));
+    }
+
+    return points;
+}
+
+std::vector<cg3::Point2d> savePointsInFile(const std::string& filename, const std::vector<cg3::Point2d>& points) {
+    std::ofstream outfile;
+    outfile.open(filename);
+
+    outfile << points.size() << std::endl;
+
+    outfile << std::fixed << std::setprecision(4);
+    for (const cg3::Point2d& point : points) {
+        outfile << point.x() << " " << point.y() << std::endl;
+    }
+
+    outfile.close();
+
+    return points;
+}
+
+std::vector<cg3::Point2d> savePointsInBinaryFile(const std::string& filename, const std::vector<cg3::Point2d>& points) {
+    std::ofstream outfile;
+    createBinaryFile(filename, POINTS_TAG, points.size(), outfile);
+
+    for (const cg3::Point2d& point : points) {
+        writeDouble(outfile, point.x());
+        writeDouble(outfile, point.y());
+    }
+
+    outfile.close();
+
+    return points;
+}
 
 }
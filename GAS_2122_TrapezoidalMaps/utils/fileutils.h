@@ -7,10 +7,33 @@
 
 namespace FileUtils {
 
+// The binary files start with one of these tags, followed by the number of elements (64-bit unsigned) and by their
+// coordinates (64-bit IEEE 754 doubles), all in little-endian byte order
+const char SEGMENTS_TAG[] = "TMAPSEG1";
+const char POINTS_TAG[] = "TMAPPTS1";
+
+// Reads the segments of a text or binary file (recognized by its tag)
 std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename);
 
+// Same as above: isComplete is false if the file can't be opened, or it ends (or can't be parsed) before the segments it declares.
+// In that case the segments read up to the error are returned
+std::vector<cg3::Segment2d> getSegmentsFromFile(const std::string& filename, bool& isComplete);
+
 std::vector<cg3::Segment2d> saveSegmentsInFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments);
 
+std::vector<cg3::Segment2d> saveSegmentsInBinaryFile(const std::string& filename, const std::vector<cg3::Segment2d>& segments);
+
+// Reads the points of a text file (the number of points, then their coordinates) or of a binary file
+std::vector<cg3::Point2d> getPointsFromFile(const std::string& filename);
+
+// Same as above: isComplete is false if the file can't be opened, or it ends (or can't be parsed) before the points it declares.
+// In that case the points read up to the error are returned
+std::vector<cg3::Point2d> getPointsFromFile(const std::string& filename, bool& isComplete);
+
+std::vector<cg3::Point2d> savePointsInFile(const std::string& filename, const std::vector<cg3::Point2d>& points);
+
+std::vector<cg3::Point2d> savePointsInBinaryFile(const std::string& filename, const std::vector<cg3::Point2d>& points);
+
 }
 
 #endif // FILEUTILS_H
@@ -0,0 +1,52 @@
+#include "segmentgenerator.h"
+
+#include <cmath>
+
+namespace SegmentGenerator {
+
+std::vector<cg3::Segment2d> randomNonIntersectingSegments(size_t n, const cg3::BoundingBox2& box, uint64_t seed) {
+    std::vector<cg3::Segment2d> segments;
+    if (n == 0) {
+        return segments;
+    }
+    segments.reserve(n);
+
+    std::mt19937_64 generator(seed);
+
+    // The smallest square grid with at least n cells
+    uint64_t cellsPerSide = static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+    while (cellsPerSide * cellsPerSide < n) {
+        cellsPerSide++;
+    }
+    const double cellWidth = (box.max().x() - box.min().x()) / static_cast<double>(cellsPerSide);
+    const double cellHeight = (box.max().y() - box.min().y()) / static_cast<double>(cellsPerSide);
+
+    // The first n cells of a partial Fisher-Yates shuffle
+    std::vector<uint64_t> cells(cellsPerSide * cellsPerSide);
+    for (uint64_t i = 0; i < cells.size(); i++) {
+        cells[i] = i;
+    }
+    for (size_t i = 0; i < n; i++) {
+        std::swap(cells[i], cells[i + randomBelow(generator, cells.size() - i)]);
+
+        const double minX = box.min().x() + (static_cast<double>(cells[i] % cellsPerSide) + CELL_MARGIN) * cellWidth;
+        const double minY = box.min().y() + (static_cast<double>(cells[i] / cellsPerSide) + CELL_MARGIN) * cellHeight;
+        const double width = (1 - 2 * CELL_MARGIN) * cellWidth;
+        const double height = (1 - 2 * CELL_MARGIN) * cellHeight;
+
+        // The numbers are drawn one per statement: the order of evaluation of arguments is unspecified
+        cg3::Point2d p1, p2;
+        do {
+            p1.setXCoord(minX + randomUnit(generator) * width);
+            p1.setYCoord(minY + randomUnit(generator) * height);
+            p2.setXCoord(minX + randomUnit(generator) * width);
+            p2.setYCoord(minY + randomUnit(generator) * height);
+        } while (p1 == p2);
+
+        segments.push_back(cg3::Segment2d(p1, p2));
+    }
+
+    return segments;
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef SEGMENTGENERATOR_H
+#define SEGMENTGENERATOR_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <cg3/geometry/bounding_box2.h>
+#include <cg3/geometry/segment2.h>
+
+namespace SegmentGenerator {
+
+// uniform double in [0, 1), from the 53 highest bits of the generator (the standard distributions give different numbers on different platforms)
+inline double randomUnit(std::mt19937_64& generator) {
+    return static_cast<double>(generator() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// uniform integer in [0, n) (the bias of the modulo is negligible for n much smaller than 2^64)
+inline uint64_t randomBelow(std::mt19937_64& generator, uint64_t n) {
+    return generator() % n;
+}
+
+// margin left empty on each side of a cell, as a fraction of the cell: segments in different cells never touch
+const double CELL_MARGIN = 0.05;
+
+/**
+ * @brief randomNonIntersectingSegments    generates random segments which don't intersect each other, in O(n) time.
+ *                                         The box is divided in a grid of about n square-ish cells (ceil(sqrt(n)) per side):
+ *                                         n distinct cells are drawn at random, and each one gets a segment with both
+ *                                         endpoints inside it (away from its border), so no candidate is ever rejected.
+ *                                         The random numbers are derived from the raw bits of a std::mt19937_64, so the
+ *                                         same seed gives the same segments on every platform.
+ * @param n                                the number of segments.
+ * @param box                              the box containing the segments.
+ * @param seed                             the seed of the generator.
+ * @return                                 the segments, in random order (non-degenerate).
+ */
+std::vector<cg3::Segment2d> randomNonIntersectingSegments(size_t n, const cg3::BoundingBox2& box, uint64_t seed);
+
+}
+
+#endif // SEGMENTGENERATOR_H
@@ -0,0 +1,479 @@
+#include "workloadgenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "algorithms/SegmentIntersections.h"
+#include "utils/segmentgenerator.h"
+
+namespace WorkloadGenerator {
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+const char* SHAPE_NAMES[N_SEGMENT_SHAPES] = {"uniform", "clustered", "thin", "vertical", "grid", "roads"};
+const char* DISTRIBUTION_NAMES[N_QUERY_DISTRIBUTIONS] = {"uniform", "clustered", "near", "walk"};
+
+// Fraction of the streets kept, of the blocks crossed by a diagonal street, and maximum displacement of the crossroads
+// (as a fraction of the distance between two streets)
+const double STREET_PROBABILITY = 0.85;
+const double DIAGONAL_PROBABILITY = 0.1;
+const double CROSSROAD_JITTER = 0.2;
+
+// Rounds a coordinate to DECIMALS digits: the division gives the double nearest to the decimal number, like reading it from a text file
+double roundCoordinate(double x) {
+    const double scale = std::pow(10.0, DECIMALS);
+    return std::round(x * scale) / scale;
+}
+
+cg3::Point2d roundPoint(const cg3::Point2d& p) {
+    return cg3::Point2d(roundCoordinate(p.x()), roundCoordinate(p.y()));
+}
+
+cg3::Point2d clampPoint(const cg3::Point2d& p, const cg3::BoundingBox2& box) {
+    return cg3::Point2d(std::min(std::max(p.x(), box.min().x()), box.max().x()), std::min(std::max(p.y(), box.min().y()), box.max().y()));
+}
+
+// uniform double in [a, b)
+double uniform(std::mt19937_64& generator, double a, double b) {
+    return a + SegmentGenerator::randomUnit(generator) * (b - a);
+}
+
+// standard gaussian (Box-Muller)
+double gaussian(std::mt19937_64& generator) {
+    const double u = 1 - SegmentGenerator::randomUnit(generator);
+    const double v = SegmentGenerator::randomUnit(generator);
+    return std::sqrt(-2 * std::log(u)) * std::cos(2 * PI * v);
+}
+
+template<class T>
+void shuffle(std::vector<T>& elements, std::mt19937_64& generator) {
+    for (size_t i = elements.size(); i > 1; i--) {
+        std::swap(elements[i - 1], elements[SegmentGenerator::randomBelow(generator, i)]);
+    }
+}
+
+// Rounds the coordinates, removes the degenerate segments and the ones made intersecting by the rounding, and shuffles the rest
+std::vector<cg3::Segment2d> finalizeSegments(const std::vector<cg3::Segment2d>& segments, std::mt19937_64& generator) {
+    std::vector<cg3::Segment2d> rounded;
+    rounded.reserve(segments.size());
+    for (const cg3::Segment2d& segment : segments) {
+        const cg3::Point2d p1 = roundPoint(segment.p1());
+        const cg3::Point2d p2 = roundPoint(segment.p2());
+        if (p1 != p2) {
+            rounded.push_back(cg3::Segment2d(p1, p2));
+        }
+    }
+
+    std::vector<bool> discarded;
+    std::vector<SegmentIntersections::IntersectingPair> pairs;
+    SegmentIntersections::discardIntersecting(rounded, discarded, pairs);
+
+    std::vector<cg3::Segment2d> result;
+    result.reserve(rounded.size());
+    for (size_t i = 0; i < rounded.size(); i++) {
+        if (!discarded[i]) {
+            result.push_back(rounded[i]);
+        }
+    }
+    shuffle(result, generator);
+    return result;
+}
+
+// The smallest number of cells per side of a square grid with at least n cells
+uint64_t cellsPerSide(size_t n) {
+    uint64_t side = static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+    while (side * side < n) {
+        side++;
+    }
+    return std::max<uint64_t>(side, 1);
+}
+
+std::vector<cg3::Segment2d> clusteredSegments(size_t n, const cg3::BoundingBox2& box, std::mt19937_64& generator) {
+    // The clusters are in distinct cells of a coarse grid (half of the cells are empty), so they don't overlap
+    const size_t nClusters = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(n)) / 8));
+    const uint64_t side = cellsPerSide(2 * nClusters);
+    const double cellWidth = box.lengthX() / static_cast<double>(side);
+    const double cellHeight = box.lengthY() / static_cast<double>(side);
+
+    std::vector<uint64_t> cells(side * side);
+    for (uint64_t i = 0; i < cells.size(); i++) {
+        cells[i] = i;
+    }
+
+    // Heavy-tailed weights: the largest clusters have about 50 times the segments of the smallest ones
+    std::vector<double> weights(nClusters);
+    double totalWeight = 0;
+    for (double& weight : weights) {
+        weight = 1 / (0.02 + SegmentGenerator::randomUnit(generator));
+        totalWeight += weight;
+    }
+    std::vector<size_t> sizes(nClusters);
+    size_t assigned = 0;
+    for (size_t i = 0; i < nClusters; i++) {
+        sizes[i] = static_cast<size_t>(static_cast<double>(n) * weights[i] / totalWeight);
+        assigned += sizes[i];
+    }
+    for (size_t i = 0; assigned < n; i = (i + 1) % nClusters) {
+        sizes[i]++;
+        assigned++;
+    }
+
+    std::vector<cg3::Segment2d> segments;
+    segments.reserve(n);
+    for (size_t i = 0; i < nClusters; i++) {
+        std::swap(cells[i], cells[i + SegmentGenerator::randomBelow(generator, cells.size() - i)]);
+
+        // A cluster takes from 10% to 90% of its cell
+        const double size = uniform(generator, 0.1, 0.9);
+        const double minX = box.min().x() + (static_cast<double>(cells[i] % side) + uniform(generator, 0, 1 - size)) * cellWidth;
+        const double minY = box.min().y() + (static_cast<double>(cells[i] / side) + uniform(generator, 0, 1 - size)) * cellHeight;
+        const cg3::BoundingBox2 cluster(cg3::Point2d(minX, minY), cg3::Point2d(minX + size * cellWidth, minY + size * cellHeight));
+
+        const std::vector<cg3::Segment2d> clusterSegments =
+                SegmentGenerator::randomNonIntersectingSegments(sizes[i], cluster, generator());
+        segments.insert(segments.end(), clusterSegments.begin(), clusterSegments.end());
+    }
+    return segments;
+}
+
+std::vector<cg3::Segment2d> longThinSegments(size_t n, const cg3::BoundingBox2& box, std::mt19937_64& generator) {
+    // Each segment is in its own horizontal strip, and it's from 30% to 100% as long as the box
+    const double stripHeight = box.lengthY() / static_cast<double>(n);
+    const double margin = SegmentGenerator::CELL_MARGIN;
+
+    std::vector<cg3::Segment2d> segments;
+    segments.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        const double length = uniform(generator, 0.3, 1) * box.lengthX();
+        const double x = uniform(generator, box.min().x(), box.max().x() - length);
+        const double y1 = box.min().y() + (static_cast<double>(i) + uniform(generator, margin, 1 - margin)) * stripHeight;
+        const double y2 = box.min().y() + (static_cast<double>(i) + uniform(generator, margin, 1 - margin)) * stripHeight;
+        segments.push_back(cg3::Segment2d(cg3::Point2d(x, y1), cg3::Point2d(x + length, y2)));
+    }
+    return segments;
+}
+
+std::vector<cg3::Segment2d> nearVerticalSegments(size_t n, const cg3::BoundingBox2& box, std::mt19937_64& generator) {
+    // The box is divided in columns, and each column in cells stacked on top of each other, one for each segment
+    const uint64_t columns = cellsPerSide(n);
+    const uint64_t rows = (n + columns - 1) / columns;
+    const double cellWidth = box.lengthX() / static_cast<double>(columns);
+    const double cellHeight = box.lengthY() / static_cast<double>(rows);
+    const double margin = SegmentGenerator::CELL_MARGIN;
+
+    std::vector<cg3::Segment2d> segments;
+    segments.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        const double minX = box.min().x() + static_cast<double>(i % columns) * cellWidth;
+        const double minY = box.min().y() + static_cast<double>(i / columns) * cellHeight;
+
+        // The bottom endpoint is in the lower half of the cell and the top one in the upper half
+        const double x1 = minX + uniform(generator, margin, 1 - margin) * cellWidth;
+        const double y1 = minY + uniform(generator, margin, 0.5) * cellHeight;
+        const double y2 = minY + uniform(generator, 0.5, 1 - margin) * cellHeight;
+
+        // One segment out of 8 is vertical, the others have a horizontal extent from 10^-2 to 10^-6 times the vertical one
+        double x2 = x1;
+        if (SegmentGenerator::randomBelow(generator, 8) != 0) {
+            const double slope = std::pow(10.0, uniform(generator, -6, -2));
+            const double sign = SegmentGenerator::randomBelow(generator, 2) == 0 ? -1 : 1;
+            x2 = std::min(std::max(x1 + sign * slope * (y2 - y1), minX + margin * cellWidth), minX + (1 - margin) * cellWidth);
+        }
+        segments.push_back(cg3::Segment2d(cg3::Point2d(x1, y1), cg3::Point2d(x2, y2)));
+    }
+    return segments;
+}
+
+std::vector<cg3::Segment2d> gridSegments(size_t n, const cg3::BoundingBox2& box, std::mt19937_64& generator) {
+    // The smallest lattice with at least n edges: with side points per side it has 2 * side * (side - 1) edges
+    uint64_t side = 2;
+    while (2 * side * (side - 1) < n) {
+        side++;
+    }
+    std::vector<double> xs(side), ys(side);
+    for (uint64_t i = 0; i < side; i++) {
+        xs[i] = box.min().x() + box.lengthX() * static_cast<double>(i) / static_cast<double>(side - 1);
+        ys[i] = box.min().y() + box.lengthY() * static_cast<double>(i) / static_cast<double>(side - 1);
+    }
+
+    // The first n edges of a partial Fisher-Yates shuffle: the horizontal ones first, row by row, then the vertical ones
+    const uint64_t nHorizontal = side * (side - 1);
+    std::vector<uint64_t> edges(2 * nHorizontal);
+    for (uint64_t i = 0; i < edges.size(); i++) {
+        edges[i] = i;
+    }
+
+    std::vector<cg3::Segment2d> segments;
+    segments.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        std::swap(edges[i], edges[i + SegmentGenerator::randomBelow(generator, edges.size() - i)]);
+
+        const uint64_t edge = edges[i] % nHorizontal;
+        const uint64_t line = edge / (side - 1);
+        const uint64_t position = edge % (side - 1);
+        if (edges[i] < nHorizontal) {
+            segments.push_back(cg3::Segment2d(cg3::Point2d(xs[position], ys[line]), cg3::Point2d(xs[position + 1], ys[line])));
+        }
+        else {
+            segments.push_back(cg3::Segment2d(cg3::Point2d(xs[line], ys[position]), cg3::Point2d(xs[line], ys[position + 1])));
+        }
+    }
+    return segments;
+}
+
+// The positions of the streets along an axis of the box, from 0 to 1: they're 9 times denser in the middle than on the sides
+std::vector<double> streetPositions(uint64_t side) {
+    std::vector<double> positions(side);
+    for (uint64_t i = 0; i < side; i++) {
+        const double t = static_cast<double>(i) / static_cast<double>(side - 1);
+        positions[i] = t + 0.8 * std::sin(2 * PI * t) / (2 * PI);
+    }
+    return positions;
+}
+
+// The distance between a street and the nearest one
+double streetSpacing(const std::vector<double>& positions, size_t i) {
+    double spacing = i > 0 ? positions[i] - positions[i - 1] : positions[i + 1] - positions[i];
+    if (i > 0 && i + 1 < positions.size()) {
+        spacing = std::min(spacing, positions[i + 1] - positions[i]);
+    }
+    return spacing;
+}
+
+std::vector<cg3::Segment2d> roadSegments(size_t n, const cg3::BoundingBox2& box, std::mt19937_64& generator) {
+    // The streets (with the diagonals) are about 0.9 * 2 * side^2, the pieces of the highways make up the rest
+    const uint64_t side = std::max<uint64_t>(2, cellsPerSide(n / 2));
+    const std::vector<double> positions = streetPositions(side);
+
+    // The crossroads are moved from the lattice by a fraction of the distance between the streets, so the blocks stay convex
+    std::vector<cg3::Point2d> crossroads(side * side);
+    for (uint64_t j = 0; j < side; j++) {
+        for (uint64_t i = 0; i < side; i++) {
+            const double x = positions[i] + uniform(generator, -CROSSROAD_JITTER, CROSSROAD_JITTER) * streetSpacing(positions, i);
+            const double y = positions[j] + uniform(generator, -CROSSROAD_JITTER, CROSSROAD_JITTER) * streetSpacing(positions, j);
+            crossroads[j * side + i] = clampPoint(cg3::Point2d(box.min().x() + x * box.lengthX(), box.min().y() + y * box.lengthY()), box);
+        }
+    }
+
+    std::vector<cg3::Segment2d> segments;
+    for (uint64_t j = 0; j < side; j++) {
+        for (uint64_t i = 0; i < side; i++) {
+            const cg3::Point2d& crossroad = crossroads[j * side + i];
+            if (i + 1 < side && SegmentGenerator::randomUnit(generator) < STREET_PROBABILITY) {
+                segments.push_back(cg3::Segment2d(crossroad, crossroads[j * side + i + 1]));
+            }
+            if (j + 1 < side && SegmentGenerator::randomUnit(generator) < STREET_PROBABILITY) {
+                segments.push_back(cg3::Segment2d(crossroad, crossroads[(j + 1) * side + i]));
+            }
+            if (i + 1 < side && j + 1 < side && SegmentGenerator::randomUnit(generator) < DIAGONAL_PROBABILITY) {
+                if (SegmentGenerator::randomBelow(generator, 2) == 0) {
+                    segments.push_back(cg3::Segment2d(crossroad, crossroads[(j + 1) * side + i + 1]));
+                }
+                else {
+                    segments.push_back(cg3::Segment2d(crossroads[j * side + i + 1], crossroads[(j + 1) * side + i]));
+                }
+            }
+        }
+    }
+
+    // The highways cross the box from side to side (half of them horizontally, half vertically), in steps of about a tenth of it
+    const uint64_t nHighways = std::max<uint64_t>(1, side / 32);
+    for (uint64_t h = 0; h < nHighways; h++) {
+        const bool horizontal = h % 2 == 0;
+        const double length = horizontal ? box.lengthX() : box.lengthY();
+        const double width = horizontal ? box.lengthY() : box.lengthX();
+        double along = 0;
+        double across = uniform(generator, 0.1, 0.9) * width;
+        while (along < length) {
+            const double nextAlong = std::min(length, along + uniform(generator, 0.05, 0.15) * length);
+            const double nextAcross = std::min(std::max(across + uniform(generator, -0.05, 0.05) * width, 0.0), width);
+            if (horizontal) {
+                segments.push_back(cg3::Segment2d(box.min() + cg3::Point2d(along, across), box.min() + cg3::Point2d(nextAlong, nextAcross)));
+            }
+            else {
+                segments.push_back(cg3::Segment2d(box.min() + cg3::Point2d(across, along), box.min() + cg3::Point2d(nextAcross, nextAlong)));
+            }
+            along = nextAlong;
+            across = nextAcross;
+        }
+    }
+
+    // The highways are split where they cross the streets and each other, on the grid of the text files
+    std::vector<cg3::Segment2d> pieces;
+    std::vector<size_t> origins;
+    std::vector<cg3::Point2d> intersectionPoints;
+    SegmentIntersections::nodeSegments(segments, pieces, origins, intersectionPoints, std::pow(10.0, -DECIMALS));
+    return pieces;
+}
+
+}
+
+std::vector<cg3::Segment2d> generateSegments(SegmentShape shape, size_t n, const cg3::BoundingBox2& box, uint64_t seed) {
+    if (n == 0) {
+        return std::vector<cg3::Segment2d>();
+    }
+    std::mt19937_64 generator(seed);
+
+    std::vector<cg3::Segment2d> segments;
+    switch (shape) {
+    case UNIFORM:
+        segments = SegmentGenerator::randomNonIntersectingSegments(n, box, generator());
+        break;
+    case CLUSTERED:
+        segments = clusteredSegments(n, box, generator);
+        break;
+    case LONG_THIN:
+        segments = longThinSegments(n, box, generator);
+        break;
+    case NEAR_VERTICAL:
+        segments = nearVerticalSegments(n, box, generator);
+        break;
+    case GRID:
+        segments = gridSegments(n, box, generator);
+        break;
+    case ROADS:
+        segments = roadSegments(n, box, generator);
+        break;
+    default:
+        break;
+    }
+    return finalizeSegments(segments, generator);
+}
+
+std::vector<cg3::Point2d> generateQueries(
+        QueryDistribution distribution,
+        size_t n,
+        const cg3::BoundingBox2& box,
+        const std::vector<cg3::Segment2d>& segments,
+        uint64_t seed)
+{
+    std::mt19937_64 generator(seed);
+    if (distribution == NEAR_SEGMENT_QUERIES && segments.empty()) {
+        distribution = UNIFORM_QUERIES;
+    }
+
+    // The clusters of the queries
+    const size_t nCenters = 16;
+    std::vector<cg3::Point2d> centers(nCenters);
+    std::vector<double> deviations(nCenters);
+    if (distribution == CLUSTERED_QUERIES) {
+        for (size_t i = 0; i < nCenters; i++) {
+            centers[i].setXCoord(uniform(generator, box.min().x(), box.max().x()));
+            centers[i].setYCoord(uniform(generator, box.min().y(), box.max().y()));
+            deviations[i] = uniform(generator, 0.25, 1.25) * std::min(box.lengthX(), box.lengthY()) / 64;
+        }
+    }
+
+    // The step of the walks: a fraction of the average distance between the segments
+    const double step = std::sqrt(box.lengthX() * box.lengthY() / static_cast<double>(segments.size() + 1)) / 4;
+    cg3::Point2d position;
+    double heading = 0;
+
+    std::vector<cg3::Point2d> queries;
+    queries.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        cg3::Point2d q;
+        switch (distribution) {
+        case CLUSTERED_QUERIES: {
+            const size_t center = SegmentGenerator::randomBelow(generator, nCenters);
+            q.setXCoord(centers[center].x() + gaussian(generator) * deviations[center]);
+            q.setYCoord(centers[center].y() + gaussian(generator) * deviations[center]);
+            break;
+        }
+        case NEAR_SEGMENT_QUERIES: {
+            const cg3::Segment2d& segment = segments[SegmentGenerator::randomBelow(generator, segments.size())];
+            const cg3::Point2d endpoint = SegmentGenerator::randomBelow(generator, 2) == 0 ? segment.p1() : segment.p2();
+            const double distance = std::pow(10.0, uniform(generator, -DECIMALS, 2));
+            const double sign = SegmentGenerator::randomBelow(generator, 2) == 0 ? -1 : 1;
+            const cg3::Point2d direction = segment.p2() - segment.p1();
+            const cg3::Point2d normal = cg3::Point2d(-direction.y(), direction.x()) / std::hypot(direction.x(), direction.y());
+            const cg3::Point2d onSegment = segment.p1() + direction * SegmentGenerator::randomUnit(generator);
+
+            // An endpoint, a point above or below it, a point on the segment or close to it
+            switch (SegmentGenerator::randomBelow(generator, 4)) {
+            case 0:
+                q = endpoint;
+                break;
+            case 1:
+                q = endpoint + cg3::Point2d(0, sign * distance);
+                break;
+            case 2:
+                q = onSegment;
+                break;
+            default:
+                q = onSegment + normal * (sign * distance);
+                break;
+            }
+            break;
+        }
+        case WALK_QUERIES: {
+            if (i % WALK_LENGTH == 0) {
+                position.setXCoord(uniform(generator, box.min().x(), box.max().x()));
+                position.setYCoord(uniform(generator, box.min().y(), box.max().y()));
+                heading = uniform(generator, 0, 2 * PI);
+            }
+            else {
+                heading += uniform(generator, -0.25, 0.25);
+                position += cg3::Point2d(std::cos(heading), std::sin(heading)) * (step * uniform(generator, 0.5, 1.5));
+
+                // The walk bounces on the sides of the box
+                if (position.x() < box.min().x() || position.x() > box.max().x()) {
+                    position.setXCoord(position.x() < box.min().x() ? 2 * box.min().x() - position.x() : 2 * box.max().x() - position.x());
+                    heading = PI - heading;
+                }
+                if (position.y() < box.min().y() || position.y() > box.max().y()) {
+                    position.setYCoord(position.y() < box.min().y() ? 2 * box.min().y() - position.y() : 2 * box.max().y() - position.y());
+                    heading = -heading;
+                }
+            }
+            q = position;
+            break;
+        }
+        default:
+            q.setXCoord(uniform(generator, box.min().x(), box.max().x()));
+            q.setYCoord(uniform(generator, box.min().y(), box.max().y()));
+            break;
+        }
+        queries.push_back(roundPoint(clampPoint(q, box)));
+    }
+    return queries;
+}
+
+void sortByX(std::vector<cg3::Segment2d>& segments) {
+    std::stable_sort(segments.begin(), segments.end(), [](const cg3::Segment2d& a, const cg3::Segment2d& b) {
+        return std::min(a.p1(), a.p2()) < std::min(b.p1(), b.p2());
+    });
+}
+
+const char* getShapeName(SegmentShape shape) {
+    return shape < N_SEGMENT_SHAPES ? SHAPE_NAMES[shape] : "";
+}
+
+const char* getDistributionName(QueryDistribution distribution) {
+    return distribution < N_QUERY_DISTRIBUTIONS ? DISTRIBUTION_NAMES[distribution] : "";
+}
+
+bool parseShape(const std::string& name, SegmentShape& shape) {
+    for (int i = 0; i < N_SEGMENT_SHAPES; i++) {
+        if (name == SHAPE_NAMES[i]) {
+            shape = static_cast<SegmentShape>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseDistribution(const std::string& name, QueryDistribution& distribution) {
+    for (int i = 0; i < N_QUERY_DISTRIBUTIONS; i++) {
+        if (name == DISTRIBUTION_NAMES[i]) {
+            distribution = static_cast<QueryDistribution>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,84 @@
+#ifndef WORKLOADGENERATOR_H
+#define WORKLOADGENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cg3/geometry/bounding_box2.h>
+#include <cg3/geometry/point2.h>
+#include <cg3/geometry/segment2.h>
+
+/* Generation of benchmark workloads: sets of non-intersecting segments with the shapes found in real data, and query points
+ * with different distributions. The random numbers come from SegmentGenerator::randomUnit and randomBelow, which don't depend
+ * on the platform, and the coordinates are rounded to DECIMALS digits, so a seed gives the same workload everywhere (unless
+ * std::sin or std::log differ in the last bit just across a rounding boundary). */
+namespace WorkloadGenerator {
+
+// The shapes of the segment sets
+enum SegmentShape {UNIFORM, CLUSTERED, LONG_THIN, NEAR_VERTICAL, GRID, ROADS, N_SEGMENT_SHAPES};
+
+// The distributions of the query points
+enum QueryDistribution {UNIFORM_QUERIES, CLUSTERED_QUERIES, NEAR_SEGMENT_QUERIES, WALK_QUERIES, N_QUERY_DISTRIBUTIONS};
+
+// The coordinates are rounded to DECIMALS decimal digits, the precision of the text files (see FileUtils::saveSegmentsInFile),
+// so the text and the binary files of a workload contain the same numbers
+const int DECIMALS = 4;
+
+// Number of consecutive queries of a walk
+const size_t WALK_LENGTH = 1000;
+
+/**
+ * @brief generateSegments  generates a set of segments which don't intersect each other (they may share an endpoint), in random order:
+ *                          - UNIFORM: short segments spread on the whole box (see SegmentGenerator::randomNonIntersectingSegments);
+ *                          - CLUSTERED: dense clusters of very different sizes and densities, with empty space among them;
+ *                          - LONG_THIN: long, almost horizontal segments stacked on top of each other, making long and thin trapezoids;
+ *                          - NEAR_VERTICAL: almost vertical segments in columns, some of them exactly vertical;
+ *                          - GRID: the edges of a regular lattice, with many shared endpoints and x-coordinates;
+ *                          - ROADS: a street network (a jittered lattice, denser in the middle, with missing edges and some diagonals)
+ *                            crossed by a few long highways, split at the crossings (see SegmentIntersections::nodeSegments).
+ *                          The number of segments may be slightly different from n: the ROADS set contains the pieces of the highways,
+ *                          and the segments that rounding made intersect (very rare) are discarded.
+ * @param shape             the shape of the set.
+ * @param n                 the number of segments.
+ * @param box               the box containing the segments.
+ * @param seed              the seed of the generator.
+ * @return                  the segments.
+ */
+std::vector<cg3::Segment2d> generateSegments(SegmentShape shape, size_t n, const cg3::BoundingBox2& box, uint64_t seed);
+
+/**
+ * @brief generateQueries   generates query points inside a box:
+ *                          - UNIFORM_QUERIES: uniformly distributed;
+ *                          - CLUSTERED_QUERIES: gaussian clusters around a few centers;
+ *                          - NEAR_SEGMENT_QUERIES: on the segments, at their endpoints or very close to them (at distances from
+ *                            10^-DECIMALS to about 100), where the orientation tests are hardest;
+ *                          - WALK_QUERIES: random walks of WALK_LENGTH small steps, so consecutive queries are close to each other.
+ * @param distribution      the distribution of the points.
+ * @param n                 the number of points.
+ * @param box               the box containing the points.
+ * @param segments          the segments (used by NEAR_SEGMENT_QUERIES: without segments, the points are uniformly distributed).
+ * @param seed              the seed of the generator.
+ * @return                  the points.
+ */
+std::vector<cg3::Point2d> generateQueries(
+        QueryDistribution distribution,
+        size_t n,
+        const cg3::BoundingBox2& box,
+        const std::vector<cg3::Segment2d>& segments,
+        uint64_t seed);
+
+// Sorts the segments by their leftmost endpoint: an adversarial insertion order for the randomized incremental construction
+void sortByX(std::vector<cg3::Segment2d>& segments);
+
+// The names of the shapes and of the distributions (used on the command line)
+const char* getShapeName(SegmentShape shape);
+const char* getDistributionName(QueryDistribution distribution);
+
+// Return false if the name is unknown
+bool parseShape(const std::string& name, SegmentShape& shape);
+bool parseDistribution(const std::string& name, QueryDistribution& distribution);
+
+}
+
+#endif // WORKLOADGENERATOR_H
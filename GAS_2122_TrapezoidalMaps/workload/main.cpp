@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "utils/fileutils.h"
+#include "utils/workloadgenerator.h"
+
+// Same bounding box used by the manager of the application (the workloads stay 1 unit inside it)
+#define BOUNDINGBOX 1e+6
+
+// Number of queries of each distribution when it is not specified
+#define DEFAULT_N_QUERIES 100000
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// returns the milliseconds elapsed since the given instant
+double elapsedMilliseconds(const Clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// prints the usage, with the names of the shapes and of the distributions
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <shape> <number of segments> <output prefix> [-q <number of queries>] [-d <distribution>]..." << std::endl
+              << "       [-f text|binary|both] [-s] [-S <seed>]" << std::endl
+              << "    shapes:        ";
+    for(int i = 0; i < WorkloadGenerator::N_SEGMENT_SHAPES; i++)
+        std::cerr << WorkloadGenerator::getShapeName(static_cast<WorkloadGenerator::SegmentShape>(i)) << " ";
+    std::cerr << std::endl
+              << "    distributions: ";
+    for(int i = 0; i < WorkloadGenerator::N_QUERY_DISTRIBUTIONS; i++)
+        std::cerr << WorkloadGenerator::getDistributionName(static_cast<WorkloadGenerator::QueryDistribution>(i)) << " ";
+    std::cerr << std::endl
+              << "    -q    number of queries of each distribution (default " << DEFAULT_N_QUERIES << ", 0 for no queries)" << std::endl
+              << "    -d    generate only the queries of this distribution (default all of them)" << std::endl
+              << "    -f    format of the files (default both): <prefix>.txt and <prefix>.bin for the segments," << std::endl
+              << "          <prefix>_<distribution>.txt and <prefix>_<distribution>.bin for the queries" << std::endl
+              << "    -s    save the segments sorted from left to right (an adversarial insertion order)" << std::endl
+              << "    -S    seed of the generator (default 1): the same seed gives the same files" << std::endl;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 4) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parsing the arguments
+    WorkloadGenerator::SegmentShape shape;
+    if(!WorkloadGenerator::parseShape(argv[1], shape)) {
+        std::cerr << "Unknown shape: " << argv[1] << std::endl;
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const size_t nSegments = std::strtoul(argv[2], nullptr, 10);
+    const std::string prefix = argv[3];
+
+    size_t nQueries = DEFAULT_N_QUERIES;
+    std::vector<WorkloadGenerator::QueryDistribution> distributions;
+    bool text = true;
+    bool binary = true;
+    bool sorted = false;
+    unsigned long long seed = 1;
+    for(int i = 4; i < argc; i++) {
+        const std::string argument = argv[i];
+        if(argument == "-q" && i + 1 < argc)
+            nQueries = std::strtoul(argv[++i], nullptr, 10);
+        else if(argument == "-d" && i + 1 < argc) {
+            WorkloadGenerator::QueryDistribution distribution;
+            if(!WorkloadGenerator::parseDistribution(argv[++i], distribution)) {
+                std::cerr << "Unknown distribution: " << argv[i] << std::endl;
+                return EXIT_FAILURE;
+            }
+            distributions.push_back(distribution);
+        }
+        else if(argument == "-f" && i + 1 < argc) {
+            const std::string format = argv[++i];
+            text = format == "text" || format == "both";
+            binary = format == "binary" || format == "both";
+            if(!text && !binary) {
+                std::cerr << "Unknown format: " << format << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if(argument == "-s")
+            sorted = true;
+        else if(argument == "-S" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else {
+            std::cerr << "Unknown argument: " << argument << std::endl;
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if(distributions.empty()) {
+        for(int i = 0; i < WorkloadGenerator::N_QUERY_DISTRIBUTIONS; i++)
+            distributions.push_back(static_cast<WorkloadGenerator::QueryDistribution>(i));
+    }
+
+    const cg3::BoundingBox2 box(cg3::Point2d(-BOUNDINGBOX + 1, -BOUNDINGBOX + 1), cg3::Point2d(BOUNDINGBOX - 1, BOUNDINGBOX - 1));
+
+    // The segments
+    Clock::time_point start = Clock::now();
+    std::vector<cg3::Segment2d> segments = WorkloadGenerator::generateSegments(shape, nSegments, box, seed);
+    if(sorted)
+        WorkloadGenerator::sortByX(segments);
+    std::cout << segments.size() << " " << WorkloadGenerator::getShapeName(shape) << " segments generated in "
+              << elapsedMilliseconds(start) << " ms" << std::endl;
+
+    if(text)
+        FileUtils::saveSegmentsInFile(prefix + ".txt", segments);
+    if(binary)
+        FileUtils::saveSegmentsInBinaryFile(prefix + ".bin", segments);
+
+    // The queries: each distribution has its own seed, so the queries don't change when the other distributions are not generated
+    if(nQueries == 0)
+        return EXIT_SUCCESS;
+    for(WorkloadGenerator::QueryDistribution distribution : distributions) {
+        const std::string name = WorkloadGenerator::getDistributionName(distribution);
+        start = Clock::now();
+        const std::vector<cg3::Point2d> queries =
+                WorkloadGenerator::generateQueries(distribution, nQueries, box, segments, seed + 1 + distribution);
+        std::cout << queries.size() << " " << name << " queries generated in " << elapsedMilliseconds(start) << " ms" << std::endl;
+
+        if(text)
+            FileUtils::savePointsInFile(prefix + "_" + name + ".txt", queries);
+        if(binary)
+            FileUtils::savePointsInBinaryFile(prefix + "_" + name + ".bin", queries);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,20 @@
+# Command-line generator of benchmark workloads: segment sets and query points, in text and binary files.
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= qt app_bundle
+
+# Release configuration
+CONFIG(release, debug|release){
+    QMAKE_CXXFLAGS_RELEASE -= -O2
+    QMAKE_CXXFLAGS += -O3 -DNDEBUG
+}
+
+# Only the core of cg3lib is needed
+CONFIG += CG3_CORE
+include (../cg3lib/cg3.pri)
+
+# The core of the trapezoidal map (no Qt, no OpenGL)
+include (../trapezoidalmap_core.pri)
+
+SOURCES += \
+    main.cpp